@@ -0,0 +1,223 @@
+//! Benchmarks for the latency of each stage of a module's lifecycle —
+//! compile, serialize, deserialize, load and instantiate — over a corpus of
+//! representative modules.
+//!
+//! The corpus is generated deterministically with `wasm-encoder`, so the
+//! numbers are comparable across runs and machines without checking in
+//! binary module files.
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion};
+use wasmer::*;
+use wasmer_engine_universal::UniversalExecutableRef;
+
+/// Knobs for the shape of a corpus module.
+struct CorpusModule {
+    /// Number of local functions.
+    functions: u32,
+    /// Number of arithmetic steps in each function body.
+    body_steps: u32,
+    /// Active data segments, as `(count, bytes each)`.
+    data_segments: (u32, u32),
+    /// Entries in the funcref table, filled by active element segments.
+    table_entries: u32,
+}
+
+impl CorpusModule {
+    fn make(&self) -> Vec<u8> {
+        use wasm_encoder::{
+            CodeSection, DataSection, ElementSection, Elements, Export, ExportSection, Function,
+            FunctionSection, Instruction, MemorySection, MemoryType, Module, TableSection,
+            TableType, TypeSection, ValType,
+        };
+        assert!(self.functions >= 1);
+
+        let mut module = Module::new();
+
+        let mut type_section = TypeSection::new();
+        type_section.function([], []);
+        module.section(&type_section);
+
+        let mut functions_section = FunctionSection::new();
+        for _ in 0..self.functions {
+            functions_section.function(0);
+        }
+        module.section(&functions_section);
+
+        if self.table_entries != 0 {
+            let mut table_section = TableSection::new();
+            table_section.table(TableType {
+                element_type: ValType::FuncRef,
+                minimum: self.table_entries,
+                maximum: Some(self.table_entries),
+            });
+            module.section(&table_section);
+        }
+
+        let (segment_count, segment_len) = self.data_segments;
+        let mut memory_section = MemorySection::new();
+        let data_len = u64::from(segment_count) * u64::from(segment_len);
+        memory_section.memory(MemoryType {
+            minimum: data_len / 0x10000 + 1,
+            maximum: None,
+            memory64: false,
+        });
+        module.section(&memory_section);
+
+        let mut exports_section = ExportSection::new();
+        exports_section.export("main", Export::Function(0));
+        module.section(&exports_section);
+
+        if self.table_entries != 0 {
+            let mut element_section = ElementSection::new();
+            // Fill the table with repeating references to the local
+            // functions, one segment per 1000 entries.
+            let funcs = (0..self.table_entries)
+                .map(|i| i % self.functions)
+                .collect::<Vec<u32>>();
+            for (i, chunk) in funcs.chunks(1000).enumerate() {
+                element_section.active(
+                    None,
+                    &Instruction::I32Const(i as i32 * 1000),
+                    ValType::FuncRef,
+                    Elements::Functions(chunk),
+                );
+            }
+            module.section(&element_section);
+        }
+
+        let mut code_section = CodeSection::new();
+        for func in 0..self.functions {
+            let mut f = Function::new([(4, ValType::I32)]);
+            f.instruction(&Instruction::I32Const(func as i32));
+            for step in 0..self.body_steps {
+                f.instruction(&Instruction::I32Const(step as i32));
+                f.instruction(&Instruction::I32Add);
+                f.instruction(&Instruction::LocalTee(step % 4));
+                f.instruction(&Instruction::LocalGet((step + 1) % 4));
+                f.instruction(&Instruction::I32Xor);
+            }
+            f.instruction(&Instruction::Drop);
+            f.instruction(&Instruction::End);
+            code_section.function(&f);
+        }
+        module.section(&code_section);
+
+        if segment_count != 0 {
+            let mut data_section = DataSection::new();
+            for i in 0..segment_count {
+                let bytes = (0..segment_len).map(|j| (i + j) as u8);
+                data_section.active(0, &Instruction::I32Const((i * segment_len) as i32), bytes);
+            }
+            module.section(&data_section);
+        }
+
+        module.finish()
+    }
+}
+
+/// The corpus: small, medium and large code sections, a module dominated by
+/// data segments and one dominated by a funcref table.
+fn corpus() -> Vec<(&'static str, Vec<u8>)> {
+    let shapes = vec![
+        (
+            "code_small",
+            CorpusModule {
+                functions: 10,
+                body_steps: 20,
+                data_segments: (0, 0),
+                table_entries: 0,
+            },
+        ),
+        (
+            "code_medium",
+            CorpusModule {
+                functions: 300,
+                body_steps: 100,
+                data_segments: (0, 0),
+                table_entries: 0,
+            },
+        ),
+        (
+            "code_large",
+            CorpusModule {
+                functions: 3000,
+                body_steps: 200,
+                data_segments: (0, 0),
+                table_entries: 0,
+            },
+        ),
+        (
+            "data_heavy",
+            CorpusModule {
+                functions: 10,
+                body_steps: 20,
+                data_segments: (256, 4096),
+                table_entries: 0,
+            },
+        ),
+        (
+            "table_heavy",
+            CorpusModule {
+                functions: 16,
+                body_steps: 20,
+                data_segments: (0, 0),
+                table_entries: 10_000,
+            },
+        ),
+    ];
+    shapes
+        .into_iter()
+        .map(|(name, shape)| (name, shape.make()))
+        .collect()
+}
+
+fn module_lifecycle(c: &mut Criterion) {
+    for (name, wasm) in corpus() {
+        let store = Store::new(&Universal::new(Singlepass::new()).engine());
+        let mut group = c.benchmark_group(name);
+
+        group.bench_function("compile", |b| {
+            b.iter(|| {
+                black_box(store.engine().compile(&wasm, store.tunables()).unwrap());
+            })
+        });
+
+        let executable = store.engine().compile(&wasm, store.tunables()).unwrap();
+        group.bench_function("serialize", |b| {
+            b.iter(|| {
+                black_box(executable.serialize().unwrap());
+            })
+        });
+
+        let serialized = executable.serialize().unwrap();
+        group.bench_function("deserialize", |b| {
+            b.iter(|| unsafe {
+                black_box(UniversalExecutableRef::deserialize(&serialized).unwrap());
+            })
+        });
+
+        group.bench_function("load", |b| {
+            b.iter(|| unsafe {
+                let deserialized = UniversalExecutableRef::deserialize(&serialized).unwrap();
+                black_box(store.engine().load(&deserialized).unwrap());
+            })
+        });
+
+        let module = Module::new(&store, &wasm).unwrap();
+        group.bench_function("instantiate", |b| {
+            b.iter(|| {
+                black_box(Instance::new(&module, &imports! {}).unwrap());
+            })
+        });
+
+        group.finish();
+    }
+}
+
+criterion_group! {
+    name = lifecycle;
+    config = Criterion::default();
+    targets = module_lifecycle
+}
+
+criterion_main!(lifecycle);
@@ -18,6 +18,11 @@ use wasmer_vm::{
     VMFunctionKind, VMTrampoline,
 };
 
+/// How many value slots the trampoline argument buffer keeps on the stack
+/// before falling back to a heap allocation. Covers the argument and result
+/// counts of virtually all functions called through [`Function::call`].
+const INLINE_VALUES: usize = 8;
+
 /// A WebAssembly `function` instance.
 ///
 /// A function instance is the runtime representation of a function.
@@ -464,11 +469,22 @@ impl Function {
             )));
         }
 
-        let mut values_vec = vec![0; max(params.len(), results.len())];
+        // Almost every call has few enough parameters and results to fit the
+        // inline buffer, so the common path never touches the allocator;
+        // larger signatures fall back to a heap buffer.
+        let value_count = max(params.len(), results.len());
+        let mut inline_values = [0i128; INLINE_VALUES];
+        let mut heap_values = vec![];
+        let values_vec: &mut [i128] = if value_count <= INLINE_VALUES {
+            &mut inline_values[..value_count]
+        } else {
+            heap_values.resize(value_count, 0);
+            &mut heap_values
+        };
 
         // Store the argument values into `values_vec`.
         let param_tys = signature.params().iter();
-        for ((arg, slot), ty) in params.iter().zip(&mut values_vec).zip(param_tys) {
+        for ((arg, slot), ty) in params.iter().zip(values_vec.iter_mut()).zip(param_tys) {
             if arg.ty() != *ty {
                 let param_types = format_types_for_error_message(params);
                 return Err(RuntimeError::new(format!(
@@ -596,6 +612,74 @@ impl Function {
         }
     }
 
+    /// Call the `Function` function, writing the results into caller-provided
+    /// storage instead of allocating a fresh boxed slice per call.
+    ///
+    /// `results` must hold exactly [`result_arity`](Self::result_arity)
+    /// values; their previous contents are overwritten. Combined with the
+    /// inline argument buffer used by the trampoline, calling a function
+    /// defined in WebAssembly this way performs no heap allocation for up to
+    /// eight parameters and results.
+    ///
+    /// # Examples
+    ///
+    /// ```
+    /// # use wasmer::{imports, wat2wasm, Function, Instance, Module, Store, Type, Value};
+    /// # let store = Store::default();
+    /// # let wasm_bytes = wat2wasm(r#"
+    /// # (module
+    /// #   (func (export "sum") (param $x i32) (param $y i32) (result i32)
+    /// #     local.get $x
+    /// #     local.get $y
+    /// #     i32.add
+    /// #   ))
+    /// # "#.as_bytes()).unwrap();
+    /// # let module = Module::new(&store, wasm_bytes).unwrap();
+    /// # let import_object = imports! {};
+    /// # let instance = Instance::new(&module, &import_object).unwrap();
+    /// #
+    /// let sum = instance.lookup_function("sum").unwrap();
+    /// let mut results = [Value::null()];
+    ///
+    /// sum.call_with_results_into(&[Value::I32(1), Value::I32(2)], &mut results).unwrap();
+    /// assert_eq!(results[0], Value::I32(3));
+    /// ```
+    pub fn call_with_results_into(
+        &self,
+        params: &[Val],
+        results: &mut [Val],
+    ) -> Result<(), RuntimeError> {
+        // If it's a function defined in the Wasm, it will always have a call_trampoline
+        if let Some(trampoline) = self.exported.vm_function.call_trampoline {
+            return self.call_wasm(trampoline, params, results);
+        }
+
+        // If it's a function defined in the host
+        match self.exported.vm_function.kind {
+            VMFunctionKind::Dynamic => unsafe {
+                type VMContextWithEnv = VMDynamicFunctionContext<DynamicFunction<std::ffi::c_void>>;
+                let ctx = self.exported.vm_function.vmctx.host_env as *mut VMContextWithEnv;
+                let returned = (*ctx).ctx.call(&params)?;
+                if returned.len() != results.len() {
+                    return Err(RuntimeError::new(format!(
+                        "Results of length {} did not match the function's {} results",
+                        results.len(),
+                        returned.len(),
+                    )));
+                }
+                for (slot, value) in results.iter_mut().zip(returned) {
+                    *slot = value;
+                }
+                Ok(())
+            },
+            VMFunctionKind::Static => {
+                unimplemented!(
+                    "Native function definitions can't be directly called from the host yet"
+                );
+            }
+        }
+    }
+
     pub(crate) fn from_vm_export(store: &Store, wasmer_export: ExportFunction) -> Self {
         Self {
             store: store.clone(),
@@ -33,7 +33,7 @@ pub use crate::sys::module::Module;
 pub use crate::sys::native::NativeFunc;
 pub use crate::sys::ptr::{Array, Item, WasmPtr};
 pub use crate::sys::store::{Store, StoreObject};
-pub use crate::sys::tunables::BaseTunables;
+pub use crate::sys::tunables::{BaseTunables, PooledMemoryTunables};
 pub use crate::sys::types::{
     ExportType, ExternType, FunctionType, GlobalType, MemoryType, Mutability, TableType, Val,
     ValType,
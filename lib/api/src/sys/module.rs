@@ -47,8 +47,8 @@ impl Module {
     ///
     /// ## Security
     ///
-    /// Before the code is compiled, it will be validated using the store
-    /// features.
+    /// The code is validated against the store features while it is being
+    /// compiled.
     ///
     /// ## Errors
     ///
@@ -115,7 +115,8 @@ impl Module {
     /// the WebAssembly text format (if the "wat" feature is enabled for
     /// this crate).
     pub(crate) fn from_binary(store: &Store, binary: &[u8]) -> Result<Self, CompileError> {
-        store.engine().validate(binary)?;
+        // No separate validation pass: the engine validates the binary while
+        // compiling it.
         let module = {
             let executable = store.engine().compile(binary, store.tunables())?;
             let artifact = store.engine().load(&*executable)?;
@@ -133,6 +134,16 @@ impl Module {
         Ok(module)
     }
 
+    /// Creates a new WebAssembly module from an artifact that was already
+    /// loaded into the store's engine, for example through
+    /// `UniversalEngine::load_universal_executable_file`.
+    pub fn from_artifact(store: &Store, artifact: Arc<UniversalArtifact>) -> Self {
+        Self {
+            store: store.clone(),
+            artifact,
+        }
+    }
+
     pub(crate) fn instantiate(
         &self,
         resolver: &dyn Resolver,
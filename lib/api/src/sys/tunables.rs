@@ -5,7 +5,7 @@ use target_lexicon::PointerWidth;
 use wasmer_compiler::Target;
 use wasmer_vm::MemoryError;
 use wasmer_vm::{
-    LinearMemory, LinearTable, Memory, MemoryStyle, Table, TableStyle, Tunables,
+    LinearMemory, LinearTable, Memory, MemoryPool, MemoryStyle, Table, TableStyle, Tunables,
     VMMemoryDefinition, VMTableDefinition,
 };
 
@@ -27,6 +27,10 @@ pub struct BaseTunables {
 
     /// The size in bytes of the offset guard for dynamic heaps.
     pub dynamic_memory_offset_guard_size: u64,
+
+    /// Whether to ask the OS to back static heaps with huge pages, to cut
+    /// dTLB pressure on hosts configured for it. Off by default.
+    pub static_memory_huge_pages: bool,
 }
 
 impl BaseTunables {
@@ -61,6 +65,7 @@ impl BaseTunables {
             static_memory_bound,
             static_memory_offset_guard_size,
             dynamic_memory_offset_guard_size,
+            static_memory_huge_pages: false,
         }
     }
 }
@@ -78,6 +83,7 @@ impl Tunables for BaseTunables {
                 // Bound can be larger than the maximum for performance reasons
                 bound: self.static_memory_bound,
                 offset_guard_size: self.static_memory_offset_guard_size,
+                huge_pages: self.static_memory_huge_pages,
             }
         } else {
             MemoryStyle::Dynamic {
@@ -146,6 +152,86 @@ impl Tunables for BaseTunables {
     }
 }
 
+/// A [`Tunables`] implementation that hands out linear memories from a fixed
+/// pool of preallocated reservations instead of mmapping a fresh region per
+/// instance.
+///
+/// Memories with the pool's static style draw their reservation from the
+/// pool and return it — reset with `madvise(MADV_DONTNEED)` rather than
+/// unmapped — when dropped. Everything else, including instantiation while
+/// the pool is exhausted, behaves exactly like [`BaseTunables`].
+///
+/// Opt in with [`Store::new_with_tunables`](crate::Store::new_with_tunables).
+pub struct PooledMemoryTunables {
+    base: BaseTunables,
+    pool: MemoryPool,
+}
+
+impl PooledMemoryTunables {
+    /// Get the `PooledMemoryTunables` for a specific Target, with a pool of
+    /// `capacity` linear-memory reservations sized for the target's static
+    /// memory style.
+    pub fn for_target(target: &Target, capacity: usize) -> Result<Self, MemoryError> {
+        let base = BaseTunables::for_target(target);
+        let style = MemoryStyle::Static {
+            bound: base.static_memory_bound,
+            offset_guard_size: base.static_memory_offset_guard_size,
+            huge_pages: base.static_memory_huge_pages,
+        };
+        let pool = MemoryPool::new(capacity, &style)?;
+        Ok(Self { base, pool })
+    }
+}
+
+impl Tunables for PooledMemoryTunables {
+    fn memory_style(&self, memory: &MemoryType) -> MemoryStyle {
+        self.base.memory_style(memory)
+    }
+
+    fn table_style(&self, table: &TableType) -> TableStyle {
+        self.base.table_style(table)
+    }
+
+    fn create_host_memory(
+        &self,
+        ty: &MemoryType,
+        style: &MemoryStyle,
+    ) -> Result<Arc<dyn Memory>, MemoryError> {
+        Ok(Arc::new(LinearMemory::new_pooled(&ty, &style, &self.pool)?))
+    }
+
+    unsafe fn create_vm_memory(
+        &self,
+        ty: &MemoryType,
+        style: &MemoryStyle,
+        vm_definition_location: NonNull<VMMemoryDefinition>,
+    ) -> Result<Arc<dyn Memory>, MemoryError> {
+        Ok(Arc::new(LinearMemory::from_definition_pooled(
+            &ty,
+            &style,
+            vm_definition_location,
+            &self.pool,
+        )?))
+    }
+
+    fn create_host_table(
+        &self,
+        ty: &TableType,
+        style: &TableStyle,
+    ) -> Result<Arc<dyn Table>, String> {
+        self.base.create_host_table(ty, style)
+    }
+
+    unsafe fn create_vm_table(
+        &self,
+        ty: &TableType,
+        style: &TableStyle,
+        vm_definition_location: NonNull<VMTableDefinition>,
+    ) -> Result<Arc<dyn Table>, String> {
+        self.base.create_vm_table(ty, style, vm_definition_location)
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -156,6 +242,7 @@ mod tests {
             static_memory_bound: Pages(2048),
             static_memory_offset_guard_size: 128,
             dynamic_memory_offset_guard_size: 256,
+            static_memory_huge_pages: false,
         };
 
         // No maximum
@@ -181,6 +268,7 @@ mod tests {
             MemoryStyle::Static {
                 bound,
                 offset_guard_size,
+                ..
             } => {
                 assert_eq!(bound, Pages(2048));
                 assert_eq!(offset_guard_size, 128);
@@ -12,8 +12,8 @@ use wasmer_compiler::wasmparser::{
 use wasmer_compiler::{
     CallingConvention, CompiledFunction, CompiledFunctionFrameInfo, CustomSection,
     CustomSectionProtection, FunctionBody, FunctionBodyData, InstructionAddressMap,
-    ModuleTranslationState, Relocation, RelocationKind, RelocationTarget, SectionBody,
-    SectionIndex, SourceLoc,
+    LazySections, ModuleTranslationState, Relocation, RelocationKind, RelocationTarget,
+    SectionBody, SectionIndex, SourceLoc,
 };
 use wasmer_types::{
     entity::{EntityRef, PrimaryMap, SecondaryMap},
@@ -23,7 +23,9 @@ use wasmer_types::{
     FunctionIndex, GlobalIndex, LocalFunctionIndex, LocalMemoryIndex, MemoryIndex, ModuleInfo,
     SignatureIndex, TableIndex, Type,
 };
-use wasmer_vm::{TableStyle, TrapCode, VMBuiltinFunctionIndex, VMOffsets};
+use wasmer_vm::{
+    libcalls::LibCall, TableStyle, TrapCode, VMBuiltinFunctionIndex, VMOffsets,
+};
 
 type Assembler = VecAssembler<X64Relocation>;
 
@@ -72,6 +74,30 @@ pub(crate) struct FuncGen<'a> {
     /// Metadata about floating point values on the stack.
     fp_stack: Vec<FloatValue>,
 
+    /// Depths in the main value stack at which live `v128` values sit.
+    ///
+    /// `v128` values only ever live in XMM registers (see
+    /// [`Self::push_v128_ret`]), so operations that move stack values around 8
+    /// bytes at a time — most notably native calls, which spill XMM registers
+    /// as 64-bit values — must be rejected while this is non-empty.
+    v128_stack: Vec<usize>,
+
+    /// Mapping from wasm local index to the index of its first local slot.
+    ///
+    /// Only present when the function has `v128` locals, which occupy two
+    /// consecutive 8-byte slots; otherwise locals map to slots one-to-one.
+    local_slots: Option<Vec<u32>>,
+
+    /// Total number of 8-byte local slots, counting `v128` locals twice.
+    local_slot_count: u32,
+
+    /// Gas charged by intrinsic calls since the last control flow boundary
+    /// but not yet emitted (see [`Singlepass::consolidate_gas_charges`]).
+    ///
+    /// Always zero unless gas charge consolidation is enabled. Kept below
+    /// `i32::MAX` so that it remains a valid gas intrinsic argument.
+    pending_gas: u64,
+
     /// A list of frames describing the current control stack.
     control_stack: Vec<ControlFrame>,
 
@@ -109,6 +135,7 @@ struct SpecialLabelSet {
     bad_signature: DynamicLabel,
     gas_limit_exceeded: DynamicLabel,
     stack_overflow: DynamicLabel,
+    epoch_deadline_exceeded: DynamicLabel,
 }
 
 /// Metadata about a floating-point value.
@@ -294,6 +321,185 @@ impl<'a> FuncGen<'a> {
         I2O1 { loc_a, loc_b, ret }
     }
 
+    /// Returns the first local slot backing the given wasm local.
+    fn local_slot(&self, local_index: u32) -> u32 {
+        match &self.local_slots {
+            Some(slots) => slots[local_index as usize],
+            None => local_index,
+        }
+    }
+
+    /// Returns the memory location of a `v128` local.
+    ///
+    /// Local slots are allocated downwards in memory, so the 16-byte value
+    /// starts at the address of the *second* of the two slots backing the
+    /// local.
+    fn v128_local_location(&self, local_index: u32) -> XMMOrMemory {
+        match self
+            .machine
+            .get_local_location(self.local_slot(local_index) + 1)
+        {
+            Location::Memory(base, disp) => XMMOrMemory::Memory(base, disp),
+            _ => unreachable!("v128 locals are always allocated on the stack"),
+        }
+    }
+
+    /// Acquires an XMM register for a new `v128` value and pushes it onto the
+    /// value stack.
+    ///
+    /// `v128` values always live in XMM registers; the 8-byte memory slots
+    /// used for spilled scalar stack values cannot hold them.
+    fn push_v128_ret(&mut self) -> Result<XMM, CodegenError> {
+        let ret = self
+            .machine
+            .acquire_locations(&mut self.assembler, &[(WpType::V128)], false)[0];
+        match ret {
+            Location::XMM(x) => {
+                self.value_stack.push(ret);
+                self.v128_stack.push(self.value_stack.len() - 1);
+                Ok(x)
+            }
+            _ => Err(CodegenError {
+                message: "v128 operand stack spilling is not implemented".to_string(),
+            }),
+        }
+    }
+
+    /// Pops a `v128` value off the value stack, releasing its XMM register.
+    fn pop_v128(&mut self) -> Result<XMM, CodegenError> {
+        match self.v128_stack.last() {
+            Some(&depth) if depth + 1 == self.value_stack.len() => {
+                self.v128_stack.pop();
+            }
+            _ => {
+                return Err(CodegenError {
+                    message: "pop_v128: value stack top is not a v128".to_string(),
+                })
+            }
+        }
+        match self.pop_value_released() {
+            Location::XMM(x) => Ok(x),
+            _ => Err(CodegenError {
+                message: "pop_v128: v128 value is not in an XMM register".to_string(),
+            }),
+        }
+    }
+
+    /// Prepare and emit a `v128` binary operator backed by a non-destructive
+    /// three-operand AVX instruction.
+    fn emit_binop_v128(
+        &mut self,
+        f: fn(&mut Assembler, XMM, XMMOrMemory, XMM),
+    ) -> Result<(), CodegenError> {
+        let b = self.pop_v128()?;
+        let a = self.pop_v128()?;
+        let ret = self.push_v128_ret()?;
+        f(&mut self.assembler, a, XMMOrMemory::XMM(b), ret);
+        Ok(())
+    }
+
+    /// `v128` integer negation: `0 - x` through the matching packed subtract.
+    fn emit_neg_v128(
+        &mut self,
+        f: fn(&mut Assembler, XMM, XMMOrMemory, XMM),
+    ) -> Result<(), CodegenError> {
+        let a = self.pop_v128()?;
+        let ret = self.push_v128_ret()?;
+        let zeros = self.machine.acquire_temp_xmm().unwrap();
+        self.assembler
+            .emit_vpxor(zeros, XMMOrMemory::XMM(zeros), zeros);
+        f(&mut self.assembler, zeros, XMMOrMemory::XMM(a), ret);
+        self.machine.release_temp_xmm(zeros);
+        Ok(())
+    }
+
+    /// Moves a scalar into lane 0 of a fresh `v128` stack value.
+    ///
+    /// The caller is responsible for broadcasting lane 0 to the others.
+    fn emit_splat_v128(&mut self, sz: Size, is_float: bool) -> Result<XMM, CodegenError> {
+        let loc = self.pop_value_released();
+        if is_float {
+            self.fp_stack.pop1()?;
+        }
+        let ret = self.push_v128_ret()?;
+        let tmp = self.machine.acquire_temp_gpr().unwrap();
+        self.assembler.emit_mov(sz, loc, Location::GPR(tmp));
+        self.assembler
+            .emit_mov(sz, Location::GPR(tmp), Location::XMM(ret));
+        self.machine.release_temp_gpr(tmp);
+        Ok(ret)
+    }
+
+    /// Extracts an integer lane of a `v128` into a new scalar stack value.
+    fn emit_extract_lane_v128<F: FnOnce(&mut Self, XMM, GPR)>(
+        &mut self,
+        ty: WpType,
+        extract: F,
+    ) -> Result<(), CodegenError> {
+        let v = self.pop_v128()?;
+        let ret = self
+            .machine
+            .acquire_locations(&mut self.assembler, &[(ty)], false)[0];
+        self.value_stack.push(ret);
+        let tmp = self.machine.acquire_temp_gpr().unwrap();
+        extract(self, v, tmp);
+        let sz = if ty == WpType::I64 {
+            Size::S64
+        } else {
+            Size::S32
+        };
+        self.assembler.emit_mov(sz, Location::GPR(tmp), ret);
+        self.machine.release_temp_gpr(tmp);
+        Ok(())
+    }
+
+    /// Replaces one lane of a `v128` with a scalar taken off the value stack.
+    fn emit_replace_lane_v128(
+        &mut self,
+        lane: u8,
+        sz: Size,
+        is_float: bool,
+        insert: fn(&mut Assembler, u8, GPR, XMM),
+    ) -> Result<(), CodegenError> {
+        let scalar = self.pop_value_released();
+        if is_float {
+            self.fp_stack.pop1()?;
+        }
+        let v = self.pop_v128()?;
+        let ret = self.push_v128_ret()?;
+        if ret != v {
+            self.assembler
+                .emit_vmovdqu(XMMOrMemory::XMM(v), XMMOrMemory::XMM(ret));
+        }
+        let tmp = self.machine.acquire_temp_gpr().unwrap();
+        self.assembler.emit_mov(sz, scalar, Location::GPR(tmp));
+        insert(&mut self.assembler, lane, tmp, ret);
+        self.machine.release_temp_gpr(tmp);
+        Ok(())
+    }
+
+    /// Loads a 16-byte constant into an XMM register through a temporary GPR.
+    fn emit_v128_const(&mut self, bytes: &[u8; 16], dst: XMM) {
+        let mut lo = [0u8; 8];
+        let mut hi = [0u8; 8];
+        lo.copy_from_slice(&bytes[0..8]);
+        hi.copy_from_slice(&bytes[8..16]);
+        let tmp = self.machine.acquire_temp_gpr().unwrap();
+        self.assembler.emit_mov(
+            Size::S64,
+            Location::Imm64(u64::from_le_bytes(lo)),
+            Location::GPR(tmp),
+        );
+        self.assembler.emit_vpinsrq(0, tmp, dst);
+        self.assembler.emit_mov(
+            Size::S64,
+            Location::Imm64(u64::from_le_bytes(hi)),
+            Location::GPR(tmp),
+        );
+        self.assembler.emit_vpinsrq(1, tmp, dst);
+        self.machine.release_temp_gpr(tmp);
+    }
+
     fn emit_call(&mut self, function: FunctionIndex) -> Result<(), CodegenError> {
         let sig_index = *self.module.functions.get(function).unwrap();
         let sig = self.module.signatures.get(sig_index).unwrap();
@@ -302,6 +508,12 @@ impl<'a> FuncGen<'a> {
         let return_types: SmallVec<[WpType; 1]> =
             sig.results().iter().cloned().map(type_to_wp_type).collect();
 
+        if param_types.contains(&WpType::V128) || return_types.contains(&WpType::V128) {
+            return Err(CodegenError {
+                message: "v128 is not supported in call signatures".to_string(),
+            });
+        }
+
         let params: SmallVec<[_; 8]> = self
             .value_stack
             .drain(self.value_stack.len() - param_types.len()..)
@@ -334,6 +546,14 @@ impl<'a> FuncGen<'a> {
             return Ok(());
         }
 
+        // The callee may observe (or charge) the gas counter, so any deferred
+        // charges must be settled before entering it.
+        self.flush_gas();
+
+        if self.config.epoch_interruption {
+            self.emit_epoch_check();
+        }
+
         let reloc_at = self.assembler.get_offset().0 + self.assembler.arch_mov64_imm_offset();
         // Imported functions are called through trampolines placed as custom sections.
         let reloc_target = match self.module.import_counts.local_function_index(function) {
@@ -396,12 +616,44 @@ impl<'a> FuncGen<'a> {
             })
         });
         match intrinsic.map(|i| &i.kind) {
-            Some(IntrinsicKind::Gas) => self.emit_gas(params[0]),
+            Some(IntrinsicKind::Gas) => {
+                if self.config.consolidate_gas_charges {
+                    self.defer_gas(params[0]);
+                } else {
+                    self.emit_gas(params[0]);
+                }
+            }
             None => return false,
         }
         return true;
     }
 
+    /// Add a gas charge to the pending total instead of emitting it, to be
+    /// charged in one go at the next control flow boundary (see
+    /// [`Self::flush_gas`]).
+    fn defer_gas(&mut self, count_location: Location) {
+        let count = match count_location {
+            // `Intrinsic::is_params_ok` guarantees the value is below
+            // `i32::MAX`.
+            Location::Imm32(imm) => u64::from(imm),
+            _ => unreachable!("gas charge argument must be a constant"),
+        };
+        if self.pending_gas + count >= i32::MAX as u64 {
+            self.flush_gas();
+        }
+        self.pending_gas += count;
+    }
+
+    /// Emit the consolidated charge for the gas accumulated by
+    /// [`Self::defer_gas`] since the last control flow boundary, if any.
+    fn flush_gas(&mut self) {
+        if self.pending_gas != 0 {
+            let count = self.pending_gas as u32;
+            self.pending_gas = 0;
+            self.emit_gas(Location::Imm32(count));
+        }
+    }
+
     fn emit_gas(&mut self, count_location: Location) {
         let counter_offset = offset_of!(FastGasCounter, burnt_gas) as i32;
         let gas_limit_offset = offset_of!(FastGasCounter, gas_limit) as i32;
@@ -468,6 +720,48 @@ impl<'a> FuncGen<'a> {
         self.machine.release_temp_gpr(count_reg);
     }
 
+    /// Emit a check of the shared epoch counter against this instance's
+    /// deadline, trapping once the deadline has been reached.
+    ///
+    /// Checks are only placed at loop headers and call sites, so
+    /// straight-line code pays nothing; the check itself is two dependent
+    /// loads, a compare against the deadline slot in the `VMContext` and a
+    /// never-taken branch.
+    fn emit_epoch_check(&mut self) {
+        let epoch_reg = self.machine.acquire_temp_gpr().unwrap();
+        // Load the address of the shared epoch counter.
+        self.assembler.emit_mov(
+            Size::S64,
+            Location::Memory(
+                Machine::get_vmctx_reg(),
+                self.vmoffsets.vmctx_epoch_counter_pointer() as i32,
+            ),
+            Location::GPR(epoch_reg),
+        );
+        // Read the current epoch. The host only ever writes the counter with
+        // 8-byte atomic stores, which an aligned 8-byte load observes
+        // consistently.
+        self.assembler.emit_mov(
+            Size::S64,
+            Location::Memory(epoch_reg, 0),
+            Location::GPR(epoch_reg),
+        );
+        // Trap once the deadline is no longer ahead of the epoch.
+        self.assembler.emit_cmp(
+            Size::S64,
+            Location::GPR(epoch_reg),
+            Location::Memory(
+                Machine::get_vmctx_reg(),
+                self.vmoffsets.vmctx_epoch_deadline_begin() as i32,
+            ),
+        );
+        self.assembler.emit_jmp(
+            Condition::BelowEqual,
+            self.special_labels.epoch_deadline_exceeded,
+        );
+        self.machine.release_temp_gpr(epoch_reg);
+    }
+
     fn emit_trap(&mut self, code: TrapCode) {
         let label = self.assembler.get_label();
         self.assembler.emit_label(label);
@@ -1350,7 +1644,6 @@ impl<'a> FuncGen<'a> {
         value_size: usize,
         cb: F,
     ) -> Result<(), CodegenError> {
-        let need_check = true;
         let tmp_addr = self.machine.acquire_temp_gpr().unwrap();
 
         // Reusing `tmp_addr` for temporary indirection here, since it's not used before the last reference to `{base,bound}_loc`.
@@ -1379,12 +1672,58 @@ impl<'a> FuncGen<'a> {
         let tmp_base = self.machine.acquire_temp_gpr().unwrap();
         let tmp_bound = self.machine.acquire_temp_gpr().unwrap();
 
-        // Load base into temporary register.
-        self.assembler
-            .emit_mov(Size::S64, base_loc, Location::GPR(tmp_base));
+        // The exclusive end of the access, relative to the start of the
+        // linear memory.
+        let end_offset = memarg.offset as u64 + value_size as u64;
+        if end_offset <= i32::max_value() as u64 {
+            // Load the 32-bit address; this zero-extends into the full
+            // register.
+            self.assembler
+                .emit_mov(Size::S32, addr, Location::GPR(tmp_bound));
+
+            // Compute the exclusive end of the access in 64 bits. The address
+            // and the offset are both below 2^32, so this cannot overflow and
+            // no carry check is needed.
+            self.assembler.emit_lea(
+                Size::S64,
+                Location::Memory(tmp_bound, end_offset as i32),
+                Location::GPR(tmp_base),
+            );
+
+            // Trap if the end of the access is beyond the current length of
+            // the linear memory. The length is compared directly from the
+            // memory definition, saving a load.
+            self.assembler
+                .emit_cmp(Size::S64, bound_loc, Location::GPR(tmp_base));
+            self.assembler
+                .emit_jmp(Condition::Above, self.special_labels.heap_access_oob);
+
+            // Wasm linear memory -> real memory.
+            self.assembler
+                .emit_add(Size::S64, base_loc, Location::GPR(tmp_bound));
+            if memarg.offset != 0 {
+                self.assembler.emit_lea(
+                    Size::S64,
+                    Location::Memory(tmp_bound, memarg.offset as i32),
+                    Location::GPR(tmp_bound),
+                );
+            }
+            // `base_loc` and `bound_loc` become INVALID here, because
+            // `tmp_addr` might have carried the memory definition pointer.
+            self.assembler.emit_mov(
+                Size::S64,
+                Location::GPR(tmp_bound),
+                Location::GPR(tmp_addr),
+            );
+        } else {
+            // The offset does not fit the addressing displacements of the
+            // fast path above; take the long way through 32-bit arithmetic
+            // with an explicit carry check.
+
+            // Load base into temporary register.
+            self.assembler
+                .emit_mov(Size::S64, base_loc, Location::GPR(tmp_base));
 
-        // Load bound into temporary register, if needed.
-        if need_check {
             self.assembler
                 .emit_mov(Size::S64, bound_loc, Location::GPR(tmp_bound));
 
@@ -1401,16 +1740,14 @@ impl<'a> FuncGen<'a> {
                 Location::MemoryAddTriple(tmp_bound, tmp_base, -(value_size as i32)),
                 Location::GPR(tmp_bound),
             );
-        }
 
-        // Load effective address.
-        // `base_loc` and `bound_loc` becomes INVALID after this line, because `tmp_addr`
-        // might be reused.
-        self.assembler
-            .emit_mov(Size::S32, addr, Location::GPR(tmp_addr));
+            // Load effective address.
+            // `base_loc` and `bound_loc` becomes INVALID after this line, because `tmp_addr`
+            // might be reused.
+            self.assembler
+                .emit_mov(Size::S32, addr, Location::GPR(tmp_addr));
 
-        // Add offset to memory address.
-        if memarg.offset != 0 {
+            // Add offset to memory address.
             self.assembler.emit_add(
                 Size::S32,
                 Location::Imm32(memarg.offset),
@@ -1420,13 +1757,11 @@ impl<'a> FuncGen<'a> {
             // Trap if offset calculation overflowed.
             self.assembler
                 .emit_jmp(Condition::Carry, self.special_labels.heap_access_oob);
-        }
 
-        // Wasm linear memory -> real memory
-        self.assembler
-            .emit_add(Size::S64, Location::GPR(tmp_base), Location::GPR(tmp_addr));
+            // Wasm linear memory -> real memory
+            self.assembler
+                .emit_add(Size::S64, Location::GPR(tmp_base), Location::GPR(tmp_addr));
 
-        if need_check {
             // Trap if the end address of the requested area is above that of the linear memory.
             self.assembler
                 .emit_cmp(Size::S64, Location::GPR(tmp_bound), Location::GPR(tmp_addr));
@@ -1829,8 +2164,8 @@ impl<'a> FuncGen<'a> {
     }
 
     fn emit_function_stack_check(&mut self, enter: bool) {
-        // `local_types` include parameters as well.
-        let depth = self.local_count() as usize
+        // `local_slot_count` includes parameters as well.
+        let depth = self.local_slot_count as usize
             + self.max_stack_depth
             // we add 4 to ensure that deep recursion is prohibited even for local and argument free
             // functions, as they still use stack space for the saved frame base and return address,
@@ -1847,12 +2182,32 @@ impl<'a> FuncGen<'a> {
         self.assembler
             .emit_mov(Size::S64, Location::GPR(GPR::RSP), Location::GPR(GPR::RBP));
 
-        // Initialize locals.
+        // Initialize locals. A `v128` local occupies two consecutive 8-byte
+        // slots; when any is present we build an explicit local-to-slot
+        // mapping and keep every local on the stack.
         let local_count = self.local_count();
+        let has_simd_locals = (0..local_count).any(|i| self.local_type(i) == WpType::V128);
+        if has_simd_locals {
+            let mut slots = Vec::with_capacity(local_count as usize);
+            let mut next_slot = 0u32;
+            for i in 0..local_count {
+                slots.push(next_slot);
+                next_slot += if self.local_type(i) == WpType::V128 {
+                    2
+                } else {
+                    1
+                };
+            }
+            self.local_slots = Some(slots);
+            self.local_slot_count = next_slot;
+        } else {
+            self.local_slot_count = local_count;
+        }
         self.machine.init_locals(
             &mut self.assembler,
-            local_count,
+            self.local_slot_count,
             self.signature.params().len() as u32,
+            has_simd_locals,
             self.calling_convention,
         );
 
@@ -1901,6 +2256,19 @@ impl<'a> FuncGen<'a> {
         let sig_index = module.functions[func_index];
         let signature = module.signatures[sig_index].clone();
 
+        // The native trampolines and call sequences move values 8 bytes at a
+        // time, so a v128 cannot cross a function boundary.
+        if signature
+            .params()
+            .iter()
+            .chain(signature.results().iter())
+            .any(|&ty| ty == Type::V128)
+        {
+            return Err(CodegenError {
+                message: "v128 is not supported in function signatures".to_string(),
+            });
+        }
+
         let mut assembler = Assembler::new(0);
         let special_labels = SpecialLabelSet {
             integer_division_by_zero: assembler.get_label(),
@@ -1912,6 +2280,7 @@ impl<'a> FuncGen<'a> {
             bad_signature: assembler.get_label(),
             gas_limit_exceeded: assembler.get_label(),
             stack_overflow: assembler.get_label(),
+            epoch_deadline_exceeded: assembler.get_label(),
         };
 
         let mut fg = FuncGen {
@@ -1925,6 +2294,10 @@ impl<'a> FuncGen<'a> {
             max_stack_depth: 0,
             stack_check_offset: AssemblyOffset(0),
             fp_stack: vec![],
+            v128_stack: vec![],
+            local_slots: None,
+            local_slot_count: 0,
+            pending_gas: 0,
             control_stack: vec![],
             machine: Machine::new(),
             unreachable_depth: 0,
@@ -2011,11 +2384,74 @@ impl<'a> FuncGen<'a> {
             was_unreachable = false;
         }
 
+        // A live v128 only survives operations that leave its XMM register
+        // untouched. Anything going through `emit_call_native` spills XMM
+        // registers as 64-bit values, which would silently truncate it.
+        if !self.v128_stack.is_empty() {
+            match op {
+                Operator::Call { .. }
+                | Operator::CallIndirect { .. }
+                | Operator::MemorySize { .. }
+                | Operator::MemoryGrow { .. }
+                | Operator::MemoryInit { .. }
+                | Operator::MemoryCopy { .. }
+                | Operator::MemoryFill { .. }
+                | Operator::DataDrop { .. }
+                | Operator::TableInit { .. }
+                | Operator::TableCopy { .. }
+                | Operator::TableFill { .. }
+                | Operator::TableGet { .. }
+                | Operator::TableSet { .. }
+                | Operator::TableGrow { .. }
+                | Operator::TableSize { .. }
+                | Operator::ElemDrop { .. }
+                | Operator::RefNull { .. }
+                | Operator::RefIsNull
+                | Operator::RefFunc { .. } => {
+                    return Err(CodegenError {
+                        message: format!(
+                            "calling into the runtime with a live v128 is not implemented: {:?}",
+                            op
+                        ),
+                    });
+                }
+                _ => {}
+            }
+        }
+
+        // A deferred gas charge must be settled before anything that can
+        // transfer control within the function: past a branch or a branch
+        // target the accumulated total no longer describes a straight-line
+        // region. Plain calls are settled in `emit_call` instead, after the
+        // gas intrinsic — which is itself a call — had a chance to extend the
+        // pending total.
+        if self.pending_gas != 0 {
+            match op {
+                Operator::Block { .. }
+                | Operator::Loop { .. }
+                | Operator::If { .. }
+                | Operator::Else
+                | Operator::End
+                | Operator::Br { .. }
+                | Operator::BrIf { .. }
+                | Operator::BrTable { .. }
+                | Operator::Return
+                | Operator::Unreachable
+                | Operator::CallIndirect { .. } => self.flush_gas(),
+                _ => {}
+            }
+        }
+
         match op {
             Operator::GlobalGet { global_index } => {
                 let global_index = GlobalIndex::from_u32(global_index);
 
                 let ty = type_to_wp_type(self.module.globals[global_index].ty);
+                if ty == WpType::V128 {
+                    return Err(CodegenError {
+                        message: "v128 globals are not supported".to_string(),
+                    });
+                }
                 if ty.is_float() {
                     self.fp_stack.push(FloatValue::new(self.value_stack.len()));
                 }
@@ -2083,6 +2519,11 @@ impl<'a> FuncGen<'a> {
                     Location::Memory(tmp, 0)
                 };
                 let ty = type_to_wp_type(self.module.globals[global_index].ty);
+                if ty == WpType::V128 {
+                    return Err(CodegenError {
+                        message: "v128 globals are not supported".to_string(),
+                    });
+                }
                 let loc = self.pop_value_released();
                 if ty.is_float() {
                     let fp = self.fp_stack.pop1()?;
@@ -2109,26 +2550,38 @@ impl<'a> FuncGen<'a> {
             }
             Operator::LocalGet { local_index } => {
                 let local_type = self.local_type(local_index);
-                let ret =
-                    self.machine
-                        .acquire_locations(&mut self.assembler, &[(WpType::I64)], false)[0];
-                self.emit_relaxed_binop(
-                    Assembler::emit_mov,
-                    Size::S64,
-                    self.machine.get_local_location(local_index),
-                    ret,
-                );
-                self.value_stack.push(ret);
-                if local_type.is_float() {
-                    self.fp_stack
-                        .push(FloatValue::new(self.value_stack.len() - 1));
+                if local_type == WpType::V128 {
+                    let ret = self.push_v128_ret()?;
+                    let src = self.v128_local_location(local_index);
+                    self.assembler.emit_vmovdqu(src, XMMOrMemory::XMM(ret));
+                } else {
+                    let ret = self.machine.acquire_locations(
+                        &mut self.assembler,
+                        &[(WpType::I64)],
+                        false,
+                    )[0];
+                    self.emit_relaxed_binop(
+                        Assembler::emit_mov,
+                        Size::S64,
+                        self.machine.get_local_location(self.local_slot(local_index)),
+                        ret,
+                    );
+                    self.value_stack.push(ret);
+                    if local_type.is_float() {
+                        self.fp_stack
+                            .push(FloatValue::new(self.value_stack.len() - 1));
+                    }
                 }
             }
             Operator::LocalSet { local_index } => {
-                let loc = self.pop_value_released();
                 let local_type = self.local_type(local_index);
 
-                if local_type.is_float() {
+                if local_type == WpType::V128 {
+                    let v = self.pop_v128()?;
+                    let dst = self.v128_local_location(local_index);
+                    self.assembler.emit_vmovdqu(XMMOrMemory::XMM(v), dst);
+                } else if local_type.is_float() {
+                    let loc = self.pop_value_released();
                     let fp = self.fp_stack.pop1()?;
                     if self.assembler.arch_supports_canonicalize_nan()
                         && self.config.enable_nan_canonicalization
@@ -2141,29 +2594,42 @@ impl<'a> FuncGen<'a> {
                                 _ => unreachable!(),
                             },
                             loc,
-                            self.machine.get_local_location(local_index),
+                            self.machine.get_local_location(self.local_slot(local_index)),
                         );
                     } else {
                         self.emit_relaxed_binop(
                             Assembler::emit_mov,
                             Size::S64,
                             loc,
-                            self.machine.get_local_location(local_index),
+                            self.machine.get_local_location(self.local_slot(local_index)),
                         );
                     }
                 } else {
+                    let loc = self.pop_value_released();
                     self.emit_relaxed_binop(
                         Assembler::emit_mov,
                         Size::S64,
                         loc,
-                        self.machine.get_local_location(local_index),
+                        self.machine.get_local_location(self.local_slot(local_index)),
                     );
                 }
             }
             Operator::LocalTee { local_index } => {
                 let loc = *self.value_stack.last().unwrap();
                 let local_type = self.local_type(local_index);
-                if local_type.is_float() {
+                if local_type == WpType::V128 {
+                    let v = match loc {
+                        Location::XMM(x) => x,
+                        _ => {
+                            return Err(CodegenError {
+                                message: "LocalTee: v128 value is not in an XMM register"
+                                    .to_string(),
+                            })
+                        }
+                    };
+                    let dst = self.v128_local_location(local_index);
+                    self.assembler.emit_vmovdqu(XMMOrMemory::XMM(v), dst);
+                } else if local_type.is_float() {
                     let fp = self.fp_stack.peek1()?;
                     if self.assembler.arch_supports_canonicalize_nan()
                         && self.config.enable_nan_canonicalization
@@ -2176,14 +2642,14 @@ impl<'a> FuncGen<'a> {
                                 _ => unreachable!(),
                             },
                             loc,
-                            self.machine.get_local_location(local_index),
+                            self.machine.get_local_location(self.local_slot(local_index)),
                         );
                     } else {
                         self.emit_relaxed_binop(
                             Assembler::emit_mov,
                             Size::S64,
                             loc,
-                            self.machine.get_local_location(local_index),
+                            self.machine.get_local_location(self.local_slot(local_index)),
                         );
                     }
                 } else {
@@ -2191,7 +2657,7 @@ impl<'a> FuncGen<'a> {
                         Assembler::emit_mov,
                         Size::S64,
                         loc,
-                        self.machine.get_local_location(local_index),
+                        self.machine.get_local_location(self.local_slot(local_index)),
                     );
                 }
             }
@@ -5147,6 +5613,12 @@ impl<'a> FuncGen<'a> {
                 let return_types: SmallVec<[WpType; 1]> =
                     sig.results().iter().cloned().map(type_to_wp_type).collect();
 
+                if param_types.contains(&WpType::V128) || return_types.contains(&WpType::V128) {
+                    return Err(CodegenError {
+                        message: "v128 is not supported in call signatures".to_string(),
+                    });
+                }
+
                 let func_index = self.pop_value_released();
 
                 let params: SmallVec<[_; 8]> = self
@@ -5155,6 +5627,10 @@ impl<'a> FuncGen<'a> {
                     .collect();
                 self.machine.release_locations_only_regs(&params);
 
+                if self.config.epoch_interruption {
+                    self.emit_epoch_check();
+                }
+
                 // Pop arguments off the FP stack and canonicalize them if needed.
                 //
                 // Canonicalization state will be lost across function calls, so early canonicalization
@@ -5345,6 +5821,11 @@ impl<'a> FuncGen<'a> {
                     if_else: IfElseState::If(label_else),
                     returns: match ty {
                         WpTypeOrFuncType::Type(WpType::EmptyBlockType) => smallvec![],
+                        WpTypeOrFuncType::Type(WpType::V128) => {
+                            return Err(CodegenError {
+                                message: "If: v128 block results are not supported".to_string(),
+                            })
+                        }
                         WpTypeOrFuncType::Type(inner_ty) => smallvec![inner_ty],
                         _ => {
                             return Err(CodegenError {
@@ -5407,6 +5888,7 @@ impl<'a> FuncGen<'a> {
                     .release_locations(&mut self.assembler, released);
                 self.value_stack.truncate(frame.value_stack_depth);
                 self.fp_stack.truncate(frame.fp_stack_depth);
+                self.v128_stack.retain(|&d| d < frame.value_stack_depth);
 
                 match frame.if_else {
                     IfElseState::If(label) => {
@@ -5424,6 +5906,19 @@ impl<'a> FuncGen<'a> {
             // `TypedSelect` must be used for extern refs so ref counting should
             // be done with TypedSelect. But otherwise they're the same.
             Operator::TypedSelect { .. } | Operator::Select => {
+                // The two selected values sit right below the condition.
+                // Selecting between v128 values would move them 8 bytes at a
+                // time and truncate them.
+                let depth = self.value_stack.len();
+                if self
+                    .v128_stack
+                    .iter()
+                    .any(|&d| d + 2 == depth || d + 3 == depth)
+                {
+                    return Err(CodegenError {
+                        message: "Select: v128 operands are not supported".to_string(),
+                    });
+                }
                 let cond = self.pop_value_released();
                 let v_b = self.pop_value_released();
                 let v_a = self.pop_value_released();
@@ -5486,6 +5981,11 @@ impl<'a> FuncGen<'a> {
                     if_else: IfElseState::None,
                     returns: match ty {
                         WpTypeOrFuncType::Type(WpType::EmptyBlockType) => smallvec![],
+                        WpTypeOrFuncType::Type(WpType::V128) => {
+                            return Err(CodegenError {
+                                message: "Block: v128 block results are not supported".to_string(),
+                            })
+                        }
                         WpTypeOrFuncType::Type(inner_ty) => smallvec![inner_ty],
                         _ => {
                             return Err(CodegenError {
@@ -5520,6 +6020,11 @@ impl<'a> FuncGen<'a> {
                     if_else: IfElseState::None,
                     returns: match ty {
                         WpTypeOrFuncType::Type(WpType::EmptyBlockType) => smallvec![],
+                        WpTypeOrFuncType::Type(WpType::V128) => {
+                            return Err(CodegenError {
+                                message: "Loop: v128 block results are not supported".to_string(),
+                            })
+                        }
                         WpTypeOrFuncType::Type(inner_ty) => smallvec![inner_ty],
                         _ => {
                             return Err(CodegenError {
@@ -5533,7 +6038,11 @@ impl<'a> FuncGen<'a> {
                 });
                 self.assembler.emit_label(label);
 
-                // TODO: Re-enable interrupt signal check without branching
+                // Branches back to the loop label pass through here, so this
+                // check runs once per iteration.
+                if self.config.epoch_interruption {
+                    self.emit_epoch_check();
+                }
             }
             Operator::Nop => {}
             Operator::MemorySize { mem, mem_byte: _ } => {
@@ -6465,10 +6974,14 @@ impl<'a> FuncGen<'a> {
                 self.unreachable_depth = 1;
             }
             Operator::Drop => {
-                self.pop_value_released();
-                if let Some(x) = self.fp_stack.last() {
-                    if x.depth == self.value_stack.len() {
-                        self.fp_stack.pop1()?;
+                if self.v128_stack.last() == Some(&(self.value_stack.len() - 1)) {
+                    self.pop_v128()?;
+                } else {
+                    self.pop_value_released();
+                    if let Some(x) = self.fp_stack.last() {
+                        if x.depth == self.value_stack.len() {
+                            self.fp_stack.pop1()?;
+                        }
                     }
                 }
             }
@@ -6514,12 +7027,8 @@ impl<'a> FuncGen<'a> {
                     self.assembler.emit_label(frame.label);
                     self.update_max_stack_depth();
                     self.emit_function_stack_check(false);
-                    let local_count = self.local_count();
-                    self.machine.finalize_locals(
-                        &mut self.assembler,
-                        self.calling_convention,
-                        local_count,
-                    );
+                    self.machine
+                        .finalize_locals(&mut self.assembler, self.calling_convention);
                     self.assembler.emit_mov(
                         Size::S64,
                         Location::GPR(GPR::RBP),
@@ -6546,6 +7055,7 @@ impl<'a> FuncGen<'a> {
                     self.update_max_stack_depth();
                     self.value_stack.truncate(frame.value_stack_depth);
                     self.fp_stack.truncate(frame.fp_stack_depth);
+                    self.v128_stack.retain(|&d| d < frame.value_stack_depth);
 
                     if !frame.loop_like {
                         self.assembler.emit_label(frame.label);
@@ -8360,6 +8870,294 @@ impl<'a> FuncGen<'a> {
                     [Location::Imm32(segment)].iter().cloned(),
                 )?;
             }
+            Operator::V128Const { value } => {
+                let ret = self.push_v128_ret()?;
+                let bytes = *value.bytes();
+                self.emit_v128_const(&bytes, ret);
+            }
+            Operator::V128Load { ref memarg } => {
+                let target = self.pop_value_released();
+                let ret = self.push_v128_ret()?;
+                self.emit_memory_op(target, memarg, false, 16, |this, addr| {
+                    this.assembler
+                        .emit_vmovdqu(XMMOrMemory::Memory(addr, 0), XMMOrMemory::XMM(ret));
+                    Ok(())
+                })?;
+            }
+            Operator::V128Store { ref memarg } => {
+                let value = self.pop_v128()?;
+                let target_addr = self.pop_value_released();
+                self.emit_memory_op(target_addr, memarg, false, 16, |this, addr| {
+                    this.assembler
+                        .emit_vmovdqu(XMMOrMemory::XMM(value), XMMOrMemory::Memory(addr, 0));
+                    Ok(())
+                })?;
+            }
+            Operator::I8x16Splat => {
+                let ret = self.emit_splat_v128(Size::S32, false)?;
+                // `pshufb` with an all-zero mask broadcasts byte 0.
+                let zeros = self.machine.acquire_temp_xmm().unwrap();
+                self.assembler
+                    .emit_vpxor(zeros, XMMOrMemory::XMM(zeros), zeros);
+                self.assembler
+                    .emit_vpshufb(ret, XMMOrMemory::XMM(zeros), ret);
+                self.machine.release_temp_xmm(zeros);
+            }
+            Operator::I16x8Splat => {
+                let ret = self.emit_splat_v128(Size::S32, false)?;
+                self.assembler.emit_vpshuflw(0, ret, ret);
+                self.assembler.emit_vpshufd(0, XMMOrMemory::XMM(ret), ret);
+            }
+            Operator::I32x4Splat => {
+                let ret = self.emit_splat_v128(Size::S32, false)?;
+                self.assembler.emit_vpshufd(0, XMMOrMemory::XMM(ret), ret);
+            }
+            Operator::I64x2Splat => {
+                let ret = self.emit_splat_v128(Size::S64, false)?;
+                self.assembler
+                    .emit_vpshufd(0x44, XMMOrMemory::XMM(ret), ret);
+            }
+            Operator::F32x4Splat => {
+                let ret = self.emit_splat_v128(Size::S32, true)?;
+                self.assembler.emit_vpshufd(0, XMMOrMemory::XMM(ret), ret);
+            }
+            Operator::F64x2Splat => {
+                let ret = self.emit_splat_v128(Size::S64, true)?;
+                self.assembler
+                    .emit_vpshufd(0x44, XMMOrMemory::XMM(ret), ret);
+            }
+            Operator::I8x16ExtractLaneU { lane } => {
+                self.emit_extract_lane_v128(WpType::I32, |this, v, tmp| {
+                    this.assembler.emit_vpextrb(lane, v, tmp);
+                })?;
+            }
+            Operator::I8x16ExtractLaneS { lane } => {
+                self.emit_extract_lane_v128(WpType::I32, |this, v, tmp| {
+                    this.assembler.emit_vpextrb(lane, v, tmp);
+                    this.assembler.emit_movsx(
+                        Size::S8,
+                        Location::GPR(tmp),
+                        Size::S32,
+                        Location::GPR(tmp),
+                    );
+                })?;
+            }
+            Operator::I16x8ExtractLaneU { lane } => {
+                self.emit_extract_lane_v128(WpType::I32, |this, v, tmp| {
+                    this.assembler.emit_vpextrw(lane, v, tmp);
+                })?;
+            }
+            Operator::I16x8ExtractLaneS { lane } => {
+                self.emit_extract_lane_v128(WpType::I32, |this, v, tmp| {
+                    this.assembler.emit_vpextrw(lane, v, tmp);
+                    this.assembler.emit_movsx(
+                        Size::S16,
+                        Location::GPR(tmp),
+                        Size::S32,
+                        Location::GPR(tmp),
+                    );
+                })?;
+            }
+            Operator::I32x4ExtractLane { lane } => {
+                self.emit_extract_lane_v128(WpType::I32, |this, v, tmp| {
+                    this.assembler.emit_vpextrd(lane, v, tmp);
+                })?;
+            }
+            Operator::I64x2ExtractLane { lane } => {
+                self.emit_extract_lane_v128(WpType::I64, |this, v, tmp| {
+                    this.assembler.emit_vpextrq(lane, v, tmp);
+                })?;
+            }
+            Operator::F32x4ExtractLane { lane } => {
+                let v = self.pop_v128()?;
+                let ret = self
+                    .machine
+                    .acquire_locations(&mut self.assembler, &[(WpType::F32)], false)[0];
+                self.value_stack.push(ret);
+                self.fp_stack
+                    .push(FloatValue::new(self.value_stack.len() - 1));
+                // Shuffle the requested lane into dword 0; the scalar only
+                // reads the low 32 bits, so the other lanes don't matter.
+                match ret {
+                    Location::XMM(x) => {
+                        self.assembler.emit_vpshufd(lane, XMMOrMemory::XMM(v), x);
+                    }
+                    _ => {
+                        let tmp = self.machine.acquire_temp_xmm().unwrap();
+                        self.assembler.emit_vpshufd(lane, XMMOrMemory::XMM(v), tmp);
+                        self.assembler.emit_mov(Size::S32, Location::XMM(tmp), ret);
+                        self.machine.release_temp_xmm(tmp);
+                    }
+                }
+            }
+            Operator::F64x2ExtractLane { lane } => {
+                let v = self.pop_v128()?;
+                let ret = self
+                    .machine
+                    .acquire_locations(&mut self.assembler, &[(WpType::F64)], false)[0];
+                self.value_stack.push(ret);
+                self.fp_stack
+                    .push(FloatValue::new(self.value_stack.len() - 1));
+                // Move the requested qword into qword 0 dword by dword.
+                let imm = if lane == 0 { 0xE4 } else { 0x0E };
+                match ret {
+                    Location::XMM(x) => {
+                        self.assembler.emit_vpshufd(imm, XMMOrMemory::XMM(v), x);
+                    }
+                    _ => {
+                        let tmp = self.machine.acquire_temp_xmm().unwrap();
+                        self.assembler.emit_vpshufd(imm, XMMOrMemory::XMM(v), tmp);
+                        self.assembler.emit_mov(Size::S64, Location::XMM(tmp), ret);
+                        self.machine.release_temp_xmm(tmp);
+                    }
+                }
+            }
+            Operator::I8x16ReplaceLane { lane } => {
+                self.emit_replace_lane_v128(lane, Size::S32, false, Assembler::emit_vpinsrb)?;
+            }
+            Operator::I16x8ReplaceLane { lane } => {
+                self.emit_replace_lane_v128(lane, Size::S32, false, Assembler::emit_vpinsrw)?;
+            }
+            Operator::I32x4ReplaceLane { lane } => {
+                self.emit_replace_lane_v128(lane, Size::S32, false, Assembler::emit_vpinsrd)?;
+            }
+            Operator::I64x2ReplaceLane { lane } => {
+                self.emit_replace_lane_v128(lane, Size::S64, false, Assembler::emit_vpinsrq)?;
+            }
+            Operator::F32x4ReplaceLane { lane } => {
+                self.emit_replace_lane_v128(lane, Size::S32, true, Assembler::emit_vpinsrd)?;
+            }
+            Operator::F64x2ReplaceLane { lane } => {
+                self.emit_replace_lane_v128(lane, Size::S64, true, Assembler::emit_vpinsrq)?;
+            }
+            Operator::I8x16Shuffle { lanes } => {
+                let b = self.pop_v128()?;
+                let a = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                // `pshufb` zeroes any byte whose selector has bit 7 set, which
+                // lets each half ignore the lanes taken from the other input.
+                let mut mask_a = [0u8; 16];
+                let mut mask_b = [0u8; 16];
+                for (i, &lane) in lanes.iter().enumerate() {
+                    if lane < 16 {
+                        mask_a[i] = lane;
+                        mask_b[i] = 0x80;
+                    } else {
+                        mask_a[i] = 0x80;
+                        mask_b[i] = lane - 16;
+                    }
+                }
+                let tmp_a = self.machine.acquire_temp_xmm().unwrap();
+                let tmp_b = self.machine.acquire_temp_xmm().unwrap();
+                self.emit_v128_const(&mask_a, tmp_a);
+                self.assembler
+                    .emit_vpshufb(a, XMMOrMemory::XMM(tmp_a), tmp_a);
+                self.emit_v128_const(&mask_b, tmp_b);
+                self.assembler
+                    .emit_vpshufb(b, XMMOrMemory::XMM(tmp_b), tmp_b);
+                self.assembler
+                    .emit_vpor(tmp_a, XMMOrMemory::XMM(tmp_b), ret);
+                self.machine.release_temp_xmm(tmp_b);
+                self.machine.release_temp_xmm(tmp_a);
+            }
+            Operator::I8x16Swizzle => {
+                let s = self.pop_v128()?;
+                let a = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                // Saturate every out-of-range selector to 0x80 or above so
+                // that `pshufb` zeroes the lane, as the wasm semantics
+                // require.
+                let tmp = self.machine.acquire_temp_xmm().unwrap();
+                self.emit_v128_const(&[0x70; 16], tmp);
+                self.assembler.emit_vpaddusb(s, XMMOrMemory::XMM(tmp), tmp);
+                self.assembler.emit_vpshufb(a, XMMOrMemory::XMM(tmp), ret);
+                self.machine.release_temp_xmm(tmp);
+            }
+            Operator::V128Not => {
+                let a = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                let ones = self.machine.acquire_temp_xmm().unwrap();
+                self.assembler
+                    .emit_vpcmpeqd(ones, XMMOrMemory::XMM(ones), ones);
+                self.assembler.emit_vpxor(a, XMMOrMemory::XMM(ones), ret);
+                self.machine.release_temp_xmm(ones);
+            }
+            Operator::V128And => self.emit_binop_v128(Assembler::emit_vpand)?,
+            Operator::V128Or => self.emit_binop_v128(Assembler::emit_vpor)?,
+            Operator::V128Xor => self.emit_binop_v128(Assembler::emit_vpxor)?,
+            Operator::V128AndNot => {
+                // Wasm `v128.andnot` computes `a & !b`; `pandn` computes
+                // `!src1 & src2`, so the operands swap places.
+                let b = self.pop_v128()?;
+                let a = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                self.assembler.emit_vpandn(b, XMMOrMemory::XMM(a), ret);
+            }
+            Operator::V128Bitselect => {
+                let mask = self.pop_v128()?;
+                let v2 = self.pop_v128()?;
+                let v1 = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                let tmp = self.machine.acquire_temp_xmm().unwrap();
+                self.assembler.emit_vpand(v1, XMMOrMemory::XMM(mask), tmp);
+                self.assembler.emit_vpandn(mask, XMMOrMemory::XMM(v2), ret);
+                self.assembler.emit_vpor(tmp, XMMOrMemory::XMM(ret), ret);
+                self.machine.release_temp_xmm(tmp);
+            }
+            Operator::I8x16Add => self.emit_binop_v128(Assembler::emit_vpaddb)?,
+            Operator::I16x8Add => self.emit_binop_v128(Assembler::emit_vpaddw)?,
+            Operator::I32x4Add => self.emit_binop_v128(Assembler::emit_vpaddd)?,
+            Operator::I64x2Add => self.emit_binop_v128(Assembler::emit_vpaddq)?,
+            Operator::I8x16Sub => self.emit_binop_v128(Assembler::emit_vpsubb)?,
+            Operator::I16x8Sub => self.emit_binop_v128(Assembler::emit_vpsubw)?,
+            Operator::I32x4Sub => self.emit_binop_v128(Assembler::emit_vpsubd)?,
+            Operator::I64x2Sub => self.emit_binop_v128(Assembler::emit_vpsubq)?,
+            Operator::I8x16AddSatS => self.emit_binop_v128(Assembler::emit_vpaddsb)?,
+            Operator::I8x16AddSatU => self.emit_binop_v128(Assembler::emit_vpaddusb)?,
+            Operator::I16x8AddSatS => self.emit_binop_v128(Assembler::emit_vpaddsw)?,
+            Operator::I16x8AddSatU => self.emit_binop_v128(Assembler::emit_vpaddusw)?,
+            Operator::I8x16SubSatS => self.emit_binop_v128(Assembler::emit_vpsubsb)?,
+            Operator::I8x16SubSatU => self.emit_binop_v128(Assembler::emit_vpsubusb)?,
+            Operator::I16x8SubSatS => self.emit_binop_v128(Assembler::emit_vpsubsw)?,
+            Operator::I16x8SubSatU => self.emit_binop_v128(Assembler::emit_vpsubusw)?,
+            Operator::I16x8Mul => self.emit_binop_v128(Assembler::emit_vpmullw)?,
+            Operator::I32x4Mul => self.emit_binop_v128(Assembler::emit_vpmulld)?,
+            Operator::I8x16MinS => self.emit_binop_v128(Assembler::emit_vpminsb)?,
+            Operator::I8x16MinU => self.emit_binop_v128(Assembler::emit_vpminub)?,
+            Operator::I8x16MaxS => self.emit_binop_v128(Assembler::emit_vpmaxsb)?,
+            Operator::I8x16MaxU => self.emit_binop_v128(Assembler::emit_vpmaxub)?,
+            Operator::I16x8MinS => self.emit_binop_v128(Assembler::emit_vpminsw)?,
+            Operator::I16x8MinU => self.emit_binop_v128(Assembler::emit_vpminuw)?,
+            Operator::I16x8MaxS => self.emit_binop_v128(Assembler::emit_vpmaxsw)?,
+            Operator::I16x8MaxU => self.emit_binop_v128(Assembler::emit_vpmaxuw)?,
+            Operator::I32x4MinS => self.emit_binop_v128(Assembler::emit_vpminsd)?,
+            Operator::I32x4MinU => self.emit_binop_v128(Assembler::emit_vpminud)?,
+            Operator::I32x4MaxS => self.emit_binop_v128(Assembler::emit_vpmaxsd)?,
+            Operator::I32x4MaxU => self.emit_binop_v128(Assembler::emit_vpmaxud)?,
+            Operator::I8x16RoundingAverageU => self.emit_binop_v128(Assembler::emit_vpavgb)?,
+            Operator::I16x8RoundingAverageU => self.emit_binop_v128(Assembler::emit_vpavgw)?,
+            Operator::I8x16Neg => self.emit_neg_v128(Assembler::emit_vpsubb)?,
+            Operator::I16x8Neg => self.emit_neg_v128(Assembler::emit_vpsubw)?,
+            Operator::I32x4Neg => self.emit_neg_v128(Assembler::emit_vpsubd)?,
+            Operator::I64x2Neg => self.emit_neg_v128(Assembler::emit_vpsubq)?,
+            Operator::F32x4Add => self.emit_binop_v128(Assembler::emit_vaddps)?,
+            Operator::F32x4Sub => self.emit_binop_v128(Assembler::emit_vsubps)?,
+            Operator::F32x4Mul => self.emit_binop_v128(Assembler::emit_vmulps)?,
+            Operator::F32x4Div => self.emit_binop_v128(Assembler::emit_vdivps)?,
+            Operator::F64x2Add => self.emit_binop_v128(Assembler::emit_vaddpd)?,
+            Operator::F64x2Sub => self.emit_binop_v128(Assembler::emit_vsubpd)?,
+            Operator::F64x2Mul => self.emit_binop_v128(Assembler::emit_vmulpd)?,
+            Operator::F64x2Div => self.emit_binop_v128(Assembler::emit_vdivpd)?,
+            Operator::F32x4Sqrt => {
+                let a = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                self.assembler.emit_vsqrtps(XMMOrMemory::XMM(a), ret);
+            }
+            Operator::F64x2Sqrt => {
+                let a = self.pop_v128()?;
+                let ret = self.push_v128_ret()?;
+                self.assembler.emit_vsqrtpd(XMMOrMemory::XMM(a), ret);
+            }
             _ => {
                 return Err(CodegenError {
                     message: format!("not yet implemented: {:?}", op),
@@ -8407,6 +9205,10 @@ impl<'a> FuncGen<'a> {
             .emit_label(self.special_labels.stack_overflow);
         self.emit_trap(TrapCode::StackOverflow);
 
+        self.assembler
+            .emit_label(self.special_labels.epoch_deadline_exceeded);
+        self.emit_trap(TrapCode::DeadlineExceeded);
+
         // Notify the assembler backend to generate necessary code at end of function.
         self.assembler.finalize_function();
 
@@ -8885,6 +9687,141 @@ pub(crate) fn gen_import_call_trampoline(
     }
 }
 
+// Stub placed in the body slot of a function whose compilation is deferred to
+// its first call. See `SinglepassCompiler::compile_module_lazily`.
+//
+// The stub is ABI-transparent: on the fast path it loads the compiled body
+// address from this function's slot in the (zero-initialized) slots section
+// and tail-calls it. On the slow path it preserves the System V argument
+// registers, obtains the body address from the `LazyCompile` libcall and then
+// performs the same tail call, with RSP restored to its on-entry value so that
+// stack-passed arguments keep their expected offsets.
+pub(crate) fn gen_lazy_compile_stub(
+    index: LocalFunctionIndex,
+    lazy_sections: LazySections,
+    calling_convention: CallingConvention,
+) -> CompiledFunction {
+    assert!(
+        matches!(calling_convention, CallingConvention::SystemV),
+        "lazy compile stubs are only implemented for the System V calling convention"
+    );
+    static ARG_GPRS: &[GPR] = &[GPR::RDI, GPR::RSI, GPR::RDX, GPR::RCX, GPR::R8, GPR::R9];
+    static ARG_XMMS: &[XMM] = &[
+        XMM::XMM0,
+        XMM::XMM1,
+        XMM::XMM2,
+        XMM::XMM3,
+        XMM::XMM4,
+        XMM::XMM5,
+        XMM::XMM6,
+        XMM::XMM7,
+    ];
+    // Spill space for the XMM argument registers plus realignment of the
+    // stack for the libcall; the GPR pushes below keep RSP % 16 == 8.
+    const SPILL: u32 = ARG_XMMS.len() as u32 * 8 + 8;
+
+    let mut a = Assembler::new(0);
+    let mut relocations = vec![];
+
+    // Bump the invocation counter. A plain add is enough: the counters are a
+    // tier-up heuristic and may drop updates under concurrent calls.
+    relocations.push(Relocation {
+        kind: RelocationKind::Abs8,
+        reloc_target: RelocationTarget::CustomSection(lazy_sections.counters),
+        offset: (a.get_offset().0 + a.arch_mov64_imm_offset()) as u32,
+        addend: index.index() as i64 * 8,
+    });
+    a.emit_mov(
+        Size::S64,
+        Location::Imm64(std::u64::MAX),
+        Location::GPR(GPR::RAX),
+    );
+    a.emit_add(
+        Size::S64,
+        Location::Imm32(1),
+        Location::Memory(GPR::RAX, 0),
+    );
+
+    // Fast path. The slot is written by `wasmer_vm_lazy_compile` and later
+    // rewritten by the tier-up monitor; both publish complete bodies, so a
+    // plain aligned load is enough to observe a valid address.
+    let resolved = a.get_label();
+    relocations.push(Relocation {
+        kind: RelocationKind::Abs8,
+        reloc_target: RelocationTarget::CustomSection(lazy_sections.slots),
+        offset: (a.get_offset().0 + a.arch_mov64_imm_offset()) as u32,
+        addend: index.index() as i64 * 8,
+    });
+    // The Imm64 value is relocated by the JIT linker.
+    a.emit_mov(
+        Size::S64,
+        Location::Imm64(std::u64::MAX),
+        Location::GPR(GPR::RAX),
+    );
+    a.emit_mov(
+        Size::S64,
+        Location::Memory(GPR::RAX, 0),
+        Location::GPR(GPR::RAX),
+    );
+    a.emit_test_gpr_64(GPR::RAX);
+    a.emit_jmp(Condition::NotEqual, resolved);
+
+    // Slow path: hand over to the engine. The VMContext in RDI doubles as the
+    // libcall's first argument.
+    for &r in ARG_GPRS {
+        a.emit_push(Size::S64, Location::GPR(r));
+    }
+    a.emit_sub(Size::S64, Location::Imm32(SPILL), Location::GPR(GPR::RSP));
+    for (i, &x) in ARG_XMMS.iter().enumerate() {
+        a.emit_mov(
+            Size::S64,
+            Location::XMM(x),
+            Location::Memory(GPR::RSP, (i * 8) as i32),
+        );
+    }
+    a.emit_mov(
+        Size::S64,
+        Location::Imm64(index.index() as u64),
+        Location::GPR(GPR::RSI),
+    );
+    relocations.push(Relocation {
+        kind: RelocationKind::Abs8,
+        reloc_target: RelocationTarget::LibCall(LibCall::LazyCompile),
+        offset: (a.get_offset().0 + a.arch_mov64_imm_offset()) as u32,
+        addend: 0,
+    });
+    a.emit_mov(
+        Size::S64,
+        Location::Imm64(std::u64::MAX),
+        Location::GPR(GPR::RAX),
+    );
+    a.emit_call_location(Location::GPR(GPR::RAX));
+    for (i, &x) in ARG_XMMS.iter().enumerate() {
+        a.emit_mov(
+            Size::S64,
+            Location::Memory(GPR::RSP, (i * 8) as i32),
+            Location::XMM(x),
+        );
+    }
+    a.emit_add(Size::S64, Location::Imm32(SPILL), Location::GPR(GPR::RSP));
+    for &r in ARG_GPRS.iter().rev() {
+        a.emit_pop(Size::S64, Location::GPR(r));
+    }
+
+    a.emit_label(resolved);
+    a.emit_host_redirection(GPR::RAX);
+
+    CompiledFunction {
+        body: FunctionBody {
+            body: a.finalize().unwrap().to_vec(),
+            unwind_info: None,
+        },
+        relocations,
+        jt_offsets: SecondaryMap::new(),
+        frame_info: CompiledFunctionFrameInfo::default(),
+    }
+}
+
 // Constants for the bounds of truncation operations. These are the least or
 // greatest exact floats in either f32 or f64 representation less-than (for
 // least) or greater-than (for greatest) the i32 or i64 or u32 or u64
@@ -3,23 +3,26 @@
 #![allow(unused_imports, dead_code)]
 
 use crate::codegen_x64::{
-    gen_import_call_trampoline, gen_std_dynamic_import_trampoline, gen_std_trampoline,
-    CodegenError, FuncGen,
+    gen_import_call_trampoline, gen_lazy_compile_stub, gen_std_dynamic_import_trampoline,
+    gen_std_trampoline, CodegenError, FuncGen,
 };
 use crate::config::Singlepass;
 #[cfg(feature = "rayon")]
 use rayon::prelude::{IntoParallelIterator, ParallelIterator};
-use std::sync::Arc;
+use std::sync::{Arc, Mutex};
+use wasmer_compiler::wasmparser::{FuncValidator, Validator, ValidatorResources};
 use wasmer_compiler::{
-    Architecture, CallingConvention, Compilation, CompileError, CompileModuleInfo,
-    CompiledFunction, Compiler, CompilerConfig, CpuFeature, FunctionBody, FunctionBodyData,
-    ModuleTranslationState, OperatingSystem, SectionIndex, Target, TrapInformation,
+    wasmparser_features, Architecture, CallingConvention, Compilation, CompileError,
+    CompileModuleInfo, CompiledFunction, Compiler, CompilerConfig, CpuFeature, CustomSection,
+    CustomSectionProtection, Features, FunctionBody, FunctionBodyData, LazySections,
+    ModuleEnvironment, ModuleTranslationState, OperatingSystem, SectionBody, SectionIndex,
+    StreamingCompilation, Target, TranslationSink, TrapInformation, WasmError, WasmResult,
 };
 use wasmer_types::entity::{EntityRef, PrimaryMap};
 use wasmer_types::{
     FunctionIndex, FunctionType, LocalFunctionIndex, MemoryIndex, ModuleInfo, TableIndex,
 };
-use wasmer_vm::{TrapCode, VMOffsets};
+use wasmer_vm::{MemoryStyle, TableStyle, TrapCode, VMOffsets};
 
 /// A compiler that compiles a WebAssembly module with Singlepass.
 /// It does the compilation in one pass
@@ -37,18 +40,14 @@ impl SinglepassCompiler {
     fn config(&self) -> &Singlepass {
         &self.config
     }
-}
 
-impl Compiler for SinglepassCompiler {
-    /// Compile the module using Singlepass, producing a compilation result with
-    /// associated relocations.
-    fn compile_module(
+    /// Checks that the target and the module features are supported, returning
+    /// the calling convention to compile for.
+    fn check_target(
         &self,
         target: &Target,
-        compile_info: &CompileModuleInfo,
-        module_translation: &ModuleTranslationState,
-        function_body_inputs: PrimaryMap<LocalFunctionIndex, FunctionBodyData<'_>>,
-    ) -> Result<Compilation, CompileError> {
+        features: &Features,
+    ) -> Result<CallingConvention, CompileError> {
         /*if target.triple().operating_system == OperatingSystem::Windows {
             return Err(CompileError::UnsupportedTarget(
                 OperatingSystem::Windows.to_string(),
@@ -64,33 +63,119 @@ impl Compiler for SinglepassCompiler {
                 "x86_64 without AVX".to_string(),
             ));
         }
-        if compile_info.features.multi_value {
+        if features.multi_value {
             return Err(CompileError::UnsupportedFeature("multivalue".to_string()));
         }
-        let calling_convention = match target.triple().default_calling_convention() {
+        Ok(match target.triple().default_calling_convention() {
             Ok(CallingConvention::WindowsFastcall) => CallingConvention::WindowsFastcall,
             Ok(CallingConvention::SystemV) => CallingConvention::SystemV,
             //Ok(CallingConvention::AppleAarch64) => AppleAarch64,
             _ => panic!("Unsupported Calling convention for Singlepass compiler"),
-        };
+        })
+    }
 
-        let table_styles = &compile_info.table_styles;
-        let module = &compile_info.module;
-        let pointer_width = target
-            .triple()
-            .pointer_width()
-            .map_err(|()| {
-                CompileError::UnsupportedTarget("target with unknown pointer width".into())
-            })?
-            .bytes();
-        let vmoffsets = VMOffsets::new(pointer_width).with_module_info(&module);
+    /// Runs `FuncGen` over a single function body.
+    ///
+    /// When `validator` is provided, every operator is fed to it before it is
+    /// fed to `FuncGen`, so the body is validated and compiled in the one
+    /// decode; without one the body must have been validated beforehand.
+    fn compile_one(
+        &self,
+        compile_info: &CompileModuleInfo,
+        module_translation: &ModuleTranslationState,
+        vmoffsets: &VMOffsets,
+        calling_convention: CallingConvention,
+        i: LocalFunctionIndex,
+        input: &FunctionBodyData<'_>,
+        mut validator: Option<FuncValidator<ValidatorResources>>,
+    ) -> Result<CompiledFunction, CompileError> {
+        let reader = wasmer_compiler::FunctionReader::new(input.module_offset, input.data);
+
+        let mut generator = FuncGen::new(
+            &compile_info.module,
+            module_translation,
+            &self.config,
+            vmoffsets,
+            &compile_info.table_styles,
+            i,
+            calling_convention,
+        )
+        .map_err(to_compile_error)?;
+
+        let mut local_reader = reader.get_locals_reader()?;
+        for _ in 0..local_reader.get_count() {
+            let offset = local_reader.original_position();
+            let (count, ty) = local_reader.read()?;
+            if let Some(validator) = validator.as_mut() {
+                validator
+                    .define_locals(offset, count, ty)
+                    .map_err(to_validate_error)?;
+            }
+            // Overflows feeding a local here have most likely already been caught by the
+            // validator, but it is possible that the validator hasn't been run at all, or
+            // that the validator does not impose any limits on the number of locals.
+            generator.feed_local(count, ty);
+        }
+
+        generator.emit_head().map_err(to_compile_error)?;
+
+        let mut operator_reader = reader.get_operators_reader()?.into_iter_with_offsets();
+        while generator.has_control_frames() {
+            let (op, pos) = match operator_reader.next() {
+                Some(op_and_pos) => op_and_pos?,
+                // The body ran out of operators with control frames still
+                // open: it is missing its terminating `end`. Let the
+                // validator report the truncation when there is one.
+                None => {
+                    if let Some(mut validator) = validator {
+                        validator
+                            .finish(input.module_offset + input.data.len())
+                            .map_err(to_validate_error)?;
+                    }
+                    return Err(CompileError::Validate(
+                        "function body is truncated".to_string(),
+                    ));
+                }
+            };
+            if let Some(validator) = validator.as_mut() {
+                validator.op(pos, &op).map_err(to_validate_error)?;
+            }
+            generator.set_srcloc(pos as u32);
+            generator.feed_operator(op).map_err(to_compile_error)?;
+        }
+
+        if let Some(mut validator) = validator {
+            // Code generation stops at the `end` that closes the function;
+            // feed anything left over to the validator so that trailing
+            // operators are still rejected.
+            for op_and_pos in operator_reader {
+                let (op, pos) = op_and_pos?;
+                validator.op(pos, &op).map_err(to_validate_error)?;
+            }
+            validator
+                .finish(input.module_offset + input.data.len())
+                .map_err(to_validate_error)?;
+        }
+
+        Ok(generator.finalize(input))
+    }
+
+    /// Generates the trampolines that accompany the compiled `functions` and
+    /// assembles the final [`Compilation`].
+    fn finish_compilation(
+        &self,
+        module: &ModuleInfo,
+        vmoffsets: &VMOffsets,
+        calling_convention: CallingConvention,
+        functions: PrimaryMap<LocalFunctionIndex, CompiledFunction>,
+    ) -> Compilation {
         let import_idxs = 0..module.import_counts.functions as usize;
         let import_trampolines: PrimaryMap<SectionIndex, _> = import_idxs
             .into_par_iter_if_rayon()
             .map(|i| {
                 let i = FunctionIndex::new(i);
                 gen_import_call_trampoline(
-                    &vmoffsets,
+                    vmoffsets,
                     i,
                     &module.signatures[module.functions[i]],
                     calling_convention,
@@ -99,46 +184,331 @@ impl Compiler for SinglepassCompiler {
             .collect::<Vec<_>>()
             .into_iter()
             .collect();
+
+        let function_call_trampolines = module
+            .signatures
+            .values()
+            .collect::<Vec<_>>()
+            .into_par_iter_if_rayon()
+            .map(|func_type| gen_std_trampoline(&func_type, calling_convention))
+            .collect::<Vec<_>>()
+            .into_iter()
+            .collect::<PrimaryMap<_, _>>();
+
+        let dynamic_function_trampolines = module
+            .imported_function_types()
+            .collect::<Vec<_>>()
+            .into_par_iter_if_rayon()
+            .map(|func_type| {
+                gen_std_dynamic_import_trampoline(vmoffsets, &func_type, calling_convention)
+            })
+            .collect::<Vec<_>>()
+            .into_iter()
+            .collect::<PrimaryMap<FunctionIndex, FunctionBody>>();
+
+        Compilation::new(
+            functions,
+            import_trampolines,
+            function_call_trampolines,
+            dynamic_function_trampolines,
+            None,
+            None,
+        )
+    }
+}
+
+impl Compiler for SinglepassCompiler {
+    /// Compile the module using Singlepass, producing a compilation result with
+    /// associated relocations.
+    fn compile_module(
+        &self,
+        target: &Target,
+        compile_info: &CompileModuleInfo,
+        module_translation: &ModuleTranslationState,
+        function_body_inputs: PrimaryMap<LocalFunctionIndex, FunctionBodyData<'_>>,
+    ) -> Result<Compilation, CompileError> {
+        let calling_convention = self.check_target(target, &compile_info.features)?;
+
+        let module = &compile_info.module;
+        let pointer_width = target
+            .triple()
+            .pointer_width()
+            .map_err(|()| {
+                CompileError::UnsupportedTarget("target with unknown pointer width".into())
+            })?
+            .bytes();
+        let vmoffsets = VMOffsets::new(pointer_width).with_module_info(&module);
         let functions = function_body_inputs
             .iter()
             .collect::<Vec<(LocalFunctionIndex, &FunctionBodyData<'_>)>>()
             .into_par_iter_if_rayon()
             .map(|(i, input)| {
-                let reader = wasmer_compiler::FunctionReader::new(input.module_offset, input.data);
-
-                let mut generator = FuncGen::new(
-                    module,
+                self.compile_one(
+                    compile_info,
                     module_translation,
-                    &self.config,
                     &vmoffsets,
-                    &table_styles,
-                    i,
                     calling_convention,
+                    i,
+                    input,
+                    None,
                 )
-                .map_err(to_compile_error)?;
-
-                let mut local_reader = reader.get_locals_reader()?;
-                for _ in 0..local_reader.get_count() {
-                    let (count, ty) = local_reader.read()?;
-                    // Overflows feeding a local here have most likely already been caught by the
-                    // validator, but it is possible that the validator hasn't been run at all, or
-                    // that the validator does not impose any limits on the number of locals.
-                    generator.feed_local(count, ty);
-                }
+            })
+            .collect::<Result<Vec<CompiledFunction>, CompileError>>()?
+            .into_iter()
+            .collect::<PrimaryMap<LocalFunctionIndex, CompiledFunction>>();
 
-                generator.emit_head().map_err(to_compile_error)?;
+        Ok(self.finish_compilation(module, &vmoffsets, calling_convention, functions))
+    }
 
-                let mut operator_reader = reader.get_operators_reader()?.into_iter_with_offsets();
-                while generator.has_control_frames() {
-                    let (op, pos) = operator_reader.next().unwrap()?;
-                    generator.set_srcloc(pos as u32);
-                    generator.feed_operator(op).map_err(to_compile_error)?;
-                }
+    /// Compile the module while it is still being parsed: each function body
+    /// is handed to the rayon pool the moment the code-section reader yields
+    /// it, so parsing and `FuncGen` machine-code emission overlap.
+    #[cfg(feature = "rayon")]
+    fn compile_module_streaming<'data>(
+        &self,
+        target: &Target,
+        features: &Features,
+        data: &'data [u8],
+        styles: &(dyn Fn(
+            &ModuleInfo,
+        ) -> (
+            PrimaryMap<MemoryIndex, MemoryStyle>,
+            PrimaryMap<TableIndex, TableStyle>,
+        ) + Sync),
+    ) -> Result<StreamingCompilation<'data>, CompileError> {
+        let calling_convention = self.check_target(target, features)?;
+        let pointer_width = target
+            .triple()
+            .pointer_width()
+            .map_err(|()| {
+                CompileError::UnsupportedTarget("target with unknown pointer width".into())
+            })?
+            .bytes();
+
+        /// The codegen jobs in flight for one module, set up when the code
+        /// section starts.
+        struct Codegen {
+            compile_info: Arc<CompileModuleInfo>,
+            module_translation: Arc<ModuleTranslationState>,
+            vmoffsets: Arc<VMOffsets>,
+            results: Arc<Mutex<Vec<Option<Result<CompiledFunction, CompileError>>>>>,
+            next: usize,
+        }
 
-                Ok(generator.finalize(&input))
+        struct Sink<'a, 'b, 'scope> {
+            compiler: &'a SinglepassCompiler,
+            features: &'a Features,
+            styles: &'a (dyn Fn(
+                &ModuleInfo,
+            ) -> (
+                PrimaryMap<MemoryIndex, MemoryStyle>,
+                PrimaryMap<TableIndex, TableStyle>,
+            ) + Sync),
+            calling_convention: CallingConvention,
+            pointer_width: u8,
+            scope: &'b rayon::Scope<'scope>,
+            codegen: Option<Codegen>,
+        }
+
+        impl<'a: 'scope, 'b, 'scope, 'data: 'scope> TranslationSink<'data> for Sink<'a, 'b, 'scope> {
+            fn code_section_start(
+                &mut self,
+                module: &ModuleInfo,
+                _module_translation_state: &ModuleTranslationState,
+                count: u32,
+            ) -> WasmResult<()> {
+                // Everything `FuncGen` consults is final once the code section
+                // starts; only data, name and custom sections may still
+                // follow. Code generation therefore runs against a snapshot of
+                // the module, while the engine gets the fully translated one.
+                let module = Arc::new(module.clone());
+                let (memory_styles, table_styles) = (self.styles)(&module);
+                let vmoffsets =
+                    Arc::new(VMOffsets::new(self.pointer_width).with_module_info(&module));
+                let module_translation = Arc::new(ModuleTranslationState::from_module_info(&module));
+                self.codegen = Some(Codegen {
+                    compile_info: Arc::new(CompileModuleInfo {
+                        features: self.features.clone(),
+                        module,
+                        memory_styles,
+                        table_styles,
+                    }),
+                    module_translation,
+                    vmoffsets,
+                    results: Arc::new(Mutex::new((0..count).map(|_| None).collect())),
+                    next: 0,
+                });
+                Ok(())
+            }
+
+            fn function_body(
+                &mut self,
+                body: FunctionBodyData<'data>,
+                validator: Option<FuncValidator<ValidatorResources>>,
+            ) -> WasmResult<()> {
+                let codegen = self
+                    .codegen
+                    .as_mut()
+                    .expect("code section entry before the code section header");
+                let i = LocalFunctionIndex::new(codegen.next);
+                codegen.next += 1;
+                let compiler = self.compiler;
+                let calling_convention = self.calling_convention;
+                let compile_info = codegen.compile_info.clone();
+                let module_translation = codegen.module_translation.clone();
+                let vmoffsets = codegen.vmoffsets.clone();
+                let results = codegen.results.clone();
+                self.scope.spawn(move |_| {
+                    let result = compiler.compile_one(
+                        &compile_info,
+                        &module_translation,
+                        &vmoffsets,
+                        calling_convention,
+                        i,
+                        &body,
+                        validator,
+                    );
+                    results.lock().unwrap()[i.index()] = Some(result);
+                });
+                Ok(())
+            }
+        }
+
+        // `rayon::scope` waits for every spawned codegen job before
+        // returning, so by the time the scope ends the results are complete.
+        let mut codegen = None;
+        let translation = rayon::scope(
+            |scope| -> Result<ModuleEnvironment<'data>, CompileError> {
+                let mut sink = Sink {
+                    compiler: self,
+                    features,
+                    styles,
+                    calling_convention,
+                    pointer_width,
+                    scope,
+                    codegen: None,
+                };
+                // Validation is fused into the translation: the validator
+                // checks each section as it is parsed and each body's
+                // `FuncValidator` rides along into the codegen job, so no
+                // separate validation pass over the binary is needed.
+                let mut validator = Validator::new();
+                validator.wasm_features(wasmparser_features(features));
+                let environ = ModuleEnvironment::new();
+                let translation = environ
+                    .translate_streaming(data, &mut sink, Some(&mut validator))
+                    .map_err(|error| match error {
+                        // An invalid binary used to be reported by the
+                        // separate validation pass; keep surfacing it as a
+                        // validation error now that the pass is fused in.
+                        WasmError::InvalidWebAssembly { message, offset } => {
+                            CompileError::Validate(format!("{} (at offset {})", message, offset))
+                        }
+                        error => CompileError::Wasm(error),
+                    })?;
+                codegen = sink.codegen.take();
+                Ok(translation)
+            },
+        )?;
+
+        let functions = match codegen {
+            Some(codegen) => {
+                let results = std::mem::take(&mut *codegen.results.lock().unwrap());
+                results
+                    .into_iter()
+                    .map(|result| {
+                        result.expect("code section declared more bodies than it contains")
+                    })
+                    .collect::<Result<Vec<CompiledFunction>, CompileError>>()?
+                    .into_iter()
+                    .collect::<PrimaryMap<LocalFunctionIndex, CompiledFunction>>()
+            }
+            None => PrimaryMap::new(),
+        };
+
+        let (memory_styles, table_styles) = styles(&translation.module);
+        let module = Arc::new(translation.module);
+        let vmoffsets = VMOffsets::new(pointer_width).with_module_info(&module);
+        let compilation =
+            self.finish_compilation(&module, &vmoffsets, calling_convention, functions);
+        Ok(StreamingCompilation {
+            info: CompileModuleInfo {
+                features: features.clone(),
+                module,
+                memory_styles,
+                table_styles,
+            },
+            data_initializers: translation.data_initializers,
+            compilation,
+        })
+    }
+
+    /// Compile the module, but emit a lazy compilation stub in place of every
+    /// function body. The real bodies are produced one at a time by
+    /// [`Compiler::compile_function`], on first call.
+    fn compile_module_lazily(
+        &self,
+        target: &Target,
+        compile_info: &CompileModuleInfo,
+        _module_translation: &ModuleTranslationState,
+        function_body_inputs: &PrimaryMap<LocalFunctionIndex, FunctionBodyData<'_>>,
+    ) -> Result<(Compilation, LazySections), CompileError> {
+        let calling_convention = self.check_target(target, &compile_info.features)?;
+        if calling_convention != CallingConvention::SystemV {
+            return Err(CompileError::UnsupportedTarget(
+                "lazy compilation requires the System V calling convention".to_string(),
+            ));
+        }
+
+        let module = &compile_info.module;
+        let pointer_width = target
+            .triple()
+            .pointer_width()
+            .map_err(|()| {
+                CompileError::UnsupportedTarget("target with unknown pointer width".into())
+            })?
+            .bytes();
+        let vmoffsets = VMOffsets::new(pointer_width).with_module_info(&module);
+        let import_idxs = 0..module.import_counts.functions as usize;
+        let mut custom_sections: PrimaryMap<SectionIndex, _> = import_idxs
+            .into_par_iter_if_rayon()
+            .map(|i| {
+                let i = FunctionIndex::new(i);
+                gen_import_call_trampoline(
+                    &vmoffsets,
+                    i,
+                    &module.signatures[module.functions[i]],
+                    calling_convention,
+                )
             })
-            .collect::<Result<Vec<CompiledFunction>, CompileError>>()?
+            .collect::<Vec<_>>()
             .into_iter()
+            .collect();
+
+        // One body address slot per local function, zero-initialized. The
+        // section is classified as data by the engine and so stays writable
+        // after the code is published; `wasmer_vm_lazy_compile` fills the
+        // slots in as bodies get compiled.
+        let slots_section = custom_sections.push(CustomSection {
+            protection: CustomSectionProtection::Read,
+            bytes: SectionBody::new_with_vec(vec![0u8; function_body_inputs.len() * 8]),
+            relocations: vec![],
+        });
+        // One invocation counter per local function, bumped by the stubs and
+        // consumed by the engine's tier-up monitor.
+        let counters_section = custom_sections.push(CustomSection {
+            protection: CustomSectionProtection::Read,
+            bytes: SectionBody::new_with_vec(vec![0u8; function_body_inputs.len() * 8]),
+            relocations: vec![],
+        });
+        let lazy_sections = LazySections {
+            slots: slots_section,
+            counters: counters_section,
+        };
+
+        let functions = function_body_inputs
+            .keys()
+            .map(|i| gen_lazy_compile_stub(i, lazy_sections, calling_convention))
             .collect::<PrimaryMap<LocalFunctionIndex, CompiledFunction>>();
 
         let function_call_trampolines = module
@@ -162,15 +532,63 @@ impl Compiler for SinglepassCompiler {
             .into_iter()
             .collect::<PrimaryMap<FunctionIndex, FunctionBody>>();
 
-        Ok(Compilation::new(
-            functions,
-            import_trampolines,
-            function_call_trampolines,
-            dynamic_function_trampolines,
-            None,
-            None,
+        Ok((
+            Compilation::new(
+                functions,
+                custom_sections,
+                function_call_trampolines,
+                dynamic_function_trampolines,
+                None,
+                None,
+            ),
+            lazy_sections,
         ))
     }
+
+    /// Compile a single function body, for lazy compilation.
+    fn compile_function(
+        &self,
+        target: &Target,
+        compile_info: &CompileModuleInfo,
+        module_translation: &ModuleTranslationState,
+        index: LocalFunctionIndex,
+        function_body: &FunctionBodyData<'_>,
+    ) -> Result<CompiledFunction, CompileError> {
+        let calling_convention = self.check_target(target, &compile_info.features)?;
+        let pointer_width = target
+            .triple()
+            .pointer_width()
+            .map_err(|()| {
+                CompileError::UnsupportedTarget("target with unknown pointer width".into())
+            })?
+            .bytes();
+        let vmoffsets = VMOffsets::new(pointer_width).with_module_info(&compile_info.module);
+        self.compile_one(
+            compile_info,
+            module_translation,
+            &vmoffsets,
+            calling_convention,
+            index,
+            function_body,
+            None,
+        )
+    }
+
+    /// The streaming path above validates the module as it compiles it, so no
+    /// separate validation pass is needed; without rayon the default two-pass
+    /// `compile_module_streaming` runs instead.
+    fn validates_while_compiling(&self) -> bool {
+        cfg!(feature = "rayon")
+    }
+
+    /// A digest of every Singlepass option that shapes the generated code:
+    /// NaN canonicalization, stack checks, gas consolidation, epoch
+    /// interruption and the intrinsics list.
+    fn config_digest(&self) -> String {
+        // `Debug` covers every field, including the intrinsics' names and
+        // signatures, and naturally invalidates old keys when one is added.
+        format!("{:?}", self.config)
+    }
 }
 
 trait ToCompileError {
@@ -187,6 +605,12 @@ fn to_compile_error<T: ToCompileError>(x: T) -> CompileError {
     x.to_compile_error()
 }
 
+/// Reports a fused-validation failure the way the standalone
+/// [`validate_module`](Compiler::validate_module) pass would.
+fn to_validate_error(error: wasmer_compiler::wasmparser::BinaryReaderError) -> CompileError {
+    CompileError::Validate(format!("{}", error))
+}
+
 trait IntoParIterIfRayon {
     type Output;
     fn into_par_iter_if_rayon(self) -> Self::Output;
@@ -24,6 +24,8 @@ pub(crate) struct Intrinsic {
 pub struct Singlepass {
     pub(crate) enable_nan_canonicalization: bool,
     pub(crate) enable_stack_check: bool,
+    pub(crate) consolidate_gas_charges: bool,
+    pub(crate) epoch_interruption: bool,
     /// Compiler intrinsics.
     pub(crate) intrinsics: Vec<Intrinsic>,
 }
@@ -35,6 +37,8 @@ impl Singlepass {
         Self {
             enable_nan_canonicalization: true,
             enable_stack_check: false,
+            consolidate_gas_charges: false,
+            epoch_interruption: false,
             intrinsics: vec![Intrinsic {
                 kind: IntrinsicKind::Gas,
                 name: "gas".to_string(),
@@ -55,6 +59,33 @@ impl Singlepass {
         self
     }
 
+    /// Consolidate gas charges within straight-line code.
+    ///
+    /// When enabled, consecutive gas intrinsic calls with constant arguments
+    /// are summed up and charged with a single counter update per
+    /// straight-line region instead of one per call site. The consolidated
+    /// charge is emitted at the next control flow boundary (branch, block
+    /// boundary or call), so the gas burnt observed at any such boundary is
+    /// exactly what the individual charges would have accumulated; only a
+    /// trap in the middle of a region can observe a lower value.
+    pub fn consolidate_gas_charges(&mut self, enable: bool) -> &mut Self {
+        self.consolidate_gas_charges = enable;
+        self
+    }
+
+    /// Check the shared epoch counter at loop headers and call sites.
+    ///
+    /// When enabled, the emitted code compares the epoch counter configured
+    /// through `InstanceConfig::with_epoch` against the instance's deadline
+    /// at every loop iteration and function call, trapping with
+    /// `TrapCode::DeadlineExceeded` once the deadline has passed. Bumping
+    /// the counter from a timer thread bounds runtime at a fraction of the
+    /// cost of per-instruction gas accounting, at the price of determinism.
+    pub fn epoch_interruption(&mut self, enable: bool) -> &mut Self {
+        self.epoch_interruption = enable;
+        self
+    }
+
     fn enable_nan_canonicalization(&mut self) {
         self.enable_nan_canonicalization = true;
     }
@@ -140,6 +140,68 @@ pub(crate) trait Emitter {
     fn emit_vxorps(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
     fn emit_vxorpd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
 
+    fn emit_vmovdqu(&mut self, src: XMMOrMemory, dst: XMMOrMemory);
+
+    fn emit_vpaddb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddq(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddsb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddsw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddusb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpaddusw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubq(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubsb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubsw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubusb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpsubusw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmullw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmulld(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpminsb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpminub(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpminsw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpminuw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpminsd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpminud(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmaxsb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmaxub(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmaxsw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmaxuw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmaxsd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpmaxud(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpavgb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpavgw(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpand(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpor(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpxor(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpandn(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpshufb(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vpcmpeqd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vaddps(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vaddpd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vsubps(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vsubpd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vmulps(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vmulpd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vdivps(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vdivpd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
+    fn emit_vsqrtps(&mut self, src: XMMOrMemory, dst: XMM);
+    fn emit_vsqrtpd(&mut self, src: XMMOrMemory, dst: XMM);
+
+    fn emit_vpshufd(&mut self, imm: u8, src: XMMOrMemory, dst: XMM);
+    fn emit_vpshuflw(&mut self, imm: u8, src: XMM, dst: XMM);
+    fn emit_vpextrb(&mut self, lane: u8, src: XMM, dst: GPR);
+    fn emit_vpextrw(&mut self, lane: u8, src: XMM, dst: GPR);
+    fn emit_vpextrd(&mut self, lane: u8, src: XMM, dst: GPR);
+    fn emit_vpextrq(&mut self, lane: u8, src: XMM, dst: GPR);
+    fn emit_vpinsrb(&mut self, lane: u8, src: GPR, dst: XMM);
+    fn emit_vpinsrw(&mut self, lane: u8, src: GPR, dst: XMM);
+    fn emit_vpinsrd(&mut self, lane: u8, src: GPR, dst: XMM);
+    fn emit_vpinsrq(&mut self, lane: u8, src: GPR, dst: XMM);
+
     fn emit_vaddss(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
     fn emit_vaddsd(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
     fn emit_vsubss(&mut self, src1: XMM, src2: XMMOrMemory, dst: XMM);
@@ -1309,6 +1371,131 @@ impl Emitter for Assembler {
     avx_i2f_64_fn!(vcvtsi2ss, emit_vcvtsi2ss_64);
     avx_i2f_64_fn!(vcvtsi2sd, emit_vcvtsi2sd_64);
 
+    fn emit_vmovdqu(&mut self, src: XMMOrMemory, dst: XMMOrMemory) {
+        match (src, dst) {
+            (XMMOrMemory::XMM(src), XMMOrMemory::XMM(dst)) => {
+                dynasm!(self ; movdqu Rx(dst as u8), Rx(src as u8))
+            }
+            (XMMOrMemory::Memory(base, disp), XMMOrMemory::XMM(dst)) => {
+                dynasm!(self ; movdqu Rx(dst as u8), [Rq(base as u8) + disp])
+            }
+            (XMMOrMemory::XMM(src), XMMOrMemory::Memory(base, disp)) => {
+                dynasm!(self ; movdqu [Rq(base as u8) + disp], Rx(src as u8))
+            }
+            _ => panic!("singlepass can't emit VMOVDQU {:?} {:?}", src, dst),
+        };
+    }
+
+    avx_fn!(vpaddb, emit_vpaddb);
+    avx_fn!(vpaddw, emit_vpaddw);
+    avx_fn!(vpaddd, emit_vpaddd);
+    avx_fn!(vpaddq, emit_vpaddq);
+    avx_fn!(vpaddsb, emit_vpaddsb);
+    avx_fn!(vpaddsw, emit_vpaddsw);
+    avx_fn!(vpaddusb, emit_vpaddusb);
+    avx_fn!(vpaddusw, emit_vpaddusw);
+    avx_fn!(vpsubb, emit_vpsubb);
+    avx_fn!(vpsubw, emit_vpsubw);
+    avx_fn!(vpsubd, emit_vpsubd);
+    avx_fn!(vpsubq, emit_vpsubq);
+    avx_fn!(vpsubsb, emit_vpsubsb);
+    avx_fn!(vpsubsw, emit_vpsubsw);
+    avx_fn!(vpsubusb, emit_vpsubusb);
+    avx_fn!(vpsubusw, emit_vpsubusw);
+    avx_fn!(vpmullw, emit_vpmullw);
+    avx_fn!(vpmulld, emit_vpmulld);
+    avx_fn!(vpminsb, emit_vpminsb);
+    avx_fn!(vpminub, emit_vpminub);
+    avx_fn!(vpminsw, emit_vpminsw);
+    avx_fn!(vpminuw, emit_vpminuw);
+    avx_fn!(vpminsd, emit_vpminsd);
+    avx_fn!(vpminud, emit_vpminud);
+    avx_fn!(vpmaxsb, emit_vpmaxsb);
+    avx_fn!(vpmaxub, emit_vpmaxub);
+    avx_fn!(vpmaxsw, emit_vpmaxsw);
+    avx_fn!(vpmaxuw, emit_vpmaxuw);
+    avx_fn!(vpmaxsd, emit_vpmaxsd);
+    avx_fn!(vpmaxud, emit_vpmaxud);
+    avx_fn!(vpavgb, emit_vpavgb);
+    avx_fn!(vpavgw, emit_vpavgw);
+    avx_fn!(vpand, emit_vpand);
+    avx_fn!(vpor, emit_vpor);
+    avx_fn!(vpxor, emit_vpxor);
+    avx_fn!(vpandn, emit_vpandn);
+    avx_fn!(vpshufb, emit_vpshufb);
+    avx_fn!(vpcmpeqd, emit_vpcmpeqd);
+    avx_fn!(vaddps, emit_vaddps);
+    avx_fn!(vaddpd, emit_vaddpd);
+    avx_fn!(vsubps, emit_vsubps);
+    avx_fn!(vsubpd, emit_vsubpd);
+    avx_fn!(vmulps, emit_vmulps);
+    avx_fn!(vmulpd, emit_vmulpd);
+    avx_fn!(vdivps, emit_vdivps);
+    avx_fn!(vdivpd, emit_vdivpd);
+
+    fn emit_vsqrtps(&mut self, src: XMMOrMemory, dst: XMM) {
+        match src {
+            XMMOrMemory::XMM(x) => dynasm!(self ; vsqrtps Rx(dst as u8), Rx(x as u8)),
+            XMMOrMemory::Memory(base, disp) => {
+                dynasm!(self ; vsqrtps Rx(dst as u8), [Rq(base as u8) + disp])
+            }
+        }
+    }
+
+    fn emit_vsqrtpd(&mut self, src: XMMOrMemory, dst: XMM) {
+        match src {
+            XMMOrMemory::XMM(x) => dynasm!(self ; vsqrtpd Rx(dst as u8), Rx(x as u8)),
+            XMMOrMemory::Memory(base, disp) => {
+                dynasm!(self ; vsqrtpd Rx(dst as u8), [Rq(base as u8) + disp])
+            }
+        }
+    }
+
+    fn emit_vpshufd(&mut self, imm: u8, src: XMMOrMemory, dst: XMM) {
+        match src {
+            XMMOrMemory::XMM(x) => dynasm!(self ; vpshufd Rx(dst as u8), Rx(x as u8), imm as i8),
+            XMMOrMemory::Memory(base, disp) => {
+                dynasm!(self ; vpshufd Rx(dst as u8), [Rq(base as u8) + disp], imm as i8)
+            }
+        }
+    }
+
+    fn emit_vpshuflw(&mut self, imm: u8, src: XMM, dst: XMM) {
+        dynasm!(self ; vpshuflw Rx(dst as u8), Rx(src as u8), imm as i8);
+    }
+
+    fn emit_vpextrb(&mut self, lane: u8, src: XMM, dst: GPR) {
+        dynasm!(self ; vpextrb Rd(dst as u8), Rx(src as u8), lane as i8);
+    }
+
+    fn emit_vpextrw(&mut self, lane: u8, src: XMM, dst: GPR) {
+        dynasm!(self ; vpextrw Rd(dst as u8), Rx(src as u8), lane as i8);
+    }
+
+    fn emit_vpextrd(&mut self, lane: u8, src: XMM, dst: GPR) {
+        dynasm!(self ; vpextrd Rd(dst as u8), Rx(src as u8), lane as i8);
+    }
+
+    fn emit_vpextrq(&mut self, lane: u8, src: XMM, dst: GPR) {
+        dynasm!(self ; vpextrq Rq(dst as u8), Rx(src as u8), lane as i8);
+    }
+
+    fn emit_vpinsrb(&mut self, lane: u8, src: GPR, dst: XMM) {
+        dynasm!(self ; vpinsrb Rx(dst as u8), Rx(dst as u8), Rd(src as u8), lane as i8);
+    }
+
+    fn emit_vpinsrw(&mut self, lane: u8, src: GPR, dst: XMM) {
+        dynasm!(self ; vpinsrw Rx(dst as u8), Rx(dst as u8), Rd(src as u8), lane as i8);
+    }
+
+    fn emit_vpinsrd(&mut self, lane: u8, src: GPR, dst: XMM) {
+        dynasm!(self ; vpinsrd Rx(dst as u8), Rx(dst as u8), Rd(src as u8), lane as i8);
+    }
+
+    fn emit_vpinsrq(&mut self, lane: u8, src: GPR, dst: XMM) {
+        dynasm!(self ; vpinsrq Rx(dst as u8), Rx(dst as u8), Rq(src as u8), lane as i8);
+    }
+
     fn emit_vblendvps(&mut self, src1: XMM, src2: XMMOrMemory, mask: XMM, dst: XMM) {
         match src2 {
             XMMOrMemory::XMM(src2) => {
@@ -18,6 +18,12 @@ pub(crate) struct Machine {
     ///
     /// Populated in `init_locals`.
     locals_offset: MachineStackOffset,
+    /// Number of leading local slots that live in callee-saved registers.
+    ///
+    /// Populated in `init_locals`. Functions with `v128` locals set this to
+    /// zero, since a 128-bit value cannot live in a GPR and keeping every
+    /// local on the stack makes the two-slot layout of `v128` locals uniform.
+    reg_local_count: usize,
 }
 
 impl Machine {
@@ -28,6 +34,7 @@ impl Machine {
             stack_offset: MachineStackOffset(0),
             save_area_offset: None,
             locals_offset: MachineStackOffset(0),
+            reg_local_count: 0,
         }
     }
 
@@ -102,10 +109,18 @@ impl Machine {
 
     /// Picks an unused XMM register.
     ///
+    /// The pool covers every XMM register that is neither reserved as a
+    /// temporary (XMM0..=XMM2) nor used as fixed scratch by the float
+    /// min/max sequences (XMM8..=XMM10), so float-heavy operand stacks stay
+    /// in registers for up to 10 live values before anything spills to
+    /// memory.
+    ///
     /// This method does not mark the register as used.
     pub(crate) fn pick_xmm(&self) -> Option<XMM> {
         use XMM::*;
-        static REGS: &[XMM] = &[XMM3, XMM4, XMM5, XMM6, XMM7];
+        static REGS: &[XMM] = &[
+            XMM3, XMM4, XMM5, XMM6, XMM7, XMM11, XMM12, XMM13, XMM14, XMM15,
+        ];
         for r in REGS {
             if !self.used_xmms.contains(r) {
                 return Some(*r);
@@ -157,7 +172,7 @@ impl Machine {
 
         for ty in tys {
             let loc = match *ty {
-                WpType::F32 | WpType::F64 => self.pick_xmm().map(Location::XMM),
+                WpType::F32 | WpType::F64 | WpType::V128 => self.pick_xmm().map(Location::XMM),
                 WpType::I32 | WpType::I64 => self.pick_gpr().map(Location::GPR),
                 WpType::FuncRef | WpType::ExternRef => self.pick_gpr().map(Location::GPR),
                 _ => unreachable!("can't acquire location for type {:?}", ty),
@@ -306,6 +321,10 @@ impl Machine {
 
     const LOCAL_REGISTERS: &'static [GPR] = &[GPR::R12, GPR::R13, GPR::R14, GPR::RBX];
 
+    /// Returns the location of a local slot.
+    ///
+    /// `idx` counts 8-byte slots, not wasm locals: a `v128` local occupies two
+    /// consecutive slots and is addressed through the first one.
     pub(crate) fn get_local_location(&self, idx: u32) -> Location {
         // NB: This calculation cannot reasonably overflow. `self.locals_offset` will typically be
         // small (< 32), and `idx` is bounded to `51000` due to limits imposed by the wasmparser
@@ -315,34 +334,47 @@ impl Machine {
             idx <= 999_999,
             "this runtime can't deal with unreasonable number of locals"
         );
-        Self::LOCAL_REGISTERS
-            .get(idx as usize)
-            .map(|r| Location::GPR(*r))
-            .unwrap_or_else(|| {
-                let local_offset = idx
-                    .checked_sub(Self::LOCAL_REGISTERS.len() as u32)
-                    .unwrap()
-                    .wrapping_mul(8);
-                Location::Memory(
-                    GPR::RBP,
-                    (local_offset.wrapping_add(self.locals_offset.0 as u32) as i32).wrapping_neg(),
-                )
-            })
+        if (idx as usize) < self.reg_local_count {
+            Location::GPR(Self::LOCAL_REGISTERS[idx as usize])
+        } else {
+            let local_offset = idx
+                .checked_sub(self.reg_local_count as u32)
+                .unwrap()
+                .wrapping_mul(8);
+            Location::Memory(
+                GPR::RBP,
+                (local_offset.wrapping_add(self.locals_offset.0 as u32) as i32).wrapping_neg(),
+            )
+        }
     }
 
+    /// Sets up the local slots for a function.
+    ///
+    /// `n` counts 8-byte slots (a `v128` local contributes two of them) and
+    /// `n_params` is the number of wasm parameters, which always occupy the
+    /// leading slots one-to-one. When `simd_locals` is set, no local is
+    /// allocated to a register: `v128` locals only fit on the stack and mixing
+    /// the two allocation schemes is not worth the complexity.
     pub(crate) fn init_locals<E: Emitter>(
         &mut self,
         a: &mut E,
         n: u32,
         n_params: u32,
+        simd_locals: bool,
         calling_convention: CallingConvention,
     ) {
+        self.reg_local_count = if simd_locals {
+            0
+        } else {
+            std::cmp::min(Self::LOCAL_REGISTERS.len(), n as usize)
+        };
+
         // Total size (in bytes) of the pre-allocated "static area" for this function's
         // locals and callee-saved registers.
         let mut static_area_size: usize = 0;
 
         // Space to clobber registers used for locals.
-        static_area_size += 8 * std::cmp::min(Self::LOCAL_REGISTERS.len(), n as usize);
+        static_area_size += 8 * self.reg_local_count;
 
         // Callee-saved R15 for vmctx.
         static_area_size += 8;
@@ -356,7 +388,7 @@ impl Machine {
         // the end address of the 0th local, not at the start address, so we add `8` bytes to fix
         // this up.
         self.locals_offset = MachineStackOffset(static_area_size + 8);
-        let locals_size = (n as usize).saturating_sub(Self::LOCAL_REGISTERS.len()) * 8;
+        let locals_size = (n as usize).saturating_sub(self.reg_local_count) * 8;
 
         // Allocate the stack, without actually writing to it.
         a.emit_sub(
@@ -366,7 +398,7 @@ impl Machine {
         );
 
         // Save callee-saved registers
-        for local_reg in Self::LOCAL_REGISTERS.iter().take(n as usize) {
+        for local_reg in Self::LOCAL_REGISTERS.iter().take(self.reg_local_count) {
             self.stack_offset.0 += 8;
             a.emit_mov(
                 Size::S64,
@@ -446,13 +478,13 @@ impl Machine {
         // First: handle the locals that are allocated to registers...
         for local_reg_idx in Self::LOCAL_REGISTERS
             .iter()
+            .take(self.reg_local_count)
             .skip(n_params as usize)
-            .take((n_params..n).len())
         {
             a.emit_mov(Size::S64, Location::Imm32(0), Location::GPR(*local_reg_idx));
         }
         // Second: handle the locals that are allocated to the stack.
-        let stack_loc_idxs = std::cmp::max(Self::LOCAL_REGISTERS.len() as u32, n_params)..n;
+        let stack_loc_idxs = std::cmp::max(self.reg_local_count as u32, n_params)..n;
         if stack_loc_idxs.len() > 0 {
             // Since these assemblies take up to 24 bytes, if more than 2 slots are initialized, then they are smaller.
             a.emit_mov(
@@ -477,7 +509,6 @@ impl Machine {
         &mut self,
         a: &mut E,
         calling_convention: CallingConvention,
-        local_count: u32,
     ) {
         // Unwind stack to the "save area".
         a.emit_lea(
@@ -500,7 +531,7 @@ impl Machine {
         // Restore callee-saved registers that we used for locals.
         for reg in Self::LOCAL_REGISTERS
             .iter()
-            .take(local_count as usize)
+            .take(self.reg_local_count)
             .rev()
         {
             a.emit_pop(Size::S64, Location::GPR(*reg));
@@ -551,4 +582,21 @@ mod test {
 
         machine.release_locations_keep_state(&mut assembler, &locs);
     }
+
+    #[test]
+    fn test_float_stack_values_fill_xmm_pool() {
+        let mut machine = Machine::new();
+        let mut assembler = Assembler::new(0);
+        let locs = machine.acquire_locations(
+            &mut assembler,
+            &(0..11).map(|_| WpType::F64).collect::<Vec<_>>(),
+            false,
+        );
+
+        // The first 10 values stay in XMM registers; only the 11th spills.
+        for loc in &locs[..10] {
+            assert!(matches!(loc, Location::XMM(_)));
+        }
+        assert!(matches!(locs[10], Location::Memory(..)));
+    }
 }
@@ -2,17 +2,42 @@
 //! compilers will need to implement.
 
 use crate::error::CompileError;
-use crate::function::Compilation;
+use crate::function::{Compilation, CompiledFunction};
 use crate::lib::std::boxed::Box;
+use crate::lib::std::sync::Arc;
+use crate::lib::std::vec::Vec;
 use crate::module::CompileModuleInfo;
 use crate::target::Target;
 use crate::FunctionBodyData;
+use crate::ModuleEnvironment;
 use crate::ModuleTranslationState;
 use crate::SectionIndex;
 use wasmer_types::entity::PrimaryMap;
-use wasmer_types::{Features, FunctionIndex, LocalFunctionIndex, SignatureIndex};
+use wasmer_types::{
+    DataInitializer, Features, FunctionIndex, LocalFunctionIndex, MemoryIndex, ModuleInfo,
+    SignatureIndex, TableIndex,
+};
+use wasmer_vm::{MemoryStyle, TableStyle};
 use wasmparser::{Validator, WasmFeatures};
 
+/// Maps the [`Features`] of a compilation onto the feature set understood by
+/// the `wasmparser` validator.
+pub fn wasmparser_features(features: &Features) -> WasmFeatures {
+    WasmFeatures {
+        bulk_memory: features.bulk_memory,
+        threads: features.threads,
+        reference_types: features.reference_types,
+        multi_value: features.multi_value,
+        simd: features.simd,
+        tail_call: features.tail_call,
+        module_linking: features.module_linking,
+        multi_memory: features.multi_memory,
+        memory64: features.memory64,
+        exceptions: features.exceptions,
+        deterministic_only: false,
+    }
+}
+
 /// The compiler configuration options.
 pub trait CompilerConfig {
     /// Enable Position Independent Code (PIC).
@@ -72,7 +97,10 @@ where
 }
 
 /// An implementation of a Compiler from parsed WebAssembly module to Compiled native code.
-pub trait Compiler: Send {
+///
+/// Compilers only hold configuration, so a single compiler can be shared by
+/// every thread that compiles modules through an engine.
+pub trait Compiler: Send + Sync {
     /// Validates a module.
     ///
     /// It returns the a succesful Result in case is valid, `CompileError` in case is not.
@@ -82,26 +110,39 @@ pub trait Compiler: Send {
         data: &'data [u8],
     ) -> Result<(), CompileError> {
         let mut validator = Validator::new();
-        let wasm_features = WasmFeatures {
-            bulk_memory: features.bulk_memory,
-            threads: features.threads,
-            reference_types: features.reference_types,
-            multi_value: features.multi_value,
-            simd: features.simd,
-            tail_call: features.tail_call,
-            module_linking: features.module_linking,
-            multi_memory: features.multi_memory,
-            memory64: features.memory64,
-            exceptions: features.exceptions,
-            deterministic_only: false,
-        };
-        validator.wasm_features(wasm_features);
+        validator.wasm_features(wasmparser_features(features));
         validator
             .validate_all(data)
             .map_err(|e| CompileError::Validate(format!("{}", e)))?;
         Ok(())
     }
 
+    /// Whether [`compile_module_streaming`](Self::compile_module_streaming)
+    /// validates the binary while compiling it.
+    ///
+    /// When this returns `true`, engines can skip the separate
+    /// [`validate_module`](Self::validate_module) pass before compiling: each
+    /// function body is decoded exactly once, validated and compiled in the
+    /// same traversal. The default two-pass implementation of
+    /// `compile_module_streaming` does not validate, so this defaults to
+    /// `false`.
+    fn validates_while_compiling(&self) -> bool {
+        false
+    }
+
+    /// A digest of every configuration option that changes the code this
+    /// compiler generates, for keying compilation caches.
+    ///
+    /// Two compilers whose digests are equal must generate identical code
+    /// for the same binary, target and features; compilers with any
+    /// code-shaping configuration (optimization toggles, instrumentation,
+    /// intrinsics) must override this, or differently configured engines
+    /// sharing a cache would serve each other's artifacts. The default
+    /// covers compilers with no such configuration.
+    fn config_digest(&self) -> String {
+        String::new()
+    }
+
     /// Compiles a parsed module.
     ///
     /// It returns the [`Compilation`] or a [`CompileError`].
@@ -114,6 +155,96 @@ pub trait Compiler: Send {
         function_body_inputs: PrimaryMap<LocalFunctionIndex, FunctionBodyData<'data>>,
     ) -> Result<Compilation, CompileError>;
 
+    /// Compiles a wasm binary while it is being parsed, overlapping the
+    /// translation of the module with machine-code emission.
+    ///
+    /// `styles` produces the memory and table styles the module is to be
+    /// compiled with; it is called once the sections defining the memories
+    /// and tables have been translated. The default implementation parses the
+    /// whole binary before handing the bodies to
+    /// [`compile_module`](Self::compile_module); compilers can override it to
+    /// start generating code as soon as the code section streams in.
+    fn compile_module_streaming<'data>(
+        &self,
+        target: &Target,
+        features: &Features,
+        data: &'data [u8],
+        styles: &(dyn Fn(
+            &ModuleInfo,
+        ) -> (
+            PrimaryMap<MemoryIndex, MemoryStyle>,
+            PrimaryMap<TableIndex, TableStyle>,
+        ) + Sync),
+    ) -> Result<StreamingCompilation<'data>, CompileError> {
+        let environ = ModuleEnvironment::new();
+        let translation = environ.translate(data).map_err(CompileError::Wasm)?;
+        let (memory_styles, table_styles) = styles(&translation.module);
+        let compile_info = CompileModuleInfo {
+            module: Arc::new(translation.module),
+            features: features.clone(),
+            memory_styles,
+            table_styles,
+        };
+        // SAFETY: Calling `unwrap` is correct since `environ.translate()`
+        // above will write some data into `module_translation_state`.
+        let module_translation_state = translation.module_translation_state.as_ref().unwrap();
+        let compilation = self.compile_module(
+            target,
+            &compile_info,
+            module_translation_state,
+            translation.function_body_inputs,
+        )?;
+        Ok(StreamingCompilation {
+            info: compile_info,
+            data_initializers: translation.data_initializers,
+            compilation,
+        })
+    }
+
+    /// Compiles a parsed module, but defers the compilation of the function
+    /// bodies to their first call.
+    ///
+    /// The returned [`Compilation`] contains a stub in place of every function
+    /// body. The stub bumps the function's invocation counter, then transfers
+    /// control to the `wasmer_vm_lazy_compile` libcall which compiles the one
+    /// body via [`Compiler::compile_function`], caches the resulting address
+    /// and tail-calls it. The [`LazySections`] returned alongside locate the
+    /// (read-write) custom sections consulted by the stubs.
+    ///
+    /// Compilers that cannot emit such stubs report `CompileError::Unsupported`.
+    fn compile_module_lazily<'data, 'module>(
+        &self,
+        _target: &Target,
+        _module: &'module CompileModuleInfo,
+        _module_translation: &ModuleTranslationState,
+        // The list of function bodies. Only the signatures matter here; the
+        // bodies themselves are compiled later, one by one, through
+        // `compile_function`.
+        _function_body_inputs: &PrimaryMap<LocalFunctionIndex, FunctionBodyData<'data>>,
+    ) -> Result<(Compilation, LazySections), CompileError> {
+        Err(CompileError::UnsupportedFeature(
+            "lazy compilation".to_string(),
+        ))
+    }
+
+    /// Compiles a single function body.
+    ///
+    /// This is the slow half of the lazy compilation scheme set up by
+    /// [`Compiler::compile_module_lazily`] and is only required of compilers
+    /// that support it.
+    fn compile_function<'data, 'module>(
+        &self,
+        _target: &Target,
+        _module: &'module CompileModuleInfo,
+        _module_translation: &ModuleTranslationState,
+        _index: LocalFunctionIndex,
+        _function_body: &FunctionBodyData<'data>,
+    ) -> Result<CompiledFunction, CompileError> {
+        Err(CompileError::UnsupportedFeature(
+            "lazy compilation".to_string(),
+        ))
+    }
+
     /// Compiles a module into a native object file.
     ///
     /// It returns the bytes as a `&[u8]` or a [`CompileError`].
@@ -132,6 +263,33 @@ pub trait Compiler: Send {
     }
 }
 
+/// The result of [`Compiler::compile_module_streaming`].
+pub struct StreamingCompilation<'data> {
+    /// The compilation environment, wrapping the fully translated module.
+    pub info: CompileModuleInfo,
+    /// References to the data initializers in the wasm binary.
+    pub data_initializers: Vec<DataInitializer<'data>>,
+    /// The compiled module.
+    pub compilation: Compilation,
+}
+
+/// The custom sections produced by [`Compiler::compile_module_lazily`] for the
+/// book-keeping of the compilation stubs.
+///
+/// Both are read-write at run time: the stubs bump the counters and consult
+/// the slots on every call, and the engine fills the slots in as function
+/// bodies get compiled.
+#[derive(Clone, Copy, Debug)]
+pub struct LazySections {
+    /// One body address per local function, 0 while not yet compiled.
+    pub slots: SectionIndex,
+    /// One invocation count per local function.
+    ///
+    /// The counters are bumped with plain (non-atomic) adds; they are a
+    /// heuristic for tier-up decisions, not an exact count.
+    pub counters: SectionIndex,
+}
+
 /// The kinds of wasmer_types objects that might be found in a native object file.
 #[derive(Clone, Debug, PartialEq, Eq)]
 pub enum Symbol {
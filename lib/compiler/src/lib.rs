@@ -68,7 +68,10 @@ mod sourceloc;
 
 pub use crate::address_map::{FunctionAddressMap, InstructionAddressMap};
 #[cfg(feature = "translator")]
-pub use crate::compiler::{Compiler, CompilerConfig, Symbol, SymbolRegistry};
+pub use crate::compiler::{
+    wasmparser_features, Compiler, CompilerConfig, LazySections, StreamingCompilation, Symbol,
+    SymbolRegistry,
+};
 pub use crate::error::{
     CompileError, MiddlewareError, ParseCpuFeatureError, WasmError, WasmResult,
 };
@@ -89,7 +92,8 @@ pub use crate::target::{
 };
 #[cfg(feature = "translator")]
 pub use crate::translator::{
-    translate_module, wptype_to_type, FunctionBodyData, FunctionReader, ModuleEnvironment,
+    translate_module, translate_module_streaming, wptype_to_type, FunctionBodyData,
+    FunctionReader, ModuleEnvironment, TranslationSink,
     ModuleTranslationState,
 };
 pub use crate::trap::TrapInformation;
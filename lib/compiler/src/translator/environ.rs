@@ -66,6 +66,25 @@ impl<'data> ModuleEnvironment<'data> {
         Ok(self)
     }
 
+    /// Like [`translate`](Self::translate), but hands each function body to
+    /// `sink` as it is parsed, so that code generation can overlap with the
+    /// translation of the rest of the module.
+    ///
+    /// When `validator` is provided, the module is validated in the same
+    /// traversal; see [`translate_module_streaming`](crate::translate_module_streaming).
+    pub fn translate_streaming(
+        mut self,
+        data: &'data [u8],
+        sink: &mut dyn super::module::TranslationSink<'data>,
+        validator: Option<&mut wasmparser::Validator>,
+    ) -> WasmResult<ModuleEnvironment<'data>> {
+        assert!(self.module_translation_state.is_none());
+        let module_translation_state =
+            super::module::translate_module_streaming(data, &mut self, sink, validator)?;
+        self.module_translation_state = Some(module_translation_state);
+        Ok(self)
+    }
+
     pub(crate) fn declare_export(&mut self, export: ExportIndex, name: &str) -> WasmResult<()> {
         self.module.exports.insert(String::from(name), export);
         Ok(())
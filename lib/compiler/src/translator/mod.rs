@@ -13,6 +13,6 @@ mod error;
 mod sections;
 
 pub use self::environ::{FunctionBodyData, FunctionReader, ModuleEnvironment};
-pub use self::module::translate_module;
+pub use self::module::{translate_module, translate_module_streaming, TranslationSink};
 pub use self::sections::wptype_to_type;
 pub use self::state::ModuleTranslationState;
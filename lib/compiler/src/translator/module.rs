@@ -3,7 +3,7 @@
 
 //! Translation skeleton that traverses the whole WebAssembly module and call helper functions
 //! to deal with each part of it.
-use super::environ::ModuleEnvironment;
+use super::environ::{FunctionBodyData, ModuleEnvironment};
 use super::sections::{
     parse_data_section, parse_element_section, parse_export_section, parse_function_section,
     parse_global_section, parse_import_section, parse_memory_section, parse_name_section,
@@ -11,18 +11,79 @@ use super::sections::{
 };
 use super::state::ModuleTranslationState;
 use crate::WasmResult;
-use wasmparser::{NameSectionReader, Parser, Payload};
+use wasmer_types::ModuleInfo;
+use wasmparser::{
+    FuncValidator, NameSectionReader, Parser, Payload, ValidPayload, Validator, ValidatorResources,
+};
+
+/// Observes a streaming translation (see [`translate_module_streaming`]),
+/// so that code generation can start while the module is still being parsed.
+pub trait TranslationSink<'data> {
+    /// Called when the code section starts. Everything a compiler needs in
+    /// order to generate code for the function bodies — types, imports,
+    /// function declarations, tables, memories and globals — has been
+    /// translated at this point; only data, name and custom sections may
+    /// still follow.
+    fn code_section_start(
+        &mut self,
+        module: &ModuleInfo,
+        module_translation_state: &ModuleTranslationState,
+        count: u32,
+    ) -> WasmResult<()>;
+
+    /// Called for each function body as it is parsed.
+    ///
+    /// When the translation runs with a [`Validator`], `validator` carries
+    /// the validation state for this body; the sink is responsible for
+    /// driving it over every operator so the body is decoded exactly once.
+    fn function_body(
+        &mut self,
+        body: FunctionBodyData<'data>,
+        validator: Option<FuncValidator<ValidatorResources>>,
+    ) -> WasmResult<()>;
+}
 
 /// Translate a sequence of bytes forming a valid Wasm binary into a
 /// parsed ModuleInfo `ModuleTranslationState`.
 pub fn translate_module<'data>(
     data: &'data [u8],
     environ: &mut ModuleEnvironment<'data>,
+) -> WasmResult<ModuleTranslationState> {
+    translate_module_impl(data, environ, None, None)
+}
+
+/// Like [`translate_module`], but additionally hands each function body to
+/// `sink` as it is parsed, without waiting for the rest of the binary.
+///
+/// When `validator` is provided, every module-level section is validated as
+/// it is translated, and each function body's [`FuncValidator`] is passed on
+/// to the sink, fusing validation into the one traversal of the binary.
+pub fn translate_module_streaming<'data>(
+    data: &'data [u8],
+    environ: &mut ModuleEnvironment<'data>,
+    sink: &mut dyn TranslationSink<'data>,
+    validator: Option<&mut Validator>,
+) -> WasmResult<ModuleTranslationState> {
+    translate_module_impl(data, environ, Some(sink), validator)
+}
+
+fn translate_module_impl<'data>(
+    data: &'data [u8],
+    environ: &mut ModuleEnvironment<'data>,
+    mut sink: Option<&mut dyn TranslationSink<'data>>,
+    mut validator: Option<&mut Validator>,
 ) -> WasmResult<ModuleTranslationState> {
     let mut module_translation_state = ModuleTranslationState::new();
 
     for payload in Parser::new(0).parse_all(data) {
-        match payload? {
+        let payload = payload?;
+        let mut func_validator = None;
+        if let Some(validator) = validator.as_mut() {
+            if let ValidPayload::Func(v, _) = validator.payload(&payload)? {
+                func_validator = Some(v);
+            }
+        }
+        match payload {
             Payload::Version { .. } | Payload::End => {}
 
             Payload::TypeSection(types) => {
@@ -61,16 +122,26 @@ pub fn translate_module<'data>(
                 parse_element_section(elements, environ)?;
             }
 
-            Payload::CodeSectionStart { .. } => {}
+            Payload::CodeSectionStart { count, .. } => {
+                if let Some(sink) = sink.as_mut() {
+                    sink.code_section_start(&environ.module, &module_translation_state, count)?;
+                }
+            }
             Payload::CodeSectionEntry(code) => {
                 let mut code = code.get_binary_reader();
                 let size = code.bytes_remaining();
                 let offset = code.original_position();
-                environ.define_function_body(
-                    &module_translation_state,
-                    code.read_bytes(size)?,
-                    offset,
-                )?;
+                let bytes = code.read_bytes(size)?;
+                if let Some(sink) = sink.as_mut() {
+                    sink.function_body(
+                        FunctionBodyData {
+                            data: bytes,
+                            module_offset: offset,
+                        },
+                        func_validator,
+                    )?;
+                }
+                environ.define_function_body(&module_translation_state, bytes, offset)?;
             }
 
             Payload::DataSection(data) => {
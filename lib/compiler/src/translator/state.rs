@@ -5,7 +5,7 @@ use crate::{wasm_unsupported, WasmResult};
 use std::boxed::Box;
 use std::collections::HashMap;
 use wasmer_types::entity::PrimaryMap;
-use wasmer_types::{FunctionIndex, ImportIndex, ModuleInfo, SignatureIndex};
+use wasmer_types::{FunctionIndex, ImportIndex, ModuleInfo, SignatureIndex, Type};
 
 /// Map of signatures to a function's parameter and return types.
 pub(crate) type WasmTypes =
@@ -29,6 +29,20 @@ pub struct ModuleTranslationState {
     pub import_map: HashMap<FunctionIndex, String>,
 }
 
+/// Helper function translating Wasm Type to wasmparser types; the inverse of
+/// [`wptype_to_type`](crate::wptype_to_type).
+fn type_to_wptype(ty: Type) -> wasmparser::Type {
+    match ty {
+        Type::I32 => wasmparser::Type::I32,
+        Type::I64 => wasmparser::Type::I64,
+        Type::F32 => wasmparser::Type::F32,
+        Type::F64 => wasmparser::Type::F64,
+        Type::V128 => wasmparser::Type::V128,
+        Type::ExternRef => wasmparser::Type::ExternRef,
+        Type::FuncRef => wasmparser::Type::FuncRef,
+    }
+}
+
 impl ModuleTranslationState {
     /// Creates a new empty ModuleTranslationState.
     pub fn new() -> Self {
@@ -38,6 +52,30 @@ impl ModuleTranslationState {
         }
     }
 
+    /// Reconstruct the translation state from an already translated module.
+    ///
+    /// This produces the same state as translating the original binary would
+    /// have: the raw signatures are recovered from the module's (lossless)
+    /// signature table. Engines use this to resume per-function compilation
+    /// from a `CompileModuleInfo` alone, without access to the wasm binary.
+    pub fn from_module_info(module: &ModuleInfo) -> Self {
+        let wasm_types = module
+            .signatures
+            .values()
+            .map(|sig| {
+                let params = sig.params().iter().map(|&ty| type_to_wptype(ty)).collect();
+                let results = sig.results().iter().map(|&ty| type_to_wptype(ty)).collect();
+                (params, results)
+            })
+            .collect();
+        let mut state = Self {
+            wasm_types,
+            import_map: HashMap::new(),
+        };
+        state.build_import_map(module);
+        state
+    }
+
     /// Build map of imported functions names for intrinsification.
     pub fn build_import_map(&mut self, module: &ModuleInfo) {
         for key in module.imports.keys() {
@@ -7,9 +7,9 @@ use std::sync::Arc;
 use wasmer_engine::InstantiationError;
 use wasmer_types::entity::{BoxedSlice, EntityRef, PrimaryMap};
 use wasmer_types::{
-    DataIndex, ElemIndex, FunctionIndex, GlobalInit, GlobalType, ImportCounts, LocalFunctionIndex,
-    LocalGlobalIndex, MemoryType, OwnedDataInitializer, OwnedTableInitializer, SignatureIndex,
-    TableType,
+    DataIndex, DataInitializer, DataInitializerLocation, ElemIndex, FunctionIndex, GlobalInit,
+    GlobalType, ImportCounts, LocalFunctionIndex, LocalGlobalIndex, MemoryType,
+    OwnedDataInitializer, OwnedTableInitializer, SignatureIndex, TableType,
 };
 use wasmer_vm::{
     Artifact, FunctionBodyPtr, FunctionExtent, InstanceHandle, Instantiatable, MemoryStyle,
@@ -21,6 +21,10 @@ use wasmer_vm::{
 pub struct UniversalArtifact {
     // TODO: figure out how to allocate fewer distinct structures onto heap. Maybe have an arena…?
     pub(crate) engine: crate::UniversalEngine,
+    /// The memory holding this module's code, trampolines and custom
+    /// sections. `None` for execute-in-place modules, whose file mapping is
+    /// retained by the engine instead.
+    pub(crate) _code_memory: Option<Arc<crate::CodeMemory>>,
     pub(crate) import_counts: ImportCounts,
     pub(crate) start_function: Option<FunctionIndex>,
     pub(crate) vmoffsets: VMOffsets,
@@ -30,13 +34,76 @@ pub struct UniversalArtifact {
     pub(crate) exports: BTreeMap<String, wasmer_types::ExportIndex>,
     pub(crate) signatures: BoxedSlice<SignatureIndex, VMSharedSignatureIndex>,
     pub(crate) local_memories: Vec<(MemoryType, MemoryStyle)>,
-    pub(crate) data_segments: Vec<OwnedDataInitializer>,
+    pub(crate) data_segments: DataSegments,
     pub(crate) passive_data: BTreeMap<DataIndex, Arc<[u8]>>,
     pub(crate) local_tables: Vec<(TableType, TableStyle)>,
     pub(crate) element_segments: Vec<OwnedTableInitializer>,
     // TODO: does this need to be a BTreeMap? Can it be a plain vector?
     pub(crate) passive_elements: BTreeMap<ElemIndex, Box<[FunctionIndex]>>,
     pub(crate) local_globals: Vec<(GlobalType, GlobalInit)>,
+    /// Present when this artifact was compiled lazily: the state needed to
+    /// compile the remaining function bodies on their first call.
+    pub(crate) lazy: Option<Arc<crate::engine::LazyCompileState>>,
+    /// A pool of preallocated instance slots that instantiation draws from,
+    /// when the engine was configured with one.
+    pub(crate) instance_pool: Option<wasmer_vm::InstancePool>,
+    /// Copy-on-write images of the initial contents of the local memories
+    /// whose data segments could be materialized at load time.
+    #[cfg(target_os = "linux")]
+    pub(crate) memory_images: Vec<(wasmer_types::MemoryIndex, Arc<wasmer_vm::MemoryImage>)>,
+    /// Keeps this module registered for backtrace symbolication for as long
+    /// as the artifact lives. `None` for modules loaded from a serialized
+    /// executable, whose frame information the engine does not retain.
+    pub(crate) _frame_info_registration: Option<wasmer_engine::GlobalFrameInfoRegistration>,
+}
+
+/// The data initializers of a loaded module.
+pub(crate) enum DataSegments {
+    /// Segment bytes copied out of the executable onto the heap.
+    Owned(Vec<OwnedDataInitializer>),
+    /// Segment bytes left in the execute-in-place file mapping (see
+    /// [`UniversalEngine::load_universal_executable_file`]
+    /// (crate::UniversalEngine::load_universal_executable_file)), which the
+    /// engine retains for as long as it lives. Large data sections then cost
+    /// no heap memory per loaded module and their pages stay shared with
+    /// every other process mapping the same file.
+    #[cfg(unix)]
+    Mapped(Vec<MappedDataInitializer>),
+}
+
+/// A data initializer whose bytes still live in the engine-retained file
+/// mapping rather than on the heap.
+#[cfg(unix)]
+pub(crate) struct MappedDataInitializer {
+    pub(crate) location: DataInitializerLocation,
+    pub(crate) data: *const u8,
+    pub(crate) len: usize,
+}
+
+// SAFETY: the pointed-to bytes are part of an immutable mapping and are never
+// written through this type.
+#[cfg(unix)]
+unsafe impl Send for MappedDataInitializer {}
+#[cfg(unix)]
+unsafe impl Sync for MappedDataInitializer {}
+
+impl DataSegments {
+    /// View the segments as `DataInitializer`s without copying the bytes.
+    pub(crate) fn to_initializers(&self) -> Vec<DataInitializer<'_>> {
+        match self {
+            Self::Owned(segments) => segments.iter().map(Into::into).collect(),
+            #[cfg(unix)]
+            Self::Mapped(segments) => segments
+                .iter()
+                .map(|segment| DataInitializer {
+                    location: segment.location.clone(),
+                    // SAFETY: the mapping holding the bytes is retained by
+                    // the engine, which this artifact keeps alive.
+                    data: unsafe { std::slice::from_raw_parts(segment.data, segment.len) },
+                })
+                .collect(),
+        }
+    }
 }
 
 impl UniversalArtifact {
@@ -53,27 +120,46 @@ impl UniversalArtifact {
     pub fn engine(&self) -> &crate::UniversalEngine {
         &self.engine
     }
-}
 
-impl Instantiatable for UniversalArtifact {
-    type Error = InstantiationError;
+    /// Resolve this module's imports against `resolver` once, producing a
+    /// plan that [`Self::instantiate_with_plan`] can consume repeatedly.
+    ///
+    /// Callers instantiating the same (module, imports) pair over and over
+    /// should resolve a plan once and reuse it, so each instantiation only
+    /// copies the prevalidated entries instead of querying the resolver by
+    /// name and re-checking types. The imports the plan was resolved against
+    /// must outlive the plan and every instance built from it.
+    pub fn plan_imports(
+        &self,
+        resolver: &dyn Resolver,
+    ) -> Result<wasmer_engine::ImportResolutionPlan, InstantiationError> {
+        wasmer_engine::plan_imports(
+            &self.engine,
+            resolver,
+            &self.import_counts,
+            &self.imports,
+            &self.dynamic_function_trampolines,
+        )
+        .map_err(InstantiationError::Link)
+    }
 
-    unsafe fn instantiate(
+    /// Like [`Instantiatable::instantiate`], but consuming a previously
+    /// resolved [`ImportResolutionPlan`](wasmer_engine::ImportResolutionPlan)
+    /// instead of querying a resolver.
+    ///
+    /// # Safety
+    ///
+    /// As for [`Instantiatable::instantiate`]. Additionally the plan must
+    /// have been produced by [`Self::plan_imports`] on this same artifact.
+    pub unsafe fn instantiate_with_plan(
         self: Arc<Self>,
         tunables: &dyn Tunables,
-        resolver: &dyn Resolver,
+        plan: &wasmer_engine::ImportResolutionPlan,
         host_state: Box<dyn std::any::Any>,
         config: wasmer_types::InstanceConfig,
-    ) -> Result<InstanceHandle, Self::Error> {
+    ) -> Result<InstanceHandle, InstantiationError> {
         let (imports, import_function_envs) = {
-            let mut imports = wasmer_engine::resolve_imports(
-                &self.engine,
-                resolver,
-                &self.import_counts,
-                &self.imports,
-                &self.dynamic_function_trampolines,
-            )
-            .map_err(InstantiationError::Link)?;
+            let mut imports = plan.build();
 
             // Get the `WasmerEnv::init_with_instance` function pointers and the pointers
             // to the envs to call it on.
@@ -82,8 +168,16 @@ impl Instantiatable for UniversalArtifact {
             (imports, import_function_envs)
         };
 
-        let (allocator, memory_definition_locations, table_definition_locations) =
-            wasmer_vm::InstanceAllocator::new(self.vmoffsets.clone());
+        // Draw the instance buffer from the artifact's pool when one is
+        // configured, falling back to the global allocator if the pool is
+        // exhausted.
+        let (allocator, memory_definition_locations, table_definition_locations) = self
+            .instance_pool
+            .as_ref()
+            .and_then(|pool| {
+                wasmer_vm::InstanceAllocator::new_pooled(self.vmoffsets.clone(), pool)
+            })
+            .unwrap_or_else(|| wasmer_vm::InstanceAllocator::new(self.vmoffsets.clone()));
 
         // Memories
         let mut memories: PrimaryMap<wasmer_types::LocalMemoryIndex, _> =
@@ -133,6 +227,21 @@ impl Instantiatable for UniversalArtifact {
     }
 }
 
+impl Instantiatable for UniversalArtifact {
+    type Error = InstantiationError;
+
+    unsafe fn instantiate(
+        self: Arc<Self>,
+        tunables: &dyn Tunables,
+        resolver: &dyn Resolver,
+        host_state: Box<dyn std::any::Any>,
+        config: wasmer_types::InstanceConfig,
+    ) -> Result<InstanceHandle, Self::Error> {
+        let plan = self.plan_imports(resolver)?;
+        self.instantiate_with_plan(tunables, &plan, host_state, config)
+    }
+}
+
 impl Artifact for UniversalArtifact {
     fn offsets(&self) -> &wasmer_vm::VMOffsets {
         &self.vmoffsets
@@ -154,8 +263,13 @@ impl Artifact for UniversalArtifact {
         &self.element_segments[..]
     }
 
-    fn data_segments(&self) -> &[OwnedDataInitializer] {
-        &self.data_segments[..]
+    fn data_segments(&self) -> Vec<DataInitializer<'_>> {
+        self.data_segments.to_initializers()
+    }
+
+    #[cfg(target_os = "linux")]
+    fn memory_images(&self) -> &[(wasmer_types::MemoryIndex, Arc<wasmer_vm::MemoryImage>)] {
+        &self.memory_images[..]
     }
 
     fn globals(&self) -> &[(GlobalType, GlobalInit)] {
@@ -174,6 +288,20 @@ impl Artifact for UniversalArtifact {
         self.signatures.values().as_slice()
     }
 
+    fn lazy_compile(
+        &self,
+        index: LocalFunctionIndex,
+    ) -> Result<*const wasmer_vm::VMFunctionBody, Box<dyn std::error::Error + Send + Sync>> {
+        match &self.lazy {
+            Some(state) => self.engine.lazy_compile_function(state, index),
+            None => Err(format!(
+                "this artifact does not support lazy compilation of function {:?}",
+                index
+            )
+            .into()),
+        }
+    }
+
     fn function_signature(&self, index: FunctionIndex) -> Option<VMSharedSignatureIndex> {
         match self.import_counts().local_function_index(index) {
             Ok(local) => Some(self.functions[local].signature),
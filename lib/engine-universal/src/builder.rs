@@ -1,4 +1,6 @@
-use crate::UniversalEngine;
+use crate::{MetricsSink, UniversalEngine};
+use std::path::PathBuf;
+use std::sync::Arc;
 use wasmer_compiler::{CompilerConfig, Features, Target};
 
 /// The Universal builder
@@ -7,6 +9,13 @@ pub struct Universal {
     compiler_config: Option<Box<dyn CompilerConfig>>,
     target: Option<Target>,
     features: Option<Features>,
+    lazy_compilation: bool,
+    tier_up: Option<(Box<dyn CompilerConfig>, u64)>,
+    instance_pool_capacity: Option<usize>,
+    code_huge_pages: bool,
+    #[allow(dead_code)]
+    compile_cache_dir: Option<PathBuf>,
+    metrics: Option<Arc<dyn MetricsSink>>,
 }
 
 impl Universal {
@@ -19,6 +28,12 @@ impl Universal {
             compiler_config: Some(compiler_config.into()),
             target: None,
             features: None,
+            lazy_compilation: false,
+            tier_up: None,
+            instance_pool_capacity: None,
+            code_huge_pages: false,
+            compile_cache_dir: None,
+            metrics: None,
         }
     }
 
@@ -28,6 +43,12 @@ impl Universal {
             compiler_config: None,
             target: None,
             features: None,
+            lazy_compilation: false,
+            tier_up: None,
+            instance_pool_capacity: None,
+            code_huge_pages: false,
+            compile_cache_dir: None,
+            metrics: None,
         }
     }
 
@@ -43,6 +64,83 @@ impl Universal {
         self
     }
 
+    /// Defer compilation of each wasm function body to its first call.
+    ///
+    /// This requires a compiler that implements
+    /// [`compile_module_lazily`](wasmer_compiler::Compiler::compile_module_lazily).
+    pub fn lazy_compilation(mut self, lazy_compilation: bool) -> Self {
+        self.lazy_compilation = lazy_compilation;
+        self
+    }
+
+    /// Recompile functions with `compiler_config` on a background thread once
+    /// they have been called `threshold` times, hot-swapping the recompiled
+    /// body in.
+    ///
+    /// This implies [`lazy_compilation`](Self::lazy_compilation): the
+    /// per-function indirection installed by the compilation stubs is what
+    /// makes the swap possible.
+    pub fn tier_up<T>(mut self, compiler_config: T, threshold: u64) -> Self
+    where
+        T: Into<Box<dyn CompilerConfig>>,
+    {
+        self.tier_up = Some((compiler_config.into(), threshold));
+        self
+    }
+
+    /// Have every loaded artifact preallocate a pool of `capacity` instance
+    /// slots, so that repeated instantiation reuses the slots instead of
+    /// paying a global allocation per instance.
+    ///
+    /// Instantiation falls back to the global allocator when the pool is
+    /// exhausted.
+    pub fn instance_pool(mut self, capacity: usize) -> Self {
+        self.instance_pool_capacity = Some(capacity);
+        self
+    }
+
+    /// Back the mappings holding jitted code with huge pages on hosts
+    /// configured for it, cutting iTLB pressure for modules with many
+    /// megabytes of hot code.
+    ///
+    /// Hosts without reserved huge pages fall back to transparent huge
+    /// pages, and hosts without those to normal pages, so this is always
+    /// safe to enable.
+    pub fn code_huge_pages(mut self, enable: bool) -> Self {
+        self.code_huge_pages = enable;
+        self
+    }
+
+    /// Cache compiled executables in `directory`, keyed by the wasm bytes
+    /// and the engine configuration, so that recompiling a module already
+    /// seen by the cache costs one file mapping instead of a compilation.
+    ///
+    /// On unix, entries are stored in the execute-in-place format and hits
+    /// run their code straight out of the file mapping, so worker processes
+    /// sharing one cache directory also share each entry's metadata tables
+    /// and untouched code pages through the page cache.
+    ///
+    /// The directory is trusted: entries are loaded without structural
+    /// validation, so it must not be writable by untrusted parties. The
+    /// cache also assumes that memory and table styles are derived from the
+    /// target alone, as the default
+    /// [`Tunables`](wasmer_vm::Tunables) implementation derives them; do
+    /// not share one directory between stores whose tunables style modules
+    /// differently.
+    pub fn compile_cache<P: Into<PathBuf>>(mut self, directory: P) -> Self {
+        self.compile_cache_dir = Some(directory.into());
+        self
+    }
+
+    /// Report phase timings and per-module counters of the built engine to
+    /// `sink`.
+    ///
+    /// Has no effect unless the crate is built with the `metrics` feature.
+    pub fn metrics(mut self, sink: Arc<dyn MetricsSink>) -> Self {
+        self.metrics = Some(sink);
+        self
+    }
+
     /// Build the `UniversalEngine` for this configuration
     #[cfg(feature = "compiler")]
     pub fn engine(self) -> UniversalEngine {
@@ -52,15 +150,43 @@ impl Universal {
                 .features
                 .unwrap_or_else(|| compiler_config.default_features_for_target(&target));
             let compiler = compiler_config.compiler();
-            UniversalEngine::new(compiler, target, features)
+            let mut engine = UniversalEngine::new(compiler, target, features);
+            let tiering = self.tier_up.is_some();
+            {
+                let inner = engine.config_mut();
+                inner.lazy_compilation = self.lazy_compilation || tiering;
+                inner.instance_pool_capacity = self.instance_pool_capacity;
+                inner.code_huge_pages = self.code_huge_pages;
+                inner.compile_cache = self.compile_cache_dir.map(crate::cache::CompileCache::new);
+                inner.metrics = crate::metrics::Recorder::new(self.metrics);
+                if let Some((tier_up_config, threshold)) = self.tier_up {
+                    inner.tier_up_compiler = Some(tier_up_config.compiler());
+                    inner.tier_up_threshold = threshold;
+                }
+            }
+            if tiering {
+                engine.spawn_tier_up_monitor();
+            }
+            engine
         } else {
-            UniversalEngine::headless()
+            let mut engine = UniversalEngine::headless();
+            let inner = engine.config_mut();
+            inner.instance_pool_capacity = self.instance_pool_capacity;
+            inner.code_huge_pages = self.code_huge_pages;
+            inner.compile_cache = self.compile_cache_dir.map(crate::cache::CompileCache::new);
+            inner.metrics = crate::metrics::Recorder::new(self.metrics);
+            engine
         }
     }
 
     /// Build the `UniversalEngine` for this configuration
     #[cfg(not(feature = "compiler"))]
     pub fn engine(self) -> UniversalEngine {
-        UniversalEngine::headless()
+        let mut engine = UniversalEngine::headless();
+        let inner = engine.config_mut();
+        inner.instance_pool_capacity = self.instance_pool_capacity;
+        inner.code_huge_pages = self.code_huge_pages;
+        inner.metrics = crate::metrics::Recorder::new(self.metrics);
+        engine
     }
 }
@@ -0,0 +1,275 @@
+//! Content-addressed on-disk cache of compiled executables.
+//!
+//! When a cache directory is configured (see
+//! [`Universal::compile_cache`](crate::Universal::compile_cache)), the
+//! engine's compile path consults the cache before invoking the compiler.
+//! Entries are keyed by everything that influences the compiled output — the
+//! wasm bytes, the target triple and CPU features, the enabled wasm features,
+//! the compiler's configuration and the compilation mode. A hit is mapped straight from disk and exposed
+//! through the zero-copy [`UniversalExecutableRef`] view, so it costs one
+//! file mapping and a header verification instead of a compilation.
+//!
+//! On unix, entries are stored in the execute-in-place format (see
+//! [`UniversalExecutable::serialize_xip`]) and hits are loaded by attaching
+//! the mapped file rather than copying the code out. The mapping is backed by
+//! the page cache, so every worker process on the host that loads the same
+//! entry shares its metadata tables and all code pages that relocations do
+//! not touch: warm-starting a fresh worker is an attach, not a load.
+//! Executables that cannot be executed in place fall back to the standard
+//! [`serialize`](wasmer_engine::Executable::serialize) format and the copying
+//! load path.
+//!
+//! The cache directory is trusted: like
+//! [`UniversalExecutableRef::deserialize`], loading an entry performs no
+//! structural validation of the archived data, so the directory must not be
+//! writable by untrusted parties. The key hash is likewise not meant to
+//! resist adversarial collisions.
+
+use crate::executable::{UniversalExecutable, UniversalExecutableRef};
+use enumset::EnumSet;
+use std::path::PathBuf;
+use std::sync::Arc;
+use wasmer_compiler::{CompileError, CpuFeature, Features, Target};
+use wasmer_engine::Engine;
+use wasmer_types::FunctionIndex;
+use wasmer_vm::Artifact;
+
+/// Distinguishes incompatible revisions of the serialized executable layout
+/// that [`UniversalExecutableRef::verify_serialized`] cannot tell apart.
+/// Bump on any change to the archived types.
+const CACHE_FORMAT_VERSION: u32 = 1;
+
+/// A content-addressed cache of serialized executables in a directory.
+pub(crate) struct CompileCache {
+    directory: PathBuf,
+}
+
+impl CompileCache {
+    pub(crate) fn new(directory: PathBuf) -> Self {
+        Self { directory }
+    }
+
+    /// The cache key for compiling `binary` with the given engine
+    /// configuration.
+    ///
+    /// `lazy_compilation` participates because it changes the shape of the
+    /// produced executable, not just its performance characteristics;
+    /// `compiler_config` is the compiler's
+    /// [`config_digest`](wasmer_compiler::Compiler::config_digest), so that
+    /// differently configured compilers sharing a directory never serve each
+    /// other's entries.
+    pub(crate) fn key(
+        &self,
+        binary: &[u8],
+        target: &Target,
+        features: &Features,
+        lazy_compilation: bool,
+        compiler_config: &str,
+    ) -> CacheKey {
+        let mut hasher = Fnv1a128::new();
+        hasher.write(env!("CARGO_PKG_VERSION").as_bytes());
+        hasher.write(&CACHE_FORMAT_VERSION.to_le_bytes());
+        hasher.write(target.triple().to_string().as_bytes());
+        hasher.write(&target.cpu_features().as_u64().to_le_bytes());
+        // `Features` is a plain set of booleans; its `Debug` form covers
+        // every field and naturally invalidates old keys when one is added.
+        hasher.write(format!("{:?}", features).as_bytes());
+        hasher.write(&[lazy_compilation as u8]);
+        hasher.write(&(compiler_config.len() as u64).to_le_bytes());
+        hasher.write(compiler_config.as_bytes());
+        hasher.write(&(binary.len() as u64).to_le_bytes());
+        hasher.write(binary);
+        CacheKey(hasher.finish())
+    }
+
+    /// Look `key` up, mapping the stored executable when present.
+    ///
+    /// Unreadable or malformed entries are treated as misses.
+    pub(crate) fn load(&self, key: &CacheKey) -> Option<CachedExecutable> {
+        CachedExecutable::open(self.entry_path(key))
+    }
+
+    /// Store `executable` under `key`.
+    ///
+    /// The executable is streamed into a temporary file which is then renamed
+    /// into place, so concurrent compilations of the same module race
+    /// benignly and readers never observe a partial entry. Failures are
+    /// swallowed: a cache that cannot be populated only costs a recompilation
+    /// next time.
+    pub(crate) fn store(&self, key: &CacheKey, executable: &UniversalExecutable) {
+        let _ = self.try_store(key, executable);
+    }
+
+    fn try_store(
+        &self,
+        key: &CacheKey,
+        executable: &UniversalExecutable,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        std::fs::create_dir_all(&self.directory)?;
+        let temporary = self
+            .directory
+            .join(format!("{:032x}.{}.tmp", key.0, std::process::id()));
+        let mut file = std::fs::File::create(&temporary)?;
+        // Prefer the execute-in-place format so that every process loading
+        // the entry shares its pages; executables it cannot represent (those
+        // carrying unwind or debug information) are stored in the standard
+        // format and hits take the copying path.
+        #[cfg(unix)]
+        let written = match executable.serialize_xip() {
+            Ok(bytes) => std::io::Write::write_all(&mut file, &bytes).map_err(Into::into),
+            Err(_) => executable.serialize_to(&mut file),
+        };
+        #[cfg(not(unix))]
+        let written = executable.serialize_to(&mut file);
+        let result = written.and_then(|()| {
+            std::fs::rename(&temporary, self.entry_path(key))?;
+            Ok(())
+        });
+        if result.is_err() {
+            let _ = std::fs::remove_file(&temporary);
+        }
+        result
+    }
+
+    fn entry_path(&self, key: &CacheKey) -> PathBuf {
+        self.directory.join(format!("{:032x}.wasmu", key.0))
+    }
+}
+
+/// The content hash identifying a cache entry.
+pub(crate) struct CacheKey(u128);
+
+/// A cache hit: a serialized executable mapped from the cache directory.
+///
+/// The mapping stays alive for as long as this value does, and the archived
+/// executable is exposed through the zero-copy [`UniversalExecutableRef`]
+/// view, so loading a hit never materializes the executable on the heap.
+pub(crate) struct CachedExecutable {
+    #[cfg(unix)]
+    file: std::fs::File,
+    #[cfg(unix)]
+    backing: crate::xip::XipImage,
+    #[cfg(not(unix))]
+    backing: Vec<u8>,
+    /// Offset of the standard serialized payload within the entry: non-zero
+    /// for execute-in-place entries, whose code image precedes it.
+    tail_offset: usize,
+}
+
+impl CachedExecutable {
+    /// Open and verify the cache entry at `path`, if there is one.
+    fn open(path: PathBuf) -> Option<Self> {
+        #[cfg(unix)]
+        let (file, backing) = {
+            let file = std::fs::File::open(path).ok()?;
+            let backing = crate::xip::XipImage::map_file(&file).ok()?;
+            (file, backing)
+        };
+        #[cfg(not(unix))]
+        let backing = std::fs::read(path).ok()?;
+        let mut this = Self {
+            #[cfg(unix)]
+            file,
+            backing,
+            tail_offset: 0,
+        };
+        #[cfg(unix)]
+        {
+            // SAFETY: the borrow does not outlive `this` below.
+            let data = unsafe { this.backing.as_slice() };
+            if let Some((page_size, image_len, _)) = crate::xip::parse_header(data) {
+                this.tail_offset = page_size
+                    .checked_add(image_len)
+                    .filter(|&offset| offset <= data.len())?;
+            }
+        }
+        UniversalExecutableRef::verify_serialized(this.as_slice()).ok()?;
+        Some(this)
+    }
+
+    fn as_slice(&self) -> &[u8] {
+        // SAFETY: the mapping lives as long as `self`, which the returned
+        // borrow keeps alive.
+        #[cfg(unix)]
+        return &unsafe { self.backing.as_slice() }[self.tail_offset..];
+        #[cfg(not(unix))]
+        return &self.backing[self.tail_offset..];
+    }
+
+    fn executable(&self) -> UniversalExecutableRef<'_> {
+        // SAFETY: the buffer was verified in `open` and `rkyv` imposes no
+        // validation requirements beyond it (see
+        // `UniversalExecutableRef::deserialize`).
+        unsafe { UniversalExecutableRef::deserialize(self.as_slice()) }
+            .expect("the cache entry was verified when it was opened")
+    }
+}
+
+impl wasmer_engine::Executable for CachedExecutable {
+    fn load(&self, engine: &(dyn Engine + 'static)) -> Result<Arc<dyn Artifact>, CompileError> {
+        // Execute-in-place entries attach the mapped file instead of copying
+        // the code out, so sibling processes loading the same entry share its
+        // clean pages through the page cache.
+        #[cfg(unix)]
+        if self.tail_offset != 0 {
+            if let Some(engine) = engine.downcast_ref::<crate::UniversalEngine>() {
+                // SAFETY: the cache directory is trusted by contract (see the
+                // module documentation), so its entries satisfy the trusted
+                // source requirement of `load_universal_executable_file`.
+                return unsafe { engine.load_universal_executable_file(&self.file) }
+                    .map(|artifact| Arc::new(artifact) as _);
+            }
+        }
+        self.executable().load(engine)
+    }
+
+    fn features(&self) -> Features {
+        self.executable().features()
+    }
+
+    fn cpu_features(&self) -> EnumSet<CpuFeature> {
+        self.executable().cpu_features()
+    }
+
+    fn serialize(&self) -> Result<Vec<u8>, Box<dyn std::error::Error + Send + Sync>> {
+        self.executable().serialize()
+    }
+
+    fn serialize_to(
+        &self,
+        writer: &mut dyn std::io::Write,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        wasmer_engine::Executable::serialize_to(&self.executable(), writer)
+    }
+
+    fn function_name(&self, index: FunctionIndex) -> Option<&str> {
+        self.executable().function_name(index)
+    }
+}
+
+/// The 128-bit FNV-1a hash function.
+///
+/// Hand-rolled to keep the cache dependency-free: it is deterministic across
+/// hosts and toolchains — unlike the std hasher — and 128 bits make
+/// accidental collisions a non-concern, which is all a trusted cache needs.
+struct Fnv1a128(u128);
+
+impl Fnv1a128 {
+    const OFFSET_BASIS: u128 = 0x6c62272e07bb014262b821756295c58d;
+    const PRIME: u128 = 0x0000000001000000000000000000013b;
+
+    fn new() -> Self {
+        Self(Self::OFFSET_BASIS)
+    }
+
+    fn write(&mut self, bytes: &[u8]) {
+        for &byte in bytes {
+            self.0 ^= u128::from(byte);
+            self.0 = self.0.wrapping_mul(Self::PRIME);
+        }
+    }
+
+    fn finish(&self) -> u128 {
+        self.0
+    }
+}
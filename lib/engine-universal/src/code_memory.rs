@@ -22,15 +22,22 @@ pub struct CodeMemory {
     unwind_registry: UnwindRegistry,
     mmap: Mmap,
     start_of_nonexecutable_pages: usize,
+    huge_pages: bool,
 }
 
 impl CodeMemory {
     /// Create a new `CodeMemory` instance.
-    pub fn new() -> Self {
+    ///
+    /// When `huge_pages` is set, the code mapping is backed by huge pages on
+    /// hosts configured for it (see
+    /// [`Mmap::with_at_least_huge_pages`](wasmer_vm::Mmap::with_at_least_huge_pages)),
+    /// cutting iTLB pressure for modules with many megabytes of hot code.
+    pub fn new(huge_pages: bool) -> Self {
         Self {
             unwind_registry: UnwindRegistry::new(),
             mmap: Mmap::new(),
             start_of_nonexecutable_pages: 0,
+            huge_pages,
         }
     }
 
@@ -78,7 +85,11 @@ impl CodeMemory {
 
         // 2. Allocate the pages. Mark them all read-write.
 
-        self.mmap = Mmap::with_at_least(total_len)?;
+        self.mmap = if self.huge_pages {
+            Mmap::with_at_least_huge_pages(total_len)?
+        } else {
+            Mmap::with_at_least(total_len)?
+        };
 
         // 3. Determine where the pointers to each function, executable section
         // or data section are. Copy the functions. Collect the addresses of each and return them.
@@ -135,6 +146,12 @@ impl CodeMemory {
         ))
     }
 
+    /// The number of bytes holding executable code, trampolines and
+    /// executable custom sections included.
+    pub fn executable_size(&self) -> usize {
+        self.start_of_nonexecutable_pages
+    }
+
     /// Apply the page permissions.
     pub fn publish(&mut self) {
         if self.mmap.is_empty() || self.start_of_nonexecutable_pages == 0 {
@@ -1,19 +1,22 @@
 //! Universal compilation.
 
-use crate::executable::{unrkyv, UniversalExecutableRef};
+use crate::executable::{unrkyv, LazyFunctionBody, LazyFunctions, UniversalExecutableRef};
+use crate::metrics::{Phase, Recorder};
 use crate::{CodeMemory, UniversalArtifact, UniversalExecutable};
 use rkyv::de::deserializers::SharedDeserializeMap;
-use std::collections::BTreeMap;
+use std::collections::{BTreeMap, HashMap};
 use std::convert::TryFrom;
+#[cfg(feature = "compiler")]
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
 use std::sync::{Arc, Mutex};
 #[cfg(feature = "compiler")]
-use wasmer_compiler::Compiler;
+use wasmer_compiler::{Compiler, FunctionBodyData};
 use wasmer_compiler::{
-    CompileError, CustomSectionProtection, CustomSectionRef, FunctionBodyRef, JumpTable,
-    SectionIndex, Target,
+    CompileError, CompileModuleInfo, CustomSectionProtection, CustomSectionRef, FunctionBodyRef,
+    JumpTable, ModuleTranslationState, SectionIndex, Target,
 };
 use wasmer_engine::{Engine, EngineId};
-use wasmer_types::entity::{EntityRef, PrimaryMap};
+use wasmer_types::entity::{BoxedSlice, EntityRef, PrimaryMap};
 use wasmer_types::{
     DataInitializer, ExportIndex, Features, FunctionIndex, FunctionType, FunctionTypeRef,
     GlobalInit, GlobalType, ImportCounts, ImportIndex, LocalFunctionIndex, LocalGlobalIndex,
@@ -28,7 +31,7 @@ use wasmer_vm::{
 /// A WebAssembly `Universal` Engine.
 #[derive(Clone)]
 pub struct UniversalEngine {
-    inner: Arc<Mutex<UniversalEngineInner>>,
+    inner: Arc<UniversalEngineInner>,
     /// The target for the compiler
     target: Arc<Target>,
     engine_id: EngineId,
@@ -39,13 +42,24 @@ impl UniversalEngine {
     #[cfg(feature = "compiler")]
     pub fn new(compiler: Box<dyn Compiler>, target: Target, features: Features) -> Self {
         Self {
-            inner: Arc::new(Mutex::new(UniversalEngineInner {
+            inner: Arc::new(UniversalEngineInner {
                 compiler: Some(compiler),
-                code_memory: vec![],
+                lazy_code: Mutex::new(vec![]),
+                metrics: Recorder::default(),
+                call_trampolines: Mutex::new(TrampolineCache::default()),
                 signatures: SignatureRegistry::new(),
                 func_data: Arc::new(FuncDataRegistry::new()),
                 features,
-            })),
+                lazy_compilation: false,
+                instance_pool_capacity: None,
+                code_huge_pages: false,
+                compile_cache: None,
+                #[cfg(unix)]
+                xip_images: Mutex::new(vec![]),
+                tier_up_compiler: None,
+                tier_up_threshold: 0,
+                tiering: Mutex::new(vec![]),
+            }),
             target: Arc::new(target),
             engine_id: EngineId::default(),
         }
@@ -66,83 +80,164 @@ impl UniversalEngine {
     /// they just take already processed Modules (via `Module::serialize`).
     pub fn headless() -> Self {
         Self {
-            inner: Arc::new(Mutex::new(UniversalEngineInner {
+            inner: Arc::new(UniversalEngineInner {
                 #[cfg(feature = "compiler")]
                 compiler: None,
-                code_memory: vec![],
+                lazy_code: Mutex::new(vec![]),
+                metrics: Recorder::default(),
+                call_trampolines: Mutex::new(TrampolineCache::default()),
                 signatures: SignatureRegistry::new(),
                 func_data: Arc::new(FuncDataRegistry::new()),
                 features: Features::default(),
-            })),
+                lazy_compilation: false,
+                instance_pool_capacity: None,
+                code_huge_pages: false,
+                #[cfg(feature = "compiler")]
+                compile_cache: None,
+                #[cfg(unix)]
+                xip_images: Mutex::new(vec![]),
+                #[cfg(feature = "compiler")]
+                tier_up_compiler: None,
+                #[cfg(feature = "compiler")]
+                tier_up_threshold: 0,
+                #[cfg(feature = "compiler")]
+                tiering: Mutex::new(vec![]),
+            }),
             target: Arc::new(Target::default()),
             engine_id: EngineId::default(),
         }
     }
 
-    pub(crate) fn inner(&self) -> std::sync::MutexGuard<'_, UniversalEngineInner> {
-        self.inner.lock().unwrap()
+    pub(crate) fn inner(&self) -> &UniversalEngineInner {
+        &self.inner
+    }
+
+    /// Exclusive access to the engine internals for configuration, available
+    /// only before the engine has been shared.
+    pub(crate) fn config_mut(&mut self) -> &mut UniversalEngineInner {
+        Arc::get_mut(&mut self.inner).expect("the engine is already shared")
     }
 
-    pub(crate) fn inner_mut(&self) -> std::sync::MutexGuard<'_, UniversalEngineInner> {
-        self.inner.lock().unwrap()
+    /// Spawn the background thread that recompiles hot functions of lazily
+    /// compiled modules with the configured tier-up compiler.
+    #[cfg(feature = "compiler")]
+    pub(crate) fn spawn_tier_up_monitor(&self) {
+        let inner = Arc::downgrade(&self.inner);
+        let target = self.target.clone();
+        std::thread::Builder::new()
+            .name("wasmer-tier-up".into())
+            .spawn(move || tier_up_monitor(inner, target))
+            .expect("failed to spawn the tier-up monitor thread");
     }
 
     /// Compile a WebAssembly binary
+    ///
+    /// The binary is validated as part of the compilation: an invalid module
+    /// is reported as a [`CompileError`], so callers do not need a separate
+    /// [`validate`](UniversalEngine::validate) pass.
     #[cfg(feature = "compiler")]
     pub fn compile_universal(
         &self,
         binary: &[u8],
         tunables: &dyn Tunables,
     ) -> Result<crate::UniversalExecutable, CompileError> {
-        let inner_engine = self.inner_mut();
+        let inner_engine = self.inner();
         let features = inner_engine.features();
         let compiler = inner_engine.compiler()?;
-        let environ = wasmer_compiler::ModuleEnvironment::new();
-        let translation = environ.translate(binary).map_err(CompileError::Wasm)?;
+        let compile_span = inner_engine.metrics.phase(Phase::Compile);
 
-        let memory_styles: PrimaryMap<wasmer_types::MemoryIndex, _> = translation
-            .module
-            .memories
-            .values()
-            .map(|memory_type| tunables.memory_style(memory_type))
-            .collect();
-        let table_styles: PrimaryMap<wasmer_types::TableIndex, _> = translation
-            .module
-            .tables
-            .values()
-            .map(|table_type| tunables.table_style(table_type))
-            .collect();
+        let styles = |module: &wasmer_types::ModuleInfo| {
+            let memory_styles: PrimaryMap<wasmer_types::MemoryIndex, _> = module
+                .memories
+                .values()
+                .map(|memory_type| tunables.memory_style(memory_type))
+                .collect();
+            let table_styles: PrimaryMap<wasmer_types::TableIndex, _> = module
+                .tables
+                .values()
+                .map(|table_type| tunables.table_style(table_type))
+                .collect();
+            (memory_styles, table_styles)
+        };
 
         // Compile the Module
-        let compile_info = wasmer_compiler::CompileModuleInfo {
-            module: Arc::new(translation.module),
-            features: features.clone(),
-            memory_styles,
-            table_styles,
+        let (compile_info, compilation, data_initializers, lazy_functions) = if inner_engine
+            .lazy_compilation
+        {
+            // Function bodies are only compiled on first call, so validate
+            // the whole binary up front: an invalid body must fail the
+            // compilation, not trap an instance later.
+            compiler.validate_module(features, binary)?;
+            // Lazy compilation only looks at the signatures, so there is
+            // nothing to overlap with parsing: translate first.
+            let environ = wasmer_compiler::ModuleEnvironment::new();
+            let translation = environ.translate(binary).map_err(CompileError::Wasm)?;
+            let (memory_styles, table_styles) = styles(&translation.module);
+            let compile_info = wasmer_compiler::CompileModuleInfo {
+                module: Arc::new(translation.module),
+                features: features.clone(),
+                memory_styles,
+                table_styles,
+            };
+            // SAFETY: Calling `unwrap` is correct since `environ.translate()`
+            // above will write some data into `module_translation_state`.
+            let module_translation_state = translation.module_translation_state.as_ref().unwrap();
+            let (compilation, lazy_sections) = compiler.compile_module_lazily(
+                &self.target(),
+                &compile_info,
+                module_translation_state,
+                &translation.function_body_inputs,
+            )?;
+            let function_bodies = translation
+                .function_body_inputs
+                .iter()
+                .map(|(_, input)| LazyFunctionBody {
+                    data: input.data.to_vec(),
+                    module_offset: input.module_offset as u64,
+                })
+                .collect();
+            let lazy_functions = LazyFunctions {
+                slots_section: lazy_sections.slots,
+                counters_section: lazy_sections.counters,
+                function_bodies,
+            };
+            let data_initializers = translation
+                .data_initializers
+                .iter()
+                .map(wasmer_types::OwnedDataInitializer::new)
+                .collect();
+            (
+                compile_info,
+                compilation,
+                data_initializers,
+                Some(lazy_functions),
+            )
+        } else {
+            // Full compilation streams the function bodies into the compiler
+            // as they are parsed, overlapping translation with codegen.
+            // Compilers that fuse validation into that traversal decode each
+            // body exactly once; the rest get a separate validation pass.
+            if !compiler.validates_while_compiling() {
+                compiler.validate_module(features, binary)?;
+            }
+            let streamed =
+                compiler.compile_module_streaming(&self.target(), features, binary, &styles)?;
+            let data_initializers = streamed
+                .data_initializers
+                .iter()
+                .map(wasmer_types::OwnedDataInitializer::new)
+                .collect();
+            (streamed.info, streamed.compilation, data_initializers, None)
         };
-        let compilation = compiler.compile_module(
-            &self.target(),
-            &compile_info,
-            // SAFETY: Calling `unwrap` is correct since
-            // `environ.translate()` above will write some data into
-            // `module_translation_state`.
-            translation.module_translation_state.as_ref().unwrap(),
-            translation.function_body_inputs,
-        )?;
         let function_call_trampolines = compilation.get_function_call_trampolines();
         let dynamic_function_trampolines = compilation.get_dynamic_function_trampolines();
-        let data_initializers = translation
-            .data_initializers
-            .iter()
-            .map(wasmer_types::OwnedDataInitializer::new)
-            .collect();
 
         let frame_infos = compilation.get_frame_info();
-        Ok(crate::UniversalExecutable {
+        let executable = crate::UniversalExecutable {
             function_bodies: compilation.get_function_bodies(),
             function_relocations: compilation.get_relocations(),
             function_jt_offsets: compilation.get_jt_offsets(),
-            function_frame_info: frame_infos,
+            function_frame_info: Arc::new(frame_infos),
             function_call_trampolines,
             dynamic_function_trampolines,
             custom_sections: compilation.get_custom_sections(),
@@ -152,7 +247,10 @@ impl UniversalEngine {
             compile_info,
             data_initializers,
             cpu_features: self.target().cpu_features().as_u64(),
-        })
+            lazy_functions,
+        };
+        compile_span.finish();
+        Ok(executable)
     }
 
     /// Load a [`UniversalExecutable`](crate::UniversalExecutable) with this engine.
@@ -160,6 +258,7 @@ impl UniversalEngine {
         &self,
         executable: &UniversalExecutable,
     ) -> Result<UniversalArtifact, CompileError> {
+        let load_span = self.inner().metrics.phase(Phase::Load);
         let info = &executable.compile_info;
         let module = &info.module;
         let local_memories = (module.import_counts.memories as usize..module.memories.len())
@@ -184,7 +283,7 @@ impl UniversalEngine {
                 (*t, init)
             })
             .collect();
-        let mut inner_engine = self.inner_mut();
+        let inner_engine = self.inner();
 
         let local_functions = executable.function_bodies.iter().map(|(_, b)| b.into());
         let function_call_trampolines = &executable.function_call_trampolines;
@@ -195,18 +294,25 @@ impl UniversalEngine {
             .map(|(_, sig)| inner_engine.signatures.register(sig.into()))
             .collect::<PrimaryMap<SignatureIndex, _>>()
             .into_boxed_slice();
-        let (functions, trampolines, dynamic_trampolines, custom_sections) = inner_engine
-            .allocate(
-                local_functions,
-                function_call_trampolines.iter().map(|(_, b)| b.into()),
-                dynamic_function_trampolines.iter().map(|(_, b)| b.into()),
-                executable.custom_sections.iter().map(|(_, s)| s.into()),
-                |idx: LocalFunctionIndex| {
-                    let func_idx = module.import_counts.function_index(idx);
-                    let sig_idx = module.functions[func_idx];
-                    (sig_idx, signatures[sig_idx])
-                },
-            )?;
+        let trampolines = inner_engine.resolve_call_trampolines(
+            &signatures,
+            function_call_trampolines.iter().map(|(_, b)| b.into()),
+        )?;
+        let mut code_memory = CodeMemory::new(inner_engine.code_huge_pages);
+        let allocate_span = inner_engine.metrics.phase(Phase::Allocate);
+        let (functions, dynamic_trampolines, custom_sections) = allocate(
+            &mut code_memory,
+            local_functions,
+            &trampolines,
+            dynamic_function_trampolines.iter().map(|(_, b)| b.into()),
+            executable.custom_sections.iter().map(|(_, s)| s.into()),
+            |idx: LocalFunctionIndex| {
+                let func_idx = module.import_counts.function_index(idx);
+                let sig_idx = module.functions[func_idx];
+                (sig_idx, signatures[sig_idx])
+            },
+        )?;
+        allocate_span.finish();
         let imports = module
             .imports
             .iter()
@@ -234,6 +340,7 @@ impl UniversalEngine {
 
         let function_relocations = executable.function_relocations.iter();
         let section_relocations = executable.custom_section_relocations.iter();
+        let link_span = inner_engine.metrics.phase(Phase::Link);
         crate::link_module(
             &functions,
             |func_idx, jt_idx| executable.function_jt_offsets[func_idx][jt_idx],
@@ -242,42 +349,106 @@ impl UniversalEngine {
             section_relocations.map(|(i, rs)| (i, rs.iter().cloned())),
             &executable.trampolines,
         );
+        link_span.finish();
 
         // Make all code loaded executable.
-        inner_engine.publish_compiled_code();
+        let publish_span = inner_engine.metrics.phase(Phase::Publish);
+        code_memory.publish();
         if let Some(ref d) = executable.debug {
             unsafe {
                 // TODO: safety comment
-                inner_engine.publish_eh_frame(std::slice::from_raw_parts(
-                    *custom_sections[d.eh_frame],
-                    executable.custom_sections[d.eh_frame].bytes.len(),
-                ))?;
+                publish_eh_frame(
+                    &mut code_memory,
+                    std::slice::from_raw_parts(
+                        *custom_sections[d.eh_frame],
+                        executable.custom_sections[d.eh_frame].bytes.len(),
+                    ),
+                )?;
             }
         }
+        publish_span.finish();
+        if inner_engine.metrics.enabled() {
+            inner_engine.metrics.module_loaded(code_memory.executable_size());
+            inner_engine
+                .metrics
+                .registry_sizes(inner_engine.signatures.len(), inner_engine.func_data.len());
+        }
+        let code_memory = Arc::new(code_memory);
+        // Register the module for backtrace symbolication. Only the code
+        // range is recorded here; the per-function details are cloned out of
+        // the `Arc` below on the first trap that hits this module.
+        let frame_info_registration = {
+            let frame_infos = Arc::clone(&executable.function_frame_info);
+            wasmer_engine::register_frame_info(
+                Arc::clone(module),
+                functions.values().map(|f| wasmer_vm::FunctionExtent {
+                    address: f.body,
+                    length: f.length as usize,
+                }),
+                Box::new(move || {
+                    Arc::try_unwrap(frame_infos).unwrap_or_else(|infos| (*infos).clone())
+                }),
+            )
+        };
         let exports = module
             .exports
             .iter()
             .map(|(s, i)| (s.clone(), i.clone()))
             .collect::<BTreeMap<String, ExportIndex>>();
+        let lazy = executable.lazy_functions.as_ref().map(|lazy_functions| {
+            Arc::new(LazyCompileState::new(
+                info.clone(),
+                lazy_functions.clone(),
+                &custom_sections,
+                &functions,
+                Some(code_memory.clone()),
+            ))
+        });
+        if let Some(ref state) = lazy {
+            inner_engine.register_tiering_candidate(state);
+        }
+        let vmoffsets = VMOffsets::for_host().with_module_info(&*module);
+        let instance_pool = inner_engine
+            .instance_pool_capacity
+            .map(|capacity| wasmer_vm::InstancePool::new(capacity, &vmoffsets));
+        #[cfg(target_os = "linux")]
+        let memory_images = build_memory_images(
+            &executable
+                .data_initializers
+                .iter()
+                .map(Into::into)
+                .collect::<Vec<DataInitializer<'_>>>(),
+            &module.import_counts,
+        );
 
-        Ok(UniversalArtifact {
+        let artifact = UniversalArtifact {
             engine: self.clone(),
+            _code_memory: Some(code_memory),
             import_counts: module.import_counts,
             start_function: module.start_function,
-            vmoffsets: VMOffsets::for_host().with_module_info(&*module),
+            vmoffsets,
             imports,
             dynamic_function_trampolines: dynamic_trampolines.into_boxed_slice(),
             functions: functions.into_boxed_slice(),
             exports,
             signatures,
             local_memories,
-            data_segments: executable.data_initializers.clone(),
+            data_segments: crate::artifact::DataSegments::Owned(
+                executable.data_initializers.clone(),
+            ),
             passive_data: module.passive_data.clone(),
             local_tables,
             element_segments: module.table_initializers.clone(),
             passive_elements: module.passive_elements.clone(),
             local_globals,
-        })
+            lazy,
+            instance_pool,
+            #[cfg(target_os = "linux")]
+            memory_images,
+            _frame_info_registration: frame_info_registration,
+        };
+        load_span.finish();
+        Ok(artifact)
     }
 
     /// Load a [`UniversalExecutableRef`](crate::UniversalExecutableRef) with this engine.
@@ -285,6 +456,81 @@ impl UniversalEngine {
         &self,
         executable: &UniversalExecutableRef,
     ) -> Result<UniversalArtifact, CompileError> {
+        self.load_universal_executable_placed(executable, CodePlacement::Copy)
+    }
+
+    /// Load a serialized module from a file, executing its code in place when
+    /// possible.
+    ///
+    /// Files produced by
+    /// [`UniversalExecutable::serialize_xip`](crate::UniversalExecutable::serialize_xip)
+    /// carry their code in a page-aligned image laid out exactly as it must
+    /// appear in memory. For such files this maps the file `MAP_PRIVATE`,
+    /// applies relocations through the mapping — faulting in private copies
+    /// of just the pages they touch — and makes the code pages executable,
+    /// without copying any code. The mapping is retained by the engine for as
+    /// long as the engine lives.
+    ///
+    /// Files in the standard
+    /// [`serialize`](wasmer_engine::Executable::serialize) format, or whose
+    /// image cannot be executed in place on this host (for example because it
+    /// was produced with a different page size), are loaded through the
+    /// copying path instead.
+    ///
+    /// # Safety
+    ///
+    /// The file must come from a trusted source: like
+    /// [`UniversalExecutableRef::deserialize`], this interprets the archived
+    /// data without structural validation, and it additionally applies
+    /// relocations at offsets the file controls and marks pages of it
+    /// executable. A malicious file leads to arbitrary code execution.
+    #[cfg(unix)]
+    pub unsafe fn load_universal_executable_file(
+        &self,
+        file: &std::fs::File,
+    ) -> Result<UniversalArtifact, CompileError> {
+        let image = crate::xip::XipImage::map_file(file).map_err(CompileError::Resource)?;
+        // SAFETY: `data` is only used while `image` is alive: the in-place
+        // path below hands `image` over to the engine, and the copying path
+        // copies everything it needs out of the mapping before returning.
+        let data = unsafe { image.as_slice() };
+        if let Some((page_size, image_len, _)) = crate::xip::parse_header(data) {
+            let tail_offset = page_size
+                .checked_add(image_len)
+                .filter(|&offset| offset <= data.len())
+                .ok_or_else(|| {
+                    CompileError::Validate("the executable file is truncated".to_string())
+                })?;
+            let executable = unsafe { UniversalExecutableRef::deserialize(&data[tail_offset..]) }
+                .map_err(|e| CompileError::Validate(e.to_string()))?;
+            // Code produced for another page size is laid out incompatibly,
+            // and unwind or debug information requires registration against
+            // the code memory that the in-place path does not perform.
+            let in_place = page_size == region::page::size()
+                && matches!(executable.debug, rkyv::option::ArchivedOption::None)
+                && !crate::xip::has_unwind_info(&executable);
+            if in_place {
+                return self.load_universal_executable_placed(
+                    &executable,
+                    CodePlacement::InPlace {
+                        image,
+                        code_offset: page_size,
+                    },
+                );
+            }
+            return self.load_universal_executable_ref(&executable);
+        }
+        let executable = unsafe { UniversalExecutableRef::deserialize(data) }
+            .map_err(|e| CompileError::Validate(e.to_string()))?;
+        self.load_universal_executable_ref(&executable)
+    }
+
+    fn load_universal_executable_placed(
+        &self,
+        executable: &UniversalExecutableRef,
+        placement: CodePlacement,
+    ) -> Result<UniversalArtifact, CompileError> {
+        let load_span = self.inner().metrics.phase(Phase::Load);
         let info = &executable.compile_info;
         let module = &info.module;
         let import_counts: ImportCounts = unrkyv(&module.import_counts);
@@ -316,38 +562,91 @@ impl UniversalEngine {
         let passive_data =
             rkyv::Deserialize::deserialize(&module.passive_data, &mut SharedDeserializeMap::new())
                 .map_err(|_| CompileError::Validate("could not deserialize passive data".into()))?;
-        let data_segments = executable.data_initializers.iter();
-        let data_segments = data_segments
-            .map(|s| DataInitializer::from(s).into())
-            .collect();
+        let data_segments = match &placement {
+            // The caller's serialized buffer is not retained past the load,
+            // so the segment bytes must be copied onto the heap.
+            CodePlacement::Copy => crate::artifact::DataSegments::Owned(
+                executable
+                    .data_initializers
+                    .iter()
+                    .map(|s| DataInitializer::from(s).into())
+                    .collect(),
+            ),
+            // The archive lives in the file mapping the engine retains for
+            // the code, so the segment bytes can be used in place.
+            #[cfg(unix)]
+            CodePlacement::InPlace { .. } => crate::artifact::DataSegments::Mapped(
+                executable
+                    .data_initializers
+                    .iter()
+                    .map(|s| {
+                        let init = DataInitializer::from(s);
+                        crate::artifact::MappedDataInitializer {
+                            location: init.location,
+                            data: init.data.as_ptr(),
+                            len: init.data.len(),
+                        }
+                    })
+                    .collect(),
+            ),
+        };
         let element_segments = unrkyv(&module.table_initializers);
         let passive_elements: BTreeMap<wasmer_types::ElemIndex, Box<[FunctionIndex]>> =
             unrkyv(&module.passive_elements);
 
         let import_counts: ImportCounts = unrkyv(&module.import_counts);
-        let mut inner_engine = self.inner_mut();
+        let inner_engine = self.inner();
 
-        let local_functions = executable.function_bodies.iter().map(|(_, b)| b.into());
-        let call_trampolines = executable.function_call_trampolines.iter();
-        let dynamic_trampolines = executable.dynamic_function_trampolines.iter();
         let signatures = module
             .signatures
             .values()
             .map(|sig| inner_engine.signatures.register(sig.into()))
             .collect::<PrimaryMap<SignatureIndex, _>>()
             .into_boxed_slice();
-        let (functions, trampolines, dynamic_trampolines, custom_sections) = inner_engine
-            .allocate(
-                local_functions,
-                call_trampolines.map(|(_, b)| b.into()),
-                dynamic_trampolines.map(|(_, b)| b.into()),
-                executable.custom_sections.iter().map(|(_, s)| s.into()),
-                |idx: LocalFunctionIndex| {
-                    let func_idx = import_counts.function_index(idx);
-                    let sig_idx = module.functions[&func_idx];
-                    (sig_idx, signatures[sig_idx])
-                },
-            )?;
+        let function_signature = |idx: LocalFunctionIndex| {
+            let func_idx = import_counts.function_index(idx);
+            let sig_idx = module.functions[&func_idx];
+            (sig_idx, signatures[sig_idx])
+        };
+        #[cfg(unix)]
+        let mut in_place_executable_end = 0;
+        let mut code_memory = None;
+        let (functions, trampolines, dynamic_trampolines, custom_sections) = match &placement {
+            CodePlacement::Copy => {
+                let trampolines = inner_engine.resolve_call_trampolines(
+                    &signatures,
+                    executable
+                        .function_call_trampolines
+                        .iter()
+                        .map(|(_, b)| b.into()),
+                )?;
+                let mut memory = CodeMemory::new(inner_engine.code_huge_pages);
+                let allocate_span = inner_engine.metrics.phase(Phase::Allocate);
+                let (functions, dynamic_trampolines, custom_sections) = allocate(
+                    &mut memory,
+                    executable.function_bodies.iter().map(|(_, b)| b.into()),
+                    &trampolines,
+                    executable
+                        .dynamic_function_trampolines
+                        .iter()
+                        .map(|(_, b)| b.into()),
+                    executable.custom_sections.iter().map(|(_, s)| s.into()),
+                    function_signature,
+                )?;
+                allocate_span.finish();
+                code_memory = Some(memory);
+                (functions, trampolines, dynamic_trampolines, custom_sections)
+            }
+            #[cfg(unix)]
+            CodePlacement::InPlace { image, code_offset } => {
+                let layout = crate::xip::layout_of(executable, region::page::size());
+                in_place_executable_end = layout.executable_end;
+                // SAFETY: the image stays mapped for the lifetime of the
+                // engine once pushed onto `xip_images` below.
+                let base = unsafe { image.as_slice().as_ptr().add(*code_offset) };
+                crate::xip::resolve_image(base, &layout, function_signature)?
+            }
+        };
         let imports = {
             module
                 .imports
@@ -377,6 +676,7 @@ impl UniversalEngine {
 
         let function_relocations = executable.function_relocations.iter();
         let section_relocations = executable.custom_section_relocations.iter();
+        let link_span = inner_engine.metrics.phase(Phase::Link);
         crate::link_module(
             &functions,
             |func_idx, jt_idx| {
@@ -389,29 +689,93 @@ impl UniversalEngine {
             section_relocations.map(|(i, r)| (i, r.iter().map(unrkyv))),
             &unrkyv(&executable.trampolines),
         );
+        link_span.finish();
 
         // Make all code compiled thus far executable.
-        inner_engine.publish_compiled_code();
+        let publish_span = inner_engine.metrics.phase(Phase::Publish);
+        match placement {
+            CodePlacement::Copy => code_memory.as_mut().expect("infallible").publish(),
+            #[cfg(unix)]
+            CodePlacement::InPlace { image, code_offset } => {
+                image
+                    .publish(code_offset, in_place_executable_end)
+                    .map_err(|e| {
+                        CompileError::Resource(format!(
+                            "failed to publish the in-place code: {}",
+                            e
+                        ))
+                    })?;
+                inner_engine.xip_images.lock().unwrap().push(image);
+            }
+        }
         if let rkyv::option::ArchivedOption::Some(ref d) = executable.debug {
             unsafe {
-                // TODO: safety comment
+                // TODO: safety comment. Note that debug information is only
+                // accepted on the copying path, so `code_memory` is present.
                 let s = CustomSectionRef::from(&executable.custom_sections[&d.eh_frame]);
-                inner_engine.publish_eh_frame(std::slice::from_raw_parts(
-                    *custom_sections[unrkyv(&d.eh_frame)],
-                    s.bytes.len(),
-                ))?;
+                publish_eh_frame(
+                    code_memory.as_mut().expect("infallible"),
+                    std::slice::from_raw_parts(
+                        *custom_sections[unrkyv(&d.eh_frame)],
+                        s.bytes.len(),
+                    ),
+                )?;
             }
         }
+        publish_span.finish();
+        if inner_engine.metrics.enabled() {
+            #[cfg(unix)]
+            let code_bytes = match &code_memory {
+                Some(memory) => memory.executable_size(),
+                None => in_place_executable_end,
+            };
+            #[cfg(not(unix))]
+            let code_bytes = code_memory.as_ref().expect("infallible").executable_size();
+            inner_engine.metrics.module_loaded(code_bytes);
+            inner_engine
+                .metrics
+                .registry_sizes(inner_engine.signatures.len(), inner_engine.func_data.len());
+        }
+        let code_memory = code_memory.map(Arc::new);
         let exports = module
             .exports
             .iter()
             .map(|(s, i)| (unrkyv(s), unrkyv(i)))
             .collect::<BTreeMap<String, ExportIndex>>();
-        Ok(UniversalArtifact {
+        let lazy = match &executable.lazy_functions {
+            rkyv::option::ArchivedOption::Some(lazy_functions) => {
+                let compile_info = rkyv::Deserialize::deserialize(
+                    &executable.compile_info,
+                    &mut SharedDeserializeMap::new(),
+                )
+                .map_err(|_| {
+                    CompileError::Validate("could not deserialize the compile info".into())
+                })?;
+                Some(Arc::new(LazyCompileState::new(
+                    compile_info,
+                    unrkyv(lazy_functions),
+                    &custom_sections,
+                    &functions,
+                    code_memory.clone(),
+                )))
+            }
+            rkyv::option::ArchivedOption::None => None,
+        };
+        if let Some(ref state) = lazy {
+            inner_engine.register_tiering_candidate(state);
+        }
+        let vmoffsets = VMOffsets::for_host().with_archived_module_info(&*module);
+        let instance_pool = inner_engine
+            .instance_pool_capacity
+            .map(|capacity| wasmer_vm::InstancePool::new(capacity, &vmoffsets));
+        #[cfg(target_os = "linux")]
+        let memory_images = build_memory_images(&data_segments.to_initializers(), &import_counts);
+        let artifact = UniversalArtifact {
             engine: self.clone(),
+            _code_memory: code_memory,
             import_counts,
             start_function: unrkyv(&module.start_function),
-            vmoffsets: VMOffsets::for_host().with_archived_module_info(&*module),
+            vmoffsets,
             imports,
             dynamic_function_trampolines: dynamic_trampolines.into_boxed_slice(),
             functions: functions.into_boxed_slice(),
@@ -424,10 +788,152 @@ impl UniversalEngine {
             element_segments,
             passive_elements,
             local_globals,
-        })
+            lazy,
+            instance_pool,
+            #[cfg(target_os = "linux")]
+            memory_images,
+            // The frame information lives in the caller's serialized buffer,
+            // which the engine does not retain past the load, so serialized
+            // modules are not registered for backtrace symbolication.
+            _frame_info_registration: None,
+        };
+        load_span.finish();
+        Ok(artifact)
+    }
+
+    /// Compile the body of a single function from a lazily compiled module and
+    /// publish its address to the module's slot table.
+    ///
+    /// This is reached through `wasmer_vm::libcalls::wasmer_vm_lazy_compile`
+    /// when a compilation stub (see
+    /// [`Compiler::compile_module_lazily`](wasmer_compiler::Compiler)) is
+    /// entered for the first time.
+    #[cfg(feature = "compiler")]
+    pub(crate) fn lazy_compile_function(
+        &self,
+        state: &LazyCompileState,
+        index: LocalFunctionIndex,
+    ) -> Result<*const VMFunctionBody, Box<dyn std::error::Error + Send + Sync>> {
+        // SAFETY: the slots section contains one pointer-sized slot per local
+        // function and lives as long as the engine does.
+        let slot = unsafe { &*(*state.slots as *const AtomicUsize).add(index.index()) };
+        // Compilations of a single module are serialized, both to avoid
+        // compiling the same function twice when racing calls enter the same
+        // stub and to keep the slot writes monotonic.
+        let _compiling = state.lock.lock().unwrap();
+        let already_compiled = slot.load(Ordering::Acquire);
+        if already_compiled != 0 {
+            return Ok(already_compiled as *const VMFunctionBody);
+        }
+        let body = &state.function_bodies[index];
+        let inner_engine = self.inner();
+        let compiled = inner_engine.compiler()?.compile_function(
+            &self.target(),
+            &state.compile_info,
+            &state.translation_state,
+            index,
+            &FunctionBodyData {
+                data: &body.data,
+                module_offset: body.module_offset as usize,
+            },
+        )?;
+        let body_ptr = inner_engine.allocate_lazy_function(state, &compiled)?;
+        slot.store(body_ptr as usize, Ordering::Release);
+        Ok(body_ptr as *const VMFunctionBody)
+    }
+
+    /// Compile the body of a single function from a lazily compiled module.
+    #[cfg(not(feature = "compiler"))]
+    pub(crate) fn lazy_compile_function(
+        &self,
+        _state: &LazyCompileState,
+        _index: LocalFunctionIndex,
+    ) -> Result<*const VMFunctionBody, Box<dyn std::error::Error + Send + Sync>> {
+        Err(CompileError::Codegen(
+            "The UniversalEngine is operating in headless mode, so it can not lazily compile functions."
+                .to_string(),
+        )
+        .into())
     }
 }
 
+/// How the code of an executable being loaded gets into executable memory.
+enum CodePlacement {
+    /// Copy the code into a fresh [`CodeMemory`] allocation.
+    Copy,
+    /// The code is already laid out in an execute-in-place file mapping;
+    /// `code_offset` is where the image starts within it.
+    #[cfg(unix)]
+    InPlace {
+        image: crate::xip::XipImage,
+        code_offset: usize,
+    },
+}
+
+/// The state required to compile the functions of one lazily compiled module
+/// after it has been loaded into a [`UniversalEngine`].
+///
+/// See [`Compiler::compile_module_lazily`](wasmer_compiler::Compiler) for a
+/// description of the overall scheme.
+#[cfg_attr(not(feature = "compiler"), allow(dead_code))]
+pub(crate) struct LazyCompileState {
+    /// Serializes compilations of this module's functions.
+    lock: Mutex<()>,
+    compile_info: CompileModuleInfo,
+    /// Reconstructed from the module signatures, so that the compiler can
+    /// resolve block types without re-translating the module.
+    translation_state: ModuleTranslationState,
+    /// The raw wasm bodies of the module's local functions.
+    function_bodies: PrimaryMap<LocalFunctionIndex, LazyFunctionBody>,
+    /// The allocated custom sections of the module, to resolve relocations in
+    /// lazily compiled bodies.
+    sections: PrimaryMap<SectionIndex, SectionBodyPtr>,
+    /// The address of each local function as seen by the rest of the module,
+    /// i.e. of its compilation stub.
+    functions: PrimaryMap<LocalFunctionIndex, usize>,
+    /// The allocated slot table with one body address per local function, to
+    /// be filled in as functions get compiled.
+    slots: SectionBodyPtr,
+    /// The allocated invocation counter table, bumped by the stubs on every
+    /// call and consulted by the tier-up monitor.
+    counters: SectionBodyPtr,
+    /// Keeps the module's load-time code allocation — which `sections`,
+    /// `functions`, `slots` and `counters` all point into — alive for as long
+    /// as this state is. `None` for execute-in-place modules, whose file
+    /// mapping is retained by the engine instead.
+    _code_memory: Option<Arc<CodeMemory>>,
+}
+
+impl LazyCompileState {
+    fn new(
+        compile_info: CompileModuleInfo,
+        lazy_functions: LazyFunctions,
+        sections: &PrimaryMap<SectionIndex, SectionBodyPtr>,
+        functions: &PrimaryMap<LocalFunctionIndex, VMLocalFunction>,
+        code_memory: Option<Arc<CodeMemory>>,
+    ) -> Self {
+        let translation_state = ModuleTranslationState::from_module_info(&compile_info.module);
+        Self {
+            lock: Mutex::new(()),
+            translation_state,
+            compile_info,
+            function_bodies: lazy_functions.function_bodies,
+            sections: sections.clone(),
+            functions: functions.iter().map(|(_, f)| *f.body as usize).collect(),
+            slots: sections[lazy_functions.slots_section],
+            counters: sections[lazy_functions.counters_section],
+            _code_memory: code_memory,
+        }
+    }
+}
+
+// SAFETY: the raw pointers refer to the module's load-time code, kept alive by
+// `_code_memory` (or, for execute-in-place modules, by the file mapping the
+// engine retains); writes to the slot table they point at are synchronized
+// through atomics and `LazyCompileState::lock`.
+unsafe impl Send for LazyCompileState {}
+unsafe impl Sync for LazyCompileState {}
+
 impl Engine for UniversalEngine {
     /// The target
     fn target(&self) -> &Target {
@@ -472,6 +978,22 @@ impl Engine for UniversalEngine {
         binary: &[u8],
         tunables: &dyn Tunables,
     ) -> Result<Box<dyn wasmer_engine::Executable>, CompileError> {
+        let inner_engine = self.inner();
+        if let Some(cache) = &inner_engine.compile_cache {
+            let key = cache.key(
+                binary,
+                self.target(),
+                inner_engine.features(),
+                inner_engine.lazy_compilation,
+                &inner_engine.compiler()?.config_digest(),
+            );
+            if let Some(hit) = cache.load(&key) {
+                return Ok(Box::new(hit));
+            }
+            let executable = self.compile_universal(binary, tunables)?;
+            cache.store(&key, &executable);
+            return Ok(Box::new(executable));
+        }
         self.compile_universal(binary, tunables)
             .map(|ex| Box::new(ex) as _)
     }
@@ -493,15 +1015,29 @@ impl Engine for UniversalEngine {
 }
 
 /// The inner contents of `UniversalEngine`
+///
+/// Loading a module takes no engine-wide lock: the compiler, features and the
+/// registries are shared directly, the registries synchronize internally, and
+/// the code memory of a loaded module is owned by its artifact. The few
+/// mutable fields below only guard engine-lifetime collections that loads
+/// touch briefly, if at all.
 pub struct UniversalEngineInner {
     /// The compiler
     #[cfg(feature = "compiler")]
     compiler: Option<Box<dyn Compiler>>,
     /// The features to compile the Wasm module with
     features: Features,
-    /// The code memory is responsible of publishing the compiled
-    /// functions to memory.
-    code_memory: Vec<CodeMemory>,
+    /// The memory backing function bodies compiled after their module was
+    /// already loaded — lazily compiled bodies and tier-up recompilations.
+    /// These stay alive for as long as the engine does.
+    lazy_code: Mutex<Vec<CodeMemory>>,
+    /// Reports phase timings and counters to the configured sink (see
+    /// [`Universal::metrics`](crate::Universal)).
+    pub(crate) metrics: Recorder,
+    /// Function call trampolines shared between all loaded modules, keyed by
+    /// their signature (see
+    /// [`resolve_call_trampolines`](Self::resolve_call_trampolines)).
+    call_trampolines: Mutex<TrampolineCache>,
     /// The signature registry is used mainly to operate with trampolines
     /// performantly.
     pub(crate) signatures: SignatureRegistry,
@@ -509,6 +1045,37 @@ pub struct UniversalEngineInner {
     /// functions with the same `VMCallerCheckedAnyfunc` will have the same `VMFuncRef`.
     /// It also guarantees that the `VMFuncRef`s stay valid until the engine is dropped.
     func_data: Arc<FuncDataRegistry>,
+    /// Whether to defer compilation of the wasm function bodies to their first
+    /// call (see [`UniversalEngine::compile_universal`]).
+    pub(crate) lazy_compilation: bool,
+    /// When set, every loaded artifact preallocates a pool of this many
+    /// instance slots and instantiation draws from the pool rather than the
+    /// global allocator.
+    pub(crate) instance_pool_capacity: Option<usize>,
+    /// Whether to back code mappings with huge pages (see
+    /// [`CodeMemory::new`]).
+    pub(crate) code_huge_pages: bool,
+    /// The on-disk cache of compiled executables consulted by
+    /// [`Engine::compile`], when one is configured (see
+    /// [`Universal::compile_cache`](crate::Universal::compile_cache)).
+    #[cfg(feature = "compiler")]
+    pub(crate) compile_cache: Option<crate::cache::CompileCache>,
+    /// The file mappings backing modules loaded for execution in place (see
+    /// [`UniversalEngine::load_universal_executable_file`]). Like
+    /// `lazy_code`, these stay alive for as long as the engine does.
+    #[cfg(unix)]
+    xip_images: Mutex<Vec<crate::xip::XipImage>>,
+    /// The compiler functions of lazily compiled modules are recompiled with
+    /// on a background thread once they cross `tier_up_threshold` calls.
+    #[cfg(feature = "compiler")]
+    pub(crate) tier_up_compiler: Option<Box<dyn Compiler>>,
+    /// The invocation count past which a function becomes eligible for
+    /// tier-up recompilation.
+    #[cfg(feature = "compiler")]
+    pub(crate) tier_up_threshold: u64,
+    /// The loaded lazily compiled modules watched by the tier-up monitor.
+    #[cfg(feature = "compiler")]
+    tiering: Mutex<Vec<Arc<TieringModule>>>,
 }
 
 impl UniversalEngineInner {
@@ -541,140 +1108,382 @@ impl UniversalEngineInner {
         &self.features
     }
 
-    /// Allocate compiled functions into memory
-    #[allow(clippy::type_complexity)]
-    pub(crate) fn allocate<'a>(
-        &mut self,
-        local_functions: impl ExactSizeIterator<Item = FunctionBodyRef<'a>>,
-        call_trampolines: impl ExactSizeIterator<Item = FunctionBodyRef<'a>>,
-        dynamic_trampolines: impl ExactSizeIterator<Item = FunctionBodyRef<'a>>,
-        custom_sections: impl ExactSizeIterator<Item = CustomSectionRef<'a>>,
-        function_signature: impl Fn(LocalFunctionIndex) -> (SignatureIndex, VMSharedSignatureIndex),
-    ) -> Result<
-        (
-            PrimaryMap<LocalFunctionIndex, VMLocalFunction>,
-            PrimaryMap<SignatureIndex, VMTrampoline>,
-            PrimaryMap<FunctionIndex, FunctionBodyPtr>,
-            PrimaryMap<SectionIndex, SectionBodyPtr>,
-        ),
-        CompileError,
-    > {
-        let code_memory = &mut self.code_memory;
-        let function_count = local_functions.len();
-        let call_trampoline_count = call_trampolines.len();
-        let function_bodies = call_trampolines
-            .chain(local_functions)
-            .chain(dynamic_trampolines)
-            .collect::<Vec<_>>();
-
-        // TOOD: this shouldn't be necessary....
-        let mut section_types = Vec::with_capacity(custom_sections.len());
-        let mut executable_sections = Vec::new();
-        let mut data_sections = Vec::new();
-        for section in custom_sections {
-            if let CustomSectionProtection::ReadExecute = section.protection {
-                executable_sections.push(section);
-            } else {
-                data_sections.push(section);
-            }
-            section_types.push(section.protection);
+    /// Allocate a single lazily or tier-up compiled function body into
+    /// engine-owned memory, resolve its relocations and make it executable.
+    ///
+    /// Unlike the load-time [`allocate`] this does not deal with trampolines
+    /// or custom sections – those were already allocated when the module was
+    /// loaded. Function calls resolve to the stubs allocated at load time, so
+    /// the body never needs to wait for – or trigger – the compilation of its
+    /// callees.
+    #[cfg(feature = "compiler")]
+    pub(crate) fn allocate_lazy_function(
+        &self,
+        state: &LazyCompileState,
+        compiled: &wasmer_compiler::CompiledFunction,
+    ) -> Result<*const VMFunctionBody, CompileError> {
+        let mut lazy_code = self.lazy_code.lock().unwrap();
+        lazy_code.push(CodeMemory::new(self.code_huge_pages));
+        let code_memory = lazy_code.last_mut().expect("infallible");
+        let (allocated_functions, _, _) = code_memory
+            .allocate(&[(&compiled.body).into()], &[], &[])
+            .map_err(|message| {
+                CompileError::Resource(format!(
+                    "failed to allocate memory for lazily compiled function: {}",
+                    message
+                ))
+            })?;
+        let body_ptr = allocated_functions[0].as_ptr();
+        for relocation in &compiled.relocations {
+            crate::link::apply_relocation(
+                body_ptr as usize,
+                relocation,
+                |idx: LocalFunctionIndex| state.functions[idx],
+                |_, jt| compiled.jt_offsets[jt],
+                &state.sections,
+                &None,
+                &Default::default(),
+            );
         }
-        code_memory.push(CodeMemory::new());
-        let code_memory = self.code_memory.last_mut().expect("infallible");
-
-        let (mut allocated_functions, allocated_executable_sections, allocated_data_sections) =
-            code_memory
-                .allocate(
-                    function_bodies.as_slice(),
-                    executable_sections.as_slice(),
-                    data_sections.as_slice(),
-                )
-                .map_err(|message| {
-                    CompileError::Resource(format!(
-                        "failed to allocate memory for functions: {}",
-                        message
-                    ))
-                })?;
+        code_memory.publish();
+        Ok(body_ptr)
+    }
 
-        let mut allocated_function_call_trampolines: PrimaryMap<SignatureIndex, VMTrampoline> =
-            PrimaryMap::new();
-        for ptr in allocated_functions
-            .drain(0..call_trampoline_count)
-            .map(|slice| slice.as_ptr())
-        {
-            // TODO: What in damnation have you done?! – Bannon
-            let trampoline =
-                unsafe { std::mem::transmute::<*const VMFunctionBody, VMTrampoline>(ptr) };
-            allocated_function_call_trampolines.push(trampoline);
+    /// Resolve the function call trampolines of a module being loaded against
+    /// the engine-wide cache.
+    ///
+    /// `bodies` holds the module's compiled trampolines, one per entry of
+    /// `signatures`. A call trampoline depends only on the signature of the
+    /// function it invokes, so signatures that already have a published
+    /// trampoline reuse the cached copy and their body is discarded; the
+    /// remaining bodies are allocated into engine-owned code memory — alive
+    /// for as long as the engine is — and enter the cache for every later
+    /// load to pick up.
+    pub(crate) fn resolve_call_trampolines<'a>(
+        &self,
+        signatures: &BoxedSlice<SignatureIndex, VMSharedSignatureIndex>,
+        bodies: impl ExactSizeIterator<Item = FunctionBodyRef<'a>>,
+    ) -> Result<PrimaryMap<SignatureIndex, VMTrampoline>, CompileError> {
+        let mut cache = self.call_trampolines.lock().unwrap();
+        let cache = &mut *cache;
+        let mut resolved: Vec<Option<VMTrampoline>> = Vec::with_capacity(bodies.len());
+        let mut missing = Vec::new();
+        for (idx, body) in bodies.enumerate() {
+            let sig = signatures[SignatureIndex::new(idx)];
+            let cached = cache.trampolines.get(&sig).copied();
+            if cached.is_none() {
+                missing.push((idx, sig, body));
+            }
+            resolved.push(cached);
+        }
+        if !missing.is_empty() {
+            cache.code.push(CodeMemory::new(self.code_huge_pages));
+            let code_memory = cache.code.last_mut().expect("infallible");
+            let bodies = missing.iter().map(|&(_, _, body)| body).collect::<Vec<_>>();
+            let (allocated, _, _) =
+                code_memory
+                    .allocate(&bodies, &[], &[])
+                    .map_err(|message| {
+                        CompileError::Resource(format!(
+                            "failed to allocate memory for trampolines: {}",
+                            message
+                        ))
+                    })?;
+            for (&(idx, sig, _), slice) in missing.iter().zip(allocated) {
+                // TODO: What in damnation have you done?! – Bannon
+                let trampoline = unsafe {
+                    std::mem::transmute::<*const VMFunctionBody, VMTrampoline>(slice.as_ptr())
+                };
+                cache.trampolines.insert(sig, trampoline);
+                resolved[idx] = Some(trampoline);
+            }
+            code_memory.publish();
         }
+        Ok(resolved
+            .into_iter()
+            .map(|trampoline| trampoline.expect("infallible"))
+            .collect())
+    }
 
-        let allocated_functions_result = allocated_functions
-            .drain(0..function_count)
-            .enumerate()
-            .map(|(index, slice)| -> Result<_, CompileError> {
-                let index = LocalFunctionIndex::new(index);
-                let (sig_idx, sig) = function_signature(index);
-                Ok(VMLocalFunction {
-                    body: FunctionBodyPtr(slice.as_ptr()),
-                    length: u32::try_from(slice.len()).map_err(|_| {
-                        CompileError::Codegen("function body length exceeds 4GiB".into())
-                    })?,
-                    signature: sig,
-                    trampoline: allocated_function_call_trampolines[sig_idx],
-                })
-            })
-            .collect::<Result<PrimaryMap<LocalFunctionIndex, _>, _>>()?;
+    /// Shared func metadata registry.
+    pub(crate) fn func_data(&self) -> &Arc<FuncDataRegistry> {
+        &self.func_data
+    }
 
-        let allocated_dynamic_function_trampolines = allocated_functions
-            .drain(..)
-            .map(|slice| FunctionBodyPtr(slice.as_ptr()))
-            .collect::<PrimaryMap<FunctionIndex, _>>();
+    /// Put a freshly loaded lazily compiled module under watch by the tier-up
+    /// monitor, if a tier-up compiler is configured.
+    #[cfg(feature = "compiler")]
+    pub(crate) fn register_tiering_candidate(&self, state: &Arc<LazyCompileState>) {
+        if self.tier_up_compiler.is_none() {
+            return;
+        }
+        let tiered = (0..state.function_bodies.len())
+            .map(|_| AtomicBool::new(false))
+            .collect();
+        self.tiering.lock().unwrap().push(Arc::new(TieringModule {
+            state: state.clone(),
+            tiered,
+        }));
+    }
 
-        let mut exec_iter = allocated_executable_sections.iter();
-        let mut data_iter = allocated_data_sections.iter();
-        let allocated_custom_sections = section_types
-            .into_iter()
-            .map(|protection| {
-                SectionBodyPtr(
-                    if protection == CustomSectionProtection::ReadExecute {
-                        exec_iter.next()
-                    } else {
-                        data_iter.next()
-                    }
-                    .unwrap()
-                    .as_ptr(),
-                )
-            })
-            .collect::<PrimaryMap<SectionIndex, _>>();
+    #[cfg(not(feature = "compiler"))]
+    pub(crate) fn register_tiering_candidate(&self, _state: &Arc<LazyCompileState>) {}
 
-        Ok((
-            allocated_functions_result,
-            allocated_function_call_trampolines,
-            allocated_dynamic_function_trampolines,
-            allocated_custom_sections,
-        ))
+    /// Recompile one function with the tier-up compiler and swap its body
+    /// address into the module's slot table.
+    ///
+    /// The slot must already hold a tier-0 body: a zero slot could be
+    /// concurrently filled in by [`UniversalEngine::lazy_compile_function`],
+    /// which only ever writes a slot it observed to be zero.
+    #[cfg(feature = "compiler")]
+    fn tier_up_function(
+        &self,
+        target: &Target,
+        state: &LazyCompileState,
+        index: LocalFunctionIndex,
+    ) -> Result<(), CompileError> {
+        let compiler = self
+            .tier_up_compiler
+            .as_deref()
+            .expect("tier_up_function requires a tier-up compiler");
+        let body = &state.function_bodies[index];
+        let compiled = compiler.compile_function(
+            target,
+            &state.compile_info,
+            &state.translation_state,
+            index,
+            &FunctionBodyData {
+                data: &body.data,
+                module_offset: body.module_offset as usize,
+            },
+        )?;
+        let body_ptr = self.allocate_lazy_function(state, &compiled)?;
+        // SAFETY: the slots section contains one pointer-sized slot per local
+        // function and lives as long as this state does.
+        let slot = unsafe { &*(*state.slots as *const AtomicUsize).add(index.index()) };
+        slot.store(body_ptr as usize, Ordering::Release);
+        Ok(())
     }
+}
+
+/// The engine-wide function call trampoline cache.
+///
+/// See [`resolve_call_trampolines`](UniversalEngineInner::resolve_call_trampolines).
+#[derive(Default)]
+struct TrampolineCache {
+    /// The published trampoline for each signature seen so far.
+    trampolines: HashMap<VMSharedSignatureIndex, VMTrampoline>,
+    /// The memory backing the cached trampoline bodies. Like `lazy_code`,
+    /// these stay alive for as long as the engine does.
+    code: Vec<CodeMemory>,
+}
+
+/// Allocate compiled functions into `code_memory`
+///
+/// The function call trampolines are not allocated here: the caller resolves
+/// them against the engine-wide cache first (see
+/// [`resolve_call_trampolines`](UniversalEngineInner::resolve_call_trampolines))
+/// and passes the result in as `call_trampolines`.
+#[allow(clippy::type_complexity)]
+fn allocate<'a>(
+    code_memory: &mut CodeMemory,
+    local_functions: impl ExactSizeIterator<Item = FunctionBodyRef<'a>>,
+    call_trampolines: &PrimaryMap<SignatureIndex, VMTrampoline>,
+    dynamic_trampolines: impl ExactSizeIterator<Item = FunctionBodyRef<'a>>,
+    custom_sections: impl ExactSizeIterator<Item = CustomSectionRef<'a>>,
+    function_signature: impl Fn(LocalFunctionIndex) -> (SignatureIndex, VMSharedSignatureIndex),
+) -> Result<
+    (
+        PrimaryMap<LocalFunctionIndex, VMLocalFunction>,
+        PrimaryMap<FunctionIndex, FunctionBodyPtr>,
+        PrimaryMap<SectionIndex, SectionBodyPtr>,
+    ),
+    CompileError,
+> {
+    let function_count = local_functions.len();
+    let function_bodies = local_functions
+        .chain(dynamic_trampolines)
+        .collect::<Vec<_>>();
 
-    /// Make memory containing compiled code executable.
-    pub(crate) fn publish_compiled_code(&mut self) {
-        self.code_memory.last_mut().unwrap().publish();
+    // TOOD: this shouldn't be necessary....
+    let mut section_types = Vec::with_capacity(custom_sections.len());
+    let mut executable_sections = Vec::new();
+    let mut data_sections = Vec::new();
+    for section in custom_sections {
+        if let CustomSectionProtection::ReadExecute = section.protection {
+            executable_sections.push(section);
+        } else {
+            data_sections.push(section);
+        }
+        section_types.push(section.protection);
     }
 
-    /// Register DWARF-type exception handling information associated with the code.
-    pub(crate) fn publish_eh_frame(&mut self, eh_frame: &[u8]) -> Result<(), CompileError> {
-        self.code_memory
-            .last_mut()
-            .unwrap()
-            .unwind_registry_mut()
-            .publish(eh_frame)
-            .map_err(|e| {
-                CompileError::Resource(format!("Error while publishing the unwind code: {}", e))
+    let (mut allocated_functions, allocated_executable_sections, allocated_data_sections) =
+        code_memory
+            .allocate(
+                function_bodies.as_slice(),
+                executable_sections.as_slice(),
+                data_sections.as_slice(),
+            )
+            .map_err(|message| {
+                CompileError::Resource(format!(
+                    "failed to allocate memory for functions: {}",
+                    message
+                ))
             })?;
-        Ok(())
+
+    let allocated_functions_result = allocated_functions
+        .drain(0..function_count)
+        .enumerate()
+        .map(|(index, slice)| -> Result<_, CompileError> {
+            let index = LocalFunctionIndex::new(index);
+            let (sig_idx, sig) = function_signature(index);
+            Ok(VMLocalFunction {
+                body: FunctionBodyPtr(slice.as_ptr()),
+                length: u32::try_from(slice.len()).map_err(|_| {
+                    CompileError::Codegen("function body length exceeds 4GiB".into())
+                })?,
+                signature: sig,
+                trampoline: call_trampolines[sig_idx],
+            })
+        })
+        .collect::<Result<PrimaryMap<LocalFunctionIndex, _>, _>>()?;
+
+    let allocated_dynamic_function_trampolines = allocated_functions
+        .drain(..)
+        .map(|slice| FunctionBodyPtr(slice.as_ptr()))
+        .collect::<PrimaryMap<FunctionIndex, _>>();
+
+    let mut exec_iter = allocated_executable_sections.iter();
+    let mut data_iter = allocated_data_sections.iter();
+    let allocated_custom_sections = section_types
+        .into_iter()
+        .map(|protection| {
+            SectionBodyPtr(
+                if protection == CustomSectionProtection::ReadExecute {
+                    exec_iter.next()
+                } else {
+                    data_iter.next()
+                }
+                .unwrap()
+                .as_ptr(),
+            )
+        })
+        .collect::<PrimaryMap<SectionIndex, _>>();
+
+    Ok((
+        allocated_functions_result,
+        allocated_dynamic_function_trampolines,
+        allocated_custom_sections,
+    ))
+}
+
+/// Register DWARF-type exception handling information associated with the code.
+fn publish_eh_frame(code_memory: &mut CodeMemory, eh_frame: &[u8]) -> Result<(), CompileError> {
+    code_memory
+        .unwind_registry_mut()
+        .publish(eh_frame)
+        .map_err(|e| {
+            CompileError::Resource(format!("Error while publishing the unwind code: {}", e))
+        })?;
+    Ok(())
+}
+
+/// A loaded lazily compiled module whose hot functions are recompiled with
+/// the engine's tier-up compiler.
+#[cfg(feature = "compiler")]
+struct TieringModule {
+    state: Arc<LazyCompileState>,
+    /// Which local functions were already handed to the tier-up compiler
+    /// (successfully or not).
+    tiered: Box<[AtomicBool]>,
+}
+
+/// Build copy-on-write images of the initial memory contents for the local
+/// memories whose data segments all have statically known offsets.
+///
+/// Imported memories are skipped (their mapping may be shared with other
+/// instances), as are memories with a segment whose offset depends on a
+/// global. Failure to materialize an image is not an error; the affected
+/// memory simply keeps the byte-copy initialization path.
+#[cfg(target_os = "linux")]
+fn build_memory_images(
+    data_segments: &[DataInitializer<'_>],
+    import_counts: &ImportCounts,
+) -> Vec<(MemoryIndex, Arc<wasmer_vm::MemoryImage>)> {
+    let memories = data_segments
+        .iter()
+        .map(|segment| segment.location.memory_index)
+        .collect::<std::collections::BTreeSet<_>>();
+    let mut images = Vec::new();
+    for memory_index in memories {
+        if (memory_index.as_u32()) < import_counts.memories {
+            continue;
+        }
+        let initializers = data_segments
+            .iter()
+            .filter(|segment| segment.location.memory_index == memory_index)
+            .map(|segment| DataInitializer {
+                location: segment.location.clone(),
+                data: segment.data,
+            })
+            .collect::<Vec<DataInitializer<'_>>>();
+        if initializers
+            .iter()
+            .any(|init| init.location.base.is_some())
+        {
+            continue;
+        }
+        if let Ok(image) = wasmer_vm::MemoryImage::new(&initializers) {
+            images.push((memory_index, Arc::new(image)));
+        }
     }
+    images
+}
 
-    /// Shared func metadata registry.
-    pub(crate) fn func_data(&self) -> &Arc<FuncDataRegistry> {
-        &self.func_data
+/// How often the tier-up monitor samples the invocation counters.
+#[cfg(feature = "compiler")]
+const TIER_UP_POLL_INTERVAL: std::time::Duration = std::time::Duration::from_millis(10);
+
+/// The body of the background thread driving tier-up recompilation.
+///
+/// The thread only holds a weak reference to the engine internals and exits
+/// once the engine has been dropped.
+#[cfg(feature = "compiler")]
+fn tier_up_monitor(inner: std::sync::Weak<UniversalEngineInner>, target: Arc<Target>) {
+    loop {
+        std::thread::sleep(TIER_UP_POLL_INTERVAL);
+        let inner = match inner.upgrade() {
+            Some(inner) => inner,
+            None => return,
+        };
+        let threshold = inner.tier_up_threshold;
+        let modules = inner.tiering.lock().unwrap().clone();
+        for module in &modules {
+            let state = &module.state;
+            for index in state.function_bodies.keys() {
+                if module.tiered[index.index()].load(Ordering::Relaxed) {
+                    continue;
+                }
+                // SAFETY: both tables contain one 8-byte entry per local
+                // function and live as long as the state does.
+                let (slot, counter) = unsafe {
+                    let slot = &*(*state.slots as *const AtomicUsize).add(index.index());
+                    let counter = &*(*state.counters as *const AtomicU64).add(index.index());
+                    (slot.load(Ordering::Acquire), counter.load(Ordering::Relaxed))
+                };
+                // Only functions that already have a tier-0 body are eligible:
+                // a zero slot was either never called or is being filled in by
+                // `lazy_compile_function` right now.
+                if slot == 0 || counter < threshold {
+                    continue;
+                }
+                // Whether recompilation succeeded or not, don't try again; on
+                // failure the function simply stays on its tier-0 body, which
+                // remains correct.
+                drop(inner.tier_up_function(&target, state, index));
+                module.tiered[index.index()].store(true, Ordering::Relaxed);
+            }
+        }
     }
 }
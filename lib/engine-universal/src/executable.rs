@@ -3,7 +3,9 @@ use std::sync::Arc;
 use enumset::EnumSet;
 use rkyv::de::deserializers::SharedDeserializeMap;
 use rkyv::ser::serializers::{
-    AllocScratchError, AllocSerializer, CompositeSerializerError, SharedSerializeMapError,
+    AllocScratch, AllocScratchError, AllocSerializer, CompositeSerializer,
+    CompositeSerializerError, FallbackScratch, HeapScratch, SharedSerializeMap,
+    SharedSerializeMapError, WriteSerializer,
 };
 use wasmer_compiler::{
     CompileError, CompileModuleInfo, CompiledFunctionFrameInfo, CpuFeature, CustomSection, Dwarf,
@@ -80,6 +82,34 @@ impl<'a> UniversalExecutableRef<'a> {
         })
     }
 
+    /// The name of the function at `index`, from the export, name or import
+    /// sections in that order.
+    ///
+    /// Unlike going through
+    /// [`Executable::function_name`](wasmer_engine::Executable::function_name),
+    /// the returned name borrows from the underlying buffer rather than from
+    /// this reference.
+    pub fn function_name(&self, index: FunctionIndex) -> Option<&'a str> {
+        let module = &self.archive.compile_info.module;
+        // First, lets see if there's a name by which this function is exported.
+        for (name, idx) in module.exports.iter() {
+            match idx {
+                &ExportIndex::Function(fi) if fi == index => return Some(&*name),
+                _ => continue,
+            }
+        }
+        if let Some(r) = module.function_names.get(&index) {
+            return Some(&**r);
+        }
+        for ((_, field, _), idx) in module.imports.iter() {
+            match idx {
+                &ImportIndex::Function(fi) if fi == index => return Some(&*field),
+                _ => continue,
+            }
+        }
+        None
+    }
+
     // TODO(0-copy): this should never fail.
     /// Convert this reference to an owned `UniversalExecutable` value.
     pub fn to_owned(self) -> Result<UniversalExecutable, DeserializeError> {
@@ -99,7 +129,9 @@ pub struct UniversalExecutable {
     pub(crate) function_bodies: PrimaryMap<LocalFunctionIndex, FunctionBody>,
     pub(crate) function_relocations: PrimaryMap<LocalFunctionIndex, Vec<Relocation>>,
     pub(crate) function_jt_offsets: PrimaryMap<LocalFunctionIndex, JumpTableOffsets>,
-    pub(crate) function_frame_info: PrimaryMap<LocalFunctionIndex, CompiledFunctionFrameInfo>,
+    // Arc'd so that loading can hand the frame information to the lazy frame
+    // info registration without copying it out of the executable.
+    pub(crate) function_frame_info: Arc<PrimaryMap<LocalFunctionIndex, CompiledFunctionFrameInfo>>,
     pub(crate) function_call_trampolines: PrimaryMap<SignatureIndex, FunctionBody>,
     pub(crate) dynamic_function_trampolines: PrimaryMap<FunctionIndex, FunctionBody>,
     pub(crate) custom_sections: PrimaryMap<SectionIndex, CustomSection>,
@@ -111,6 +143,34 @@ pub struct UniversalExecutable {
     pub(crate) compile_info: CompileModuleInfo,
     pub(crate) data_initializers: Vec<OwnedDataInitializer>,
     pub(crate) cpu_features: u64,
+    // Present when this executable was compiled lazily: `function_bodies`
+    // above then holds compilation stubs and the real wasm bodies live here,
+    // to be compiled one by one on first call.
+    pub(crate) lazy_functions: Option<LazyFunctions>,
+}
+
+/// The raw wasm function bodies of a lazily compiled module.
+///
+/// [`UniversalEngine::compile_universal`](crate::UniversalEngine) stores these
+/// in the [`UniversalExecutable`] when lazy compilation is enabled, so that the
+/// engine can compile each body on the function's first call.
+#[derive(Clone, rkyv::Archive, rkyv::Deserialize, rkyv::Serialize)]
+pub struct LazyFunctions {
+    /// The custom section holding one body address slot per local function.
+    pub(crate) slots_section: SectionIndex,
+    /// The custom section holding one invocation counter per local function.
+    pub(crate) counters_section: SectionIndex,
+    /// The unmodified wasm code section entries (locals and operators).
+    pub(crate) function_bodies: PrimaryMap<LocalFunctionIndex, LazyFunctionBody>,
+}
+
+/// A single not-yet-compiled wasm function body.
+#[derive(Clone, rkyv::Archive, rkyv::Deserialize, rkyv::Serialize)]
+pub struct LazyFunctionBody {
+    /// The function body bytes, as seen in the wasm code section.
+    pub(crate) data: Vec<u8>,
+    /// Body offset relative to the wasm module file, for source locations.
+    pub(crate) module_offset: u64,
 }
 
 #[derive(thiserror::Error, Debug)]
@@ -124,6 +184,110 @@ pub enum ExecutableSerializeError {
             SharedSerializeMapError,
         >,
     ),
+    #[error("could not write out the executable data")]
+    Write(
+        #[source]
+        CompositeSerializerError<std::io::Error, AllocScratchError, SharedSerializeMapError>,
+    ),
+}
+
+impl UniversalExecutable {
+    /// Serialize this executable into `writer`, streaming the archive out as
+    /// it is built.
+    ///
+    /// The output is byte-for-byte identical to
+    /// [`serialize`](wasmer_engine::Executable::serialize)'s, but the archive
+    /// is never held in memory in its entirety, which keeps memory use
+    /// bounded when serializing many modules back to back.
+    pub fn serialize_to<W: std::io::Write>(
+        &self,
+        mut writer: W,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        // See `serialize` for the format. The archived positions are relative
+        // to the end of the magic header, so the header is written outside of
+        // the serializer.
+        writer.write_all(&MAGIC_HEADER)?;
+        let mut serializer = CompositeSerializer::new(
+            WriteSerializer::new(&mut writer),
+            FallbackScratch::<HeapScratch<1024>, AllocScratch>::default(),
+            SharedSerializeMap::default(),
+        );
+        let pos = rkyv::ser::Serializer::serialize_value(&mut serializer, self)
+            .map_err(ExecutableSerializeError::Write)? as u64;
+        writer.write_all(&pos.to_le_bytes())?;
+        Ok(())
+    }
+
+    /// Serialize this executable into the execute-in-place format understood
+    /// by [`UniversalEngine::load_universal_executable_file`]
+    /// (crate::UniversalEngine::load_universal_executable_file).
+    ///
+    /// The output embeds, ahead of the standard
+    /// [`serialize`](wasmer_engine::Executable::serialize) payload, a
+    /// page-aligned image of the code laid out exactly as it must appear in
+    /// memory, so that loading can map the file and execute the code in place
+    /// instead of copying it out. The image is tied to the page size of the
+    /// serializing host; loading the file on a host with a different page
+    /// size falls back to the copying path.
+    ///
+    /// Executables carrying unwind or debug information cannot be executed in
+    /// place, so serializing them with this method fails.
+    #[cfg(unix)]
+    pub fn serialize_xip(&self) -> Result<Vec<u8>, Box<dyn std::error::Error + Send + Sync>> {
+        let has_unwind_info = self
+            .function_bodies
+            .values()
+            .chain(self.function_call_trampolines.values())
+            .chain(self.dynamic_function_trampolines.values())
+            .any(|body| body.unwind_info.is_some());
+        if has_unwind_info || self.debug.is_some() {
+            return Err("executables with unwind or debug information \
+                        cannot be executed in place"
+                .into());
+        }
+        let page_size = region::page::size();
+        let layout = crate::xip::XipLayout::compute(
+            self.function_call_trampolines.values().map(|b| b.body.len()),
+            self.function_bodies.values().map(|b| b.body.len()),
+            self.dynamic_function_trampolines
+                .values()
+                .map(|b| b.body.len()),
+            self.custom_sections
+                .values()
+                .map(|s| (s.protection, s.bytes.len())),
+            page_size,
+        );
+        let tail = wasmer_engine::Executable::serialize(self)?;
+        let mut out = vec![0u8; page_size + layout.image_len + tail.len()];
+        crate::xip::write_header(&mut out[..page_size], page_size, &layout);
+        {
+            let image = &mut out[page_size..page_size + layout.image_len];
+            let chunks = layout
+                .trampolines
+                .iter()
+                .zip(self.function_call_trampolines.values().map(|b| &b.body[..]))
+                .chain(
+                    layout
+                        .functions
+                        .iter()
+                        .zip(self.function_bodies.values().map(|b| &b.body[..])),
+                )
+                .chain(layout.dynamic_trampolines.iter().zip(
+                    self.dynamic_function_trampolines.values().map(|b| &b.body[..]),
+                ))
+                .chain(
+                    layout
+                        .sections
+                        .iter()
+                        .zip(self.custom_sections.values().map(|s| s.bytes.as_slice())),
+                );
+            for (chunk, bytes) in chunks {
+                image[chunk.offset..chunk.offset + chunk.len].copy_from_slice(bytes);
+            }
+        }
+        out[page_size + layout.image_len..].copy_from_slice(&tail);
+        Ok(out)
+    }
 }
 
 impl wasmer_engine::Executable for UniversalExecutable {
@@ -166,6 +330,13 @@ impl wasmer_engine::Executable for UniversalExecutable {
         Ok(out)
     }
 
+    fn serialize_to(
+        &self,
+        writer: &mut dyn std::io::Write,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        Self::serialize_to(self, writer)
+    }
+
     fn function_name(&self, index: FunctionIndex) -> Option<&str> {
         let module = &self.compile_info.module;
         // First, lets see if there's a name by which this function is exported.
@@ -212,25 +383,15 @@ impl<'a> wasmer_engine::Executable for UniversalExecutableRef<'a> {
         Ok(self.buffer.to_vec())
     }
 
+    fn serialize_to(
+        &self,
+        writer: &mut dyn std::io::Write,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        Ok(writer.write_all(self.buffer)?)
+    }
+
     fn function_name(&self, index: FunctionIndex) -> Option<&str> {
-        let module = &self.compile_info.module;
-        // First, lets see if there's a name by which this function is exported.
-        for (name, idx) in module.exports.iter() {
-            match idx {
-                &ExportIndex::Function(fi) if fi == index => return Some(&*name),
-                _ => continue,
-            }
-        }
-        if let Some(r) = module.function_names.get(&index) {
-            return Some(&**r);
-        }
-        for ((_, field, _), idx) in module.imports.iter() {
-            match idx {
-                &ImportIndex::Function(fi) if fi == index => return Some(&*field),
-                _ => continue,
-            }
-        }
-        None
+        UniversalExecutableRef::function_name(self, index)
     }
 }
 
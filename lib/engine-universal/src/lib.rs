@@ -26,11 +26,16 @@
 
 mod artifact;
 mod builder;
+#[cfg(feature = "compiler")]
+mod cache;
 mod code_memory;
 mod engine;
 mod executable;
 mod link;
+mod metrics;
 mod unwind;
+#[cfg(unix)]
+mod xip;
 
 pub use crate::artifact::UniversalArtifact;
 pub use crate::builder::Universal;
@@ -38,6 +43,7 @@ pub use crate::code_memory::CodeMemory;
 pub use crate::engine::UniversalEngine;
 pub use crate::executable::{UniversalExecutable, UniversalExecutableRef};
 pub use crate::link::link_module;
+pub use crate::metrics::{EngineMetrics, MetricsSink, Phase};
 
 /// Version number of this crate.
 pub const VERSION: &str = env!("CARGO_PKG_VERSION");
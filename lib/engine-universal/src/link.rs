@@ -1,7 +1,9 @@
 //! Linking for Universal-compiled code.
 
+use rayon::prelude::*;
 use std::collections::HashMap;
 use std::ptr::{read_unaligned, write_unaligned};
+use std::sync::Mutex;
 use wasmer_compiler::{
     JumpTable, Relocation, RelocationKind, RelocationTarget, SectionIndex, TrampolinesSection,
 };
@@ -32,11 +34,11 @@ fn use_trampoline(
     address: usize,
     allocated_sections: &PrimaryMap<SectionIndex, SectionBodyPtr>,
     trampolines: &Option<TrampolinesSection>,
-    map: &mut HashMap<usize, usize>,
+    map: &Mutex<HashMap<usize, usize>>,
 ) -> Option<usize> {
     match trampolines {
         Some(trampolines) => Some(trampolines_add(
-            map,
+            &mut map.lock().unwrap(),
             trampolines,
             address,
             *allocated_sections[trampolines.section_index] as usize,
@@ -67,24 +69,24 @@ fn fill_trampoline_map(
     map
 }
 
-fn apply_relocation(
+pub(crate) fn apply_relocation(
     body: usize,
     r: &Relocation,
-    allocated_functions: &PrimaryMap<LocalFunctionIndex, VMLocalFunction>,
+    function_address: impl Fn(LocalFunctionIndex) -> usize,
     jt_offsets: impl Fn(LocalFunctionIndex, JumpTable) -> wasmer_compiler::CodeOffset,
     allocated_sections: &PrimaryMap<SectionIndex, SectionBodyPtr>,
     trampolines: &Option<TrampolinesSection>,
-    trampolines_map: &mut HashMap<usize, usize>,
+    trampolines_map: &Mutex<HashMap<usize, usize>>,
 ) {
     let target_func_address: usize = match r.reloc_target {
-        RelocationTarget::LocalFunc(index) => *allocated_functions[index].body as usize,
+        RelocationTarget::LocalFunc(index) => function_address(index),
         RelocationTarget::LibCall(libcall) => libcall.function_pointer(),
         RelocationTarget::CustomSection(custom_section) => {
             *allocated_sections[custom_section] as usize
         }
         RelocationTarget::JumpTable(func_index, jt) => {
             let offset = jt_offsets(func_index, jt);
-            *allocated_functions[func_index].body as usize + offset as usize
+            function_address(func_index) + offset as usize
         }
     };
 
@@ -168,41 +170,38 @@ fn apply_relocation(
 
 /// Links a module, patching the allocated functions with the
 /// required relocations and jump tables.
+///
+/// Relocations targeting distinct bodies are independent once the function
+/// and section addresses are fixed, so the apply loop runs in parallel over
+/// the bodies; only the trampoline map is shared, and it is touched solely by
+/// AArch64 far branches.
 pub fn link_module(
     allocated_functions: &PrimaryMap<LocalFunctionIndex, VMLocalFunction>,
-    jt_offsets: impl Fn(LocalFunctionIndex, JumpTable) -> wasmer_compiler::CodeOffset,
+    jt_offsets: impl Fn(LocalFunctionIndex, JumpTable) -> wasmer_compiler::CodeOffset + Sync,
     function_relocations: impl Iterator<Item = (LocalFunctionIndex, impl Iterator<Item = Relocation>)>,
     allocated_sections: &PrimaryMap<SectionIndex, SectionBodyPtr>,
     section_relocations: impl Iterator<Item = (SectionIndex, impl Iterator<Item = Relocation>)>,
     trampolines: &Option<TrampolinesSection>,
 ) {
-    let mut trampolines_map = fill_trampoline_map(allocated_sections, trampolines);
-    for (i, section_relocs) in section_relocations {
-        let body = *allocated_sections[i] as usize;
-        for r in section_relocs {
+    let function_address = |index: LocalFunctionIndex| *allocated_functions[index].body as usize;
+    let trampolines_map = Mutex::new(fill_trampoline_map(allocated_sections, trampolines));
+    // The relocation iterators borrow from the executable and are not `Send`,
+    // so gather the per-body worklist up front before fanning out.
+    let worklist: Vec<(usize, Vec<Relocation>)> = section_relocations
+        .map(|(i, relocs)| (*allocated_sections[i] as usize, relocs.collect()))
+        .chain(function_relocations.map(|(i, relocs)| (function_address(i), relocs.collect())))
+        .collect();
+    worklist.par_iter().for_each(|(body, relocs)| {
+        for r in relocs {
             apply_relocation(
-                body,
-                &r,
-                allocated_functions,
+                *body,
+                r,
+                &function_address,
                 &jt_offsets,
                 allocated_sections,
                 trampolines,
-                &mut trampolines_map,
+                &trampolines_map,
             );
         }
-    }
-    for (i, function_relocs) in function_relocations {
-        let body = *allocated_functions[i].body as usize;
-        for r in function_relocs {
-            apply_relocation(
-                body,
-                &r,
-                allocated_functions,
-                &jt_offsets,
-                allocated_sections,
-                trampolines,
-                &mut trampolines_map,
-            );
-        }
-    }
+    });
 }
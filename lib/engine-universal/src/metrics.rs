@@ -0,0 +1,221 @@
+//! Optional instrumentation of the engine.
+//!
+//! When the `metrics` cargo feature is enabled, a [`MetricsSink`] installed
+//! through [`Universal::metrics`](crate::Universal::metrics) receives
+//! per-phase timings and per-module counters from every compilation and
+//! load. Without the feature the recording calls compile to nothing.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::Duration;
+#[cfg(feature = "metrics")]
+use std::time::Instant;
+
+/// The instrumented engine phases.
+///
+/// Translation and code generation are not reported separately: full
+/// compilation streams function bodies into the compiler as they are parsed,
+/// so the two overlap within [`Phase::Compile`].
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Phase {
+    /// Compiling a wasm binary into an executable.
+    Compile = 0,
+    /// Copying code into executable memory when loading an executable.
+    Allocate = 1,
+    /// Applying relocations to the loaded code.
+    Link = 2,
+    /// Making the loaded code executable.
+    Publish = 3,
+    /// Loading an executable into an artifact, end to end.
+    Load = 4,
+}
+
+/// The number of [`Phase`] variants.
+const PHASES: usize = 5;
+
+/// A consumer of engine measurements.
+///
+/// Implementations must be cheap and non-blocking: the engine reports from
+/// whichever thread compiles or loads a module, with no synchronization of
+/// its own.
+pub trait MetricsSink: Send + Sync {
+    /// One pass through an instrumented phase took `duration`.
+    fn phase(&self, _phase: Phase, _duration: Duration) {}
+
+    /// A module finished loading with `code_bytes` bytes of executable code.
+    fn module_loaded(&self, _code_bytes: usize) {}
+
+    /// The sizes of the engine-wide registries, reported after each load.
+    fn registry_sizes(&self, _signatures: usize, _func_refs: usize) {}
+}
+
+/// A ready-made [`MetricsSink`] aggregating everything into atomic counters.
+#[derive(Debug, Default)]
+pub struct EngineMetrics {
+    phase_ns: [AtomicU64; PHASES],
+    modules_loaded: AtomicU64,
+    code_bytes: AtomicU64,
+    signatures: AtomicU64,
+    func_refs: AtomicU64,
+}
+
+impl EngineMetrics {
+    /// Total time spent in `phase` over all compilations and loads so far.
+    pub fn phase_total(&self, phase: Phase) -> Duration {
+        Duration::from_nanos(self.phase_ns[phase as usize].load(Ordering::Relaxed))
+    }
+
+    /// The number of modules loaded so far.
+    pub fn modules_loaded(&self) -> u64 {
+        self.modules_loaded.load(Ordering::Relaxed)
+    }
+
+    /// Total bytes of executable code published by module loads so far.
+    pub fn code_bytes(&self) -> u64 {
+        self.code_bytes.load(Ordering::Relaxed)
+    }
+
+    /// The engine-wide registry sizes as of the most recent load, as
+    /// `(signatures, func_refs)`.
+    pub fn registry_sizes(&self) -> (u64, u64) {
+        (
+            self.signatures.load(Ordering::Relaxed),
+            self.func_refs.load(Ordering::Relaxed),
+        )
+    }
+}
+
+impl MetricsSink for EngineMetrics {
+    fn phase(&self, phase: Phase, duration: Duration) {
+        self.phase_ns[phase as usize].fetch_add(duration.as_nanos() as u64, Ordering::Relaxed);
+    }
+
+    fn module_loaded(&self, code_bytes: usize) {
+        self.modules_loaded.fetch_add(1, Ordering::Relaxed);
+        self.code_bytes
+            .fetch_add(code_bytes as u64, Ordering::Relaxed);
+    }
+
+    fn registry_sizes(&self, signatures: usize, func_refs: usize) {
+        self.signatures.store(signatures as u64, Ordering::Relaxed);
+        self.func_refs.store(func_refs as u64, Ordering::Relaxed);
+    }
+}
+
+/// The engine's handle for reporting measurements to the configured sink.
+///
+/// With the `metrics` feature disabled this is a zero-sized no-op and every
+/// recording call below compiles away.
+#[derive(Clone, Default)]
+pub(crate) struct Recorder {
+    #[cfg(feature = "metrics")]
+    sink: Option<Arc<dyn MetricsSink>>,
+}
+
+#[cfg(feature = "metrics")]
+impl Recorder {
+    pub(crate) fn new(sink: Option<Arc<dyn MetricsSink>>) -> Self {
+        Self { sink }
+    }
+
+    /// Whether a sink is installed. Lets callers skip gathering report
+    /// arguments that are not free to compute.
+    #[inline]
+    pub(crate) fn enabled(&self) -> bool {
+        self.sink.is_some()
+    }
+
+    /// Start timing one pass through `phase`.
+    #[inline]
+    pub(crate) fn phase(&self, phase: Phase) -> PhaseSpan<'_> {
+        PhaseSpan {
+            recorder: self,
+            phase,
+            start: self.sink.as_ref().map(|_| Instant::now()),
+        }
+    }
+
+    #[inline]
+    pub(crate) fn module_loaded(&self, code_bytes: usize) {
+        if let Some(sink) = &self.sink {
+            sink.module_loaded(code_bytes);
+        }
+    }
+
+    #[inline]
+    pub(crate) fn registry_sizes(&self, signatures: usize, func_refs: usize) {
+        if let Some(sink) = &self.sink {
+            sink.registry_sizes(signatures, func_refs);
+        }
+    }
+}
+
+#[cfg(not(feature = "metrics"))]
+impl Recorder {
+    pub(crate) fn new(_sink: Option<Arc<dyn MetricsSink>>) -> Self {
+        Self {}
+    }
+
+    #[inline]
+    pub(crate) fn enabled(&self) -> bool {
+        false
+    }
+
+    #[inline]
+    pub(crate) fn phase(&self, _phase: Phase) -> PhaseSpan<'_> {
+        PhaseSpan {
+            _recorder: std::marker::PhantomData,
+        }
+    }
+
+    #[inline]
+    pub(crate) fn module_loaded(&self, _code_bytes: usize) {}
+
+    #[inline]
+    pub(crate) fn registry_sizes(&self, _signatures: usize, _func_refs: usize) {}
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn engine_metrics_aggregates() {
+        let metrics = EngineMetrics::default();
+        MetricsSink::phase(&metrics, Phase::Compile, Duration::from_nanos(5));
+        MetricsSink::phase(&metrics, Phase::Compile, Duration::from_nanos(7));
+        metrics.module_loaded(4096);
+        metrics.module_loaded(1024);
+        MetricsSink::registry_sizes(&metrics, 3, 9);
+        assert_eq!(
+            metrics.phase_total(Phase::Compile),
+            Duration::from_nanos(12)
+        );
+        assert_eq!(metrics.phase_total(Phase::Link), Duration::from_nanos(0));
+        assert_eq!(metrics.modules_loaded(), 2);
+        assert_eq!(metrics.code_bytes(), 5120);
+        assert_eq!(metrics.registry_sizes(), (3, 9));
+    }
+}
+
+/// An in-progress measurement of one phase, reported when finished.
+pub(crate) struct PhaseSpan<'a> {
+    #[cfg(feature = "metrics")]
+    recorder: &'a Recorder,
+    #[cfg(feature = "metrics")]
+    phase: Phase,
+    #[cfg(feature = "metrics")]
+    start: Option<Instant>,
+    #[cfg(not(feature = "metrics"))]
+    _recorder: std::marker::PhantomData<&'a Recorder>,
+}
+
+impl PhaseSpan<'_> {
+    #[inline]
+    pub(crate) fn finish(self) {
+        #[cfg(feature = "metrics")]
+        if let (Some(start), Some(sink)) = (self.start, &self.recorder.sink) {
+            sink.phase(self.phase, start.elapsed());
+        }
+    }
+}
@@ -0,0 +1,338 @@
+//! Execute-in-place (XIP) support for serialized modules.
+//!
+//! The standard load path copies every function body and custom section out
+//! of the serialized executable into a fresh [`CodeMemory`](crate::CodeMemory)
+//! mapping before linking. The XIP format instead lays the code out in the
+//! file exactly as `CodeMemory` would in memory, starting at a page-aligned
+//! offset, so that [`UniversalEngine::load_universal_executable_file`]
+//! (crate::UniversalEngine::load_universal_executable_file) can map the file
+//! `MAP_PRIVATE` and run the code in place: relocations are applied through
+//! the mapping (faulting in private copies of only the touched pages) and the
+//! code pages are then made executable with `mprotect`, with no copying.
+//!
+//! An XIP file is laid out as
+//!
+//! ```text
+//! HEADER (one page): magic, page size, image length, executable image prefix
+//! IMAGE (page-aligned): trampolines, functions and sections, CodeMemory layout
+//! TAIL: the standard `UniversalExecutable::serialize` bytes
+//! ```
+//!
+//! The image layout is not stored; it is recomputed from the body and section
+//! lengths in the tail with the same deterministic algorithm used to emit it.
+
+use crate::UniversalExecutableRef;
+use std::convert::TryFrom;
+use std::io;
+use wasmer_compiler::{
+    CompileError, CustomSectionProtection, CustomSectionRef, FunctionBodyRef, SectionIndex,
+};
+use wasmer_types::entity::{EntityRef, PrimaryMap};
+use wasmer_types::{FunctionIndex, LocalFunctionIndex, SignatureIndex};
+use wasmer_vm::{FunctionBodyPtr, SectionBodyPtr, VMFunctionBody, VMLocalFunction, VMTrampoline};
+
+/// The magic bytes identifying an execute-in-place serialized module.
+pub(crate) const XIP_MAGIC: [u8; 16] = *b"\0wasmer-xip\xFF\xFF\xFF\xFF\xFF";
+
+/// The size of the XIP header: magic, page size, image length and the length
+/// of the executable prefix of the image, as little-endian `u64`s.
+const HEADER_LEN: usize = XIP_MAGIC.len() + 3 * 8;
+
+/// Must match `ARCH_FUNCTION_ALIGNMENT` in code_memory.rs.
+const ARCH_FUNCTION_ALIGNMENT: usize = 16;
+/// Must match `DATA_SECTION_ALIGNMENT` in code_memory.rs.
+const DATA_SECTION_ALIGNMENT: usize = 64;
+
+fn round_up(size: usize, multiple: usize) -> usize {
+    debug_assert!(multiple.is_power_of_two());
+    (size + (multiple - 1)) & !(multiple - 1)
+}
+
+/// The offset and unpadded length of one body within an image.
+#[derive(Clone, Copy)]
+pub(crate) struct ImageChunk {
+    pub(crate) offset: usize,
+    pub(crate) len: usize,
+}
+
+/// Where every function body and custom section lives within an image.
+///
+/// This mirrors the layout `CodeMemory::allocate` produces: call trampolines,
+/// then function bodies, then dynamic trampolines, then executable custom
+/// sections — every one aligned to `ARCH_FUNCTION_ALIGNMENT` — and, on the
+/// next page boundary, the read-write custom sections aligned to
+/// `DATA_SECTION_ALIGNMENT`.
+pub(crate) struct XipLayout {
+    /// Keyed by `SignatureIndex`.
+    pub(crate) trampolines: Vec<ImageChunk>,
+    /// Keyed by `LocalFunctionIndex`.
+    pub(crate) functions: Vec<ImageChunk>,
+    /// Keyed by `FunctionIndex`.
+    pub(crate) dynamic_trampolines: Vec<ImageChunk>,
+    /// Keyed by `SectionIndex`, executable and read-write alike.
+    pub(crate) sections: Vec<ImageChunk>,
+    /// The length of the image prefix that must be made executable.
+    pub(crate) executable_end: usize,
+    /// The page-aligned total length of the image.
+    pub(crate) image_len: usize,
+}
+
+impl XipLayout {
+    /// Compute the layout from the body lengths of each entity, in the order
+    /// and with the keys they have in the serialized executable.
+    pub(crate) fn compute(
+        trampolines: impl Iterator<Item = usize>,
+        functions: impl Iterator<Item = usize>,
+        dynamic_trampolines: impl Iterator<Item = usize>,
+        sections: impl Iterator<Item = (CustomSectionProtection, usize)>,
+        page_size: usize,
+    ) -> Self {
+        let mut cursor = 0;
+        let mut place_code = |len: usize| {
+            let chunk = ImageChunk {
+                offset: cursor,
+                len,
+            };
+            cursor = round_up(cursor + len, ARCH_FUNCTION_ALIGNMENT);
+            chunk
+        };
+        let trampolines = trampolines.map(&mut place_code).collect();
+        let functions = functions.map(&mut place_code).collect();
+        let dynamic_trampolines = dynamic_trampolines.map(&mut place_code).collect();
+        let sections = sections.collect::<Vec<_>>();
+        let mut placed_sections = vec![ImageChunk { offset: 0, len: 0 }; sections.len()];
+        for (index, (protection, len)) in sections.iter().enumerate() {
+            if let CustomSectionProtection::ReadExecute = protection {
+                placed_sections[index] = place_code(*len);
+            }
+        }
+        let executable_end = cursor;
+        let mut cursor = round_up(cursor, page_size);
+        for (index, (protection, len)) in sections.iter().enumerate() {
+            if let CustomSectionProtection::Read = protection {
+                placed_sections[index] = ImageChunk {
+                    offset: cursor,
+                    len: *len,
+                };
+                cursor = round_up(cursor + len, DATA_SECTION_ALIGNMENT);
+            }
+        }
+        Self {
+            trampolines,
+            functions,
+            dynamic_trampolines,
+            sections: placed_sections,
+            executable_end,
+            image_len: round_up(cursor, page_size),
+        }
+    }
+}
+
+/// Compute the image layout of a serialized executable.
+pub(crate) fn layout_of(executable: &UniversalExecutableRef<'_>, page_size: usize) -> XipLayout {
+    XipLayout::compute(
+        executable
+            .function_call_trampolines
+            .iter()
+            .map(|(_, b)| FunctionBodyRef::from(b).body.len()),
+        executable
+            .function_bodies
+            .iter()
+            .map(|(_, b)| FunctionBodyRef::from(b).body.len()),
+        executable
+            .dynamic_function_trampolines
+            .iter()
+            .map(|(_, b)| FunctionBodyRef::from(b).body.len()),
+        executable.custom_sections.iter().map(|(_, s)| {
+            let section = CustomSectionRef::from(s);
+            (section.protection, section.bytes.len())
+        }),
+        page_size,
+    )
+}
+
+/// Whether any body in the serialized executable carries unwind information.
+///
+/// Unwind information must be registered against the memory holding the code,
+/// which the in-place load path does not do (and the singlepass compiler never
+/// emits any).
+pub(crate) fn has_unwind_info(executable: &UniversalExecutableRef<'_>) -> bool {
+    executable
+        .function_bodies
+        .iter()
+        .map(|(_, b)| FunctionBodyRef::from(b))
+        .chain(
+            executable
+                .function_call_trampolines
+                .iter()
+                .map(|(_, b)| FunctionBodyRef::from(b)),
+        )
+        .chain(
+            executable
+                .dynamic_function_trampolines
+                .iter()
+                .map(|(_, b)| FunctionBodyRef::from(b)),
+        )
+        .any(|body| body.unwind_info.is_some())
+}
+
+/// Serialize the XIP header into its page-sized block.
+pub(crate) fn write_header(out: &mut [u8], page_size: usize, layout: &XipLayout) {
+    out[..XIP_MAGIC.len()].copy_from_slice(&XIP_MAGIC);
+    out[16..24].copy_from_slice(&(page_size as u64).to_le_bytes());
+    out[24..32].copy_from_slice(&(layout.image_len as u64).to_le_bytes());
+    out[32..40].copy_from_slice(&(layout.executable_end as u64).to_le_bytes());
+}
+
+/// Parse the XIP header, returning `(page_size, image_len, executable_end)`,
+/// or `None` when `data` is not in the XIP format.
+pub(crate) fn parse_header(data: &[u8]) -> Option<(usize, usize, usize)> {
+    if data.len() < HEADER_LEN || !data.starts_with(&XIP_MAGIC) {
+        return None;
+    }
+    let word = |at: usize| {
+        let mut bytes = [0u8; 8];
+        bytes.copy_from_slice(&data[at..at + 8]);
+        usize::try_from(u64::from_le_bytes(bytes)).ok()
+    };
+    Some((word(16)?, word(24)?, word(32)?))
+}
+
+/// Produce the pointer tables for an image mapped at `base`, in the shape
+/// the copying load path produces them.
+///
+/// The trampolines come from the image itself rather than the engine-wide
+/// trampoline cache: they are part of the mapping already, so deduplicating
+/// them would not save any memory.
+pub(crate) fn resolve_image(
+    base: *const u8,
+    layout: &XipLayout,
+    function_signature: impl Fn(
+        LocalFunctionIndex,
+    ) -> (SignatureIndex, wasmer_vm::VMSharedSignatureIndex),
+) -> Result<
+    (
+        PrimaryMap<LocalFunctionIndex, VMLocalFunction>,
+        PrimaryMap<SignatureIndex, VMTrampoline>,
+        PrimaryMap<FunctionIndex, FunctionBodyPtr>,
+        PrimaryMap<SectionIndex, SectionBodyPtr>,
+    ),
+    CompileError,
+> {
+    let chunk_ptr = |chunk: &ImageChunk| unsafe { base.add(chunk.offset) };
+    let trampolines = layout
+        .trampolines
+        .iter()
+        .map(|chunk| unsafe {
+            std::mem::transmute::<*const u8, VMTrampoline>(chunk_ptr(chunk))
+        })
+        .collect::<PrimaryMap<SignatureIndex, _>>();
+    let functions = layout
+        .functions
+        .iter()
+        .enumerate()
+        .map(|(index, chunk)| -> Result<_, CompileError> {
+            let (sig_idx, sig) = function_signature(LocalFunctionIndex::new(index));
+            Ok(VMLocalFunction {
+                body: FunctionBodyPtr(chunk_ptr(chunk) as *const VMFunctionBody),
+                length: u32::try_from(chunk.len).map_err(|_| {
+                    CompileError::Codegen("function body length exceeds 4GiB".into())
+                })?,
+                signature: sig,
+                trampoline: trampolines[sig_idx],
+            })
+        })
+        .collect::<Result<PrimaryMap<LocalFunctionIndex, _>, _>>()?;
+    let dynamic_trampolines = layout
+        .dynamic_trampolines
+        .iter()
+        .map(|chunk| FunctionBodyPtr(chunk_ptr(chunk) as *const VMFunctionBody))
+        .collect::<PrimaryMap<FunctionIndex, _>>();
+    let sections = layout
+        .sections
+        .iter()
+        .map(|chunk| SectionBodyPtr(chunk_ptr(chunk)))
+        .collect::<PrimaryMap<SectionIndex, _>>();
+    Ok((functions, trampolines, dynamic_trampolines, sections))
+}
+
+/// A private, writable mapping of a serialized module file.
+///
+/// Relocations applied through the mapping fault in private copies of only
+/// the pages they touch; [`publish`](Self::publish) then makes the code pages
+/// executable. The mapping must stay alive for as long as any artifact whose
+/// code lives in it, so the engine retains it until it is dropped.
+pub(crate) struct XipImage {
+    ptr: usize,
+    len: usize,
+}
+
+// SAFETY: the mapping is owned and its coordination happens at the OS layer,
+// like `wasmer_vm::Mmap`.
+unsafe impl Send for XipImage {}
+unsafe impl Sync for XipImage {}
+
+impl XipImage {
+    /// Map the whole of `file` `MAP_PRIVATE` and read-write.
+    pub(crate) fn map_file(file: &std::fs::File) -> Result<Self, String> {
+        use std::os::unix::io::AsRawFd;
+        let len = file
+            .metadata()
+            .map_err(|e| e.to_string())?
+            .len();
+        let len = usize::try_from(len).map_err(|e| e.to_string())?;
+        if len == 0 {
+            return Err("the executable file is empty".to_string());
+        }
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr as isize == -1_isize {
+            return Err(io::Error::last_os_error().to_string());
+        }
+        Ok(Self {
+            ptr: ptr as usize,
+            len,
+        })
+    }
+
+    /// The mapped file contents.
+    ///
+    /// # Safety
+    ///
+    /// The returned slice has an unconstrained lifetime; it must not outlive
+    /// this mapping.
+    pub(crate) unsafe fn as_slice<'a>(&self) -> &'a [u8] {
+        std::slice::from_raw_parts(self.ptr as *const u8, self.len)
+    }
+
+    /// Make `executable_len` bytes starting at `offset` executable.
+    pub(crate) fn publish(&self, offset: usize, executable_len: usize) -> Result<(), String> {
+        if executable_len == 0 {
+            return Ok(());
+        }
+        assert!(offset + executable_len <= self.len);
+        unsafe {
+            region::protect(
+                (self.ptr + offset) as *const u8,
+                executable_len,
+                region::Protection::READ_EXECUTE,
+            )
+        }
+        .map_err(|e| e.to_string())
+    }
+}
+
+impl Drop for XipImage {
+    fn drop(&mut self) {
+        let r = unsafe { libc::munmap(self.ptr as *mut libc::c_void, self.len) };
+        debug_assert_eq!(r, 0, "munmap failed: {}", io::Error::last_os_error());
+    }
+}
@@ -30,6 +30,20 @@ pub trait Executable {
     /// Serializes the artifact into bytes
     fn serialize(&self) -> Result<Vec<u8>, Box<dyn std::error::Error + Send + Sync>>;
 
+    /// Serializes the artifact into `writer`.
+    ///
+    /// The output is identical to [`serialize`](Self::serialize)'s.
+    /// Implementations that can stream do so, keeping memory use bounded
+    /// instead of building the whole byte buffer first; the default falls
+    /// back to `serialize`.
+    fn serialize_to(
+        &self,
+        writer: &mut dyn std::io::Write,
+    ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+        writer.write_all(&self.serialize()?)?;
+        Ok(())
+    }
+
     /// Obtain a best effort description for the function at the given function index.
     ///
     /// Implementations are not required to maintain symbol names, so this may always return None.
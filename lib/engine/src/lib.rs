@@ -29,7 +29,7 @@ mod trap;
 pub use crate::engine::{Engine, EngineId};
 pub use crate::error::{DeserializeError, ImportError, InstantiationError, LinkError};
 pub use crate::executable::Executable;
-pub use crate::resolver::resolve_imports;
+pub use crate::resolver::{plan_imports, resolve_imports, ImportResolutionPlan};
 pub use crate::trap::*;
 
 /// Version number of this crate.
@@ -4,12 +4,15 @@
 use crate::{Engine, ImportError, LinkError};
 use more_asserts::assert_ge;
 use wasmer_types::entity::{BoxedSlice, EntityRef, PrimaryMap};
-use wasmer_types::{ExternType, FunctionIndex, ImportCounts, MemoryType, TableType};
+use wasmer_types::{
+    ExternType, FunctionIndex, GlobalIndex, ImportCounts, MemoryIndex, MemoryType, TableIndex,
+    TableType,
+};
 
 use wasmer_vm::{
-    Export, ExportFunctionMetadata, FunctionBodyPtr, ImportFunctionEnv, Imports, MemoryStyle,
-    Resolver, VMFunctionBody, VMFunctionEnvironment, VMFunctionImport, VMFunctionKind,
-    VMGlobalImport, VMImport, VMImportType, VMMemoryImport, VMTableImport,
+    Export, ExportFunctionMetadata, FunctionBodyPtr, ImportFunctionEnv, ImportInitializerFuncPtr,
+    Imports, MemoryStyle, Resolver, VMFunctionBody, VMFunctionEnvironment, VMFunctionImport,
+    VMFunctionKind, VMGlobalImport, VMImport, VMImportType, VMMemoryImport, VMTableImport,
 };
 
 fn is_compatible_table(ex: &TableType, im: &TableType) -> bool {
@@ -26,6 +29,86 @@ fn is_compatible_memory(ex: &MemoryType, im: &MemoryType) -> bool {
         && ex.shared == im.shared
 }
 
+/// A precompiled plan for satisfying a module's imports, produced by
+/// [`plan_imports`].
+///
+/// The plan captures the ordered, prevalidated import entries for one
+/// (module, resolver) pair, so that repeated instantiations of that pair can
+/// [`build`](Self::build) their `Imports` without querying the resolver by
+/// name or re-checking types. Like the `Imports` it produces, the plan refers
+/// to the resolved exports by pointer: the imports it was resolved against
+/// must outlive it and every instance built from it.
+pub struct ImportResolutionPlan {
+    functions: Vec<PlannedFunctionImport>,
+    tables: BoxedSlice<TableIndex, VMTableImport>,
+    memories: BoxedSlice<MemoryIndex, VMMemoryImport>,
+    globals: BoxedSlice<GlobalIndex, VMGlobalImport>,
+}
+
+/// One prevalidated function import of an [`ImportResolutionPlan`].
+struct PlannedFunctionImport {
+    /// The import entry, pointing at the exported function's own environment.
+    /// When the function carries a host environment, [`ImportResolutionPlan::build`]
+    /// repoints this at the clone made for the new instance.
+    import: VMFunctionImport,
+    env: PlannedImportEnv,
+}
+
+/// How [`ImportResolutionPlan::build`] derives a function's environment for a
+/// new instance.
+enum PlannedImportEnv {
+    /// The `vmctx` is not a host env; the import entry is used as-is.
+    NoEnv,
+    /// A user-defined host env, cloned afresh for every instance.
+    Env {
+        env: *mut std::ffi::c_void,
+        clone: fn(*mut std::ffi::c_void) -> *mut std::ffi::c_void,
+        initializer: Option<ImportInitializerFuncPtr>,
+        destructor: unsafe fn(*mut std::ffi::c_void),
+    },
+}
+
+impl ImportResolutionPlan {
+    /// Produces the resolved imports for one instantiation.
+    ///
+    /// Host function environments are cloned afresh for the new instance;
+    /// everything else is copied out of the plan as-is.
+    pub fn build(&self) -> Imports {
+        let mut function_imports = PrimaryMap::with_capacity(self.functions.len());
+        let mut host_function_env_initializers = PrimaryMap::with_capacity(self.functions.len());
+        for planned in &self.functions {
+            let mut import = planned.import;
+            let env = match &planned.env {
+                PlannedImportEnv::NoEnv => ImportFunctionEnv::NoEnv,
+                PlannedImportEnv::Env {
+                    env,
+                    clone,
+                    initializer,
+                    destructor,
+                } => {
+                    let env = (*clone)(*env);
+                    import.environment = VMFunctionEnvironment { host_env: env };
+                    ImportFunctionEnv::Env {
+                        env,
+                        clone: *clone,
+                        initializer: *initializer,
+                        destructor: *destructor,
+                    }
+                }
+            };
+            function_imports.push(import);
+            host_function_env_initializers.push(env);
+        }
+        Imports {
+            functions: function_imports.into_boxed_slice(),
+            host_function_env_initializers: Some(host_function_env_initializers.into_boxed_slice()),
+            tables: self.tables.clone(),
+            memories: self.memories.clone(),
+            globals: self.globals.clone(),
+        }
+    }
+}
+
 /// This function allows to match all imports of a `ModuleInfo` with concrete definitions provided by
 /// a `Resolver`.
 ///
@@ -37,9 +120,31 @@ pub fn resolve_imports(
     imports: &[VMImport],
     finished_dynamic_function_trampolines: &BoxedSlice<FunctionIndex, FunctionBodyPtr>,
 ) -> Result<Imports, LinkError> {
-    let mut function_imports = PrimaryMap::with_capacity(import_counts.functions as _);
-    let mut host_function_env_initializers =
-        PrimaryMap::with_capacity(import_counts.functions as _);
+    let plan = plan_imports(
+        engine,
+        resolver,
+        import_counts,
+        imports,
+        finished_dynamic_function_trampolines,
+    )?;
+    Ok(plan.build())
+}
+
+/// Matches all imports of a `ModuleInfo` with concrete definitions provided
+/// by a `Resolver`, producing a reusable [`ImportResolutionPlan`].
+///
+/// Resolution queries the resolver by module/field name and type-checks every
+/// entry, which is worth paying once when the same (module, resolver) pair is
+/// instantiated over and over; the returned plan replays the prevalidated
+/// result on each instantiation.
+pub fn plan_imports(
+    engine: &dyn Engine,
+    resolver: &dyn Resolver,
+    import_counts: &ImportCounts,
+    imports: &[VMImport],
+    finished_dynamic_function_trampolines: &BoxedSlice<FunctionIndex, FunctionBodyPtr>,
+) -> Result<ImportResolutionPlan, LinkError> {
+    let mut function_imports = Vec::with_capacity(import_counts.functions as _);
     let mut table_imports = PrimaryMap::with_capacity(import_counts.tables as _);
     let mut memory_imports = PrimaryMap::with_capacity(import_counts.memories as _);
     let mut global_imports = PrimaryMap::with_capacity(import_counts.globals as _);
@@ -110,9 +215,24 @@ pub fn resolve_imports(
                     VMFunctionKind::Static => ex.vm_function.address,
                 };
 
-                // Clone the host env for this `Instance`.
+                let trampoline = if let Some(t) = ex.vm_function.call_trampoline {
+                    Some(t)
+                } else if let VMFunctionKind::Static = ex.vm_function.kind {
+                    // Look up a trampoline by finding one by the signature and fill it in.
+                    Some(*static_trampoline)
+                } else {
+                    // FIXME: remove this possibility entirely.
+                    None
+                };
+
+                // The host env (when there is one) is not cloned here: the
+                // plan records the export's own env together with its clone
+                // function, and `ImportResolutionPlan::build` clones it
+                // afresh for every instance.
                 let env = if let Some(ExportFunctionMetadata {
                     host_env_clone_fn: clone,
+                    import_init_function_ptr: initializer,
+                    host_env_drop_fn: destructor,
                     ..
                 }) = ex.metadata.as_deref()
                 {
@@ -121,51 +241,30 @@ pub fn resolve_imports(
                     // horribly breaking things.
                     unsafe {
                         assert!(!ex.vm_function.vmctx.host_env.is_null());
-                        (clone)(ex.vm_function.vmctx.host_env)
+                    }
+                    PlannedImportEnv::Env {
+                        env: unsafe { ex.vm_function.vmctx.host_env },
+                        clone: *clone,
+                        initializer: *initializer,
+                        destructor: *destructor,
                     }
                 } else {
-                    // No `clone` function means we're dealing with some
-                    // other kind of `vmctx`, not a host env of any
-                    // kind.
-                    unsafe { ex.vm_function.vmctx.host_env }
-                };
-
-                let trampoline = if let Some(t) = ex.vm_function.call_trampoline {
-                    Some(t)
-                } else if let VMFunctionKind::Static = ex.vm_function.kind {
-                    // Look up a trampoline by finding one by the signature and fill it in.
-                    Some(*static_trampoline)
-                } else {
-                    // FIXME: remove this possibility entirely.
-                    None
+                    // No metadata means we're dealing with some other kind of
+                    // `vmctx`, not a host env of any kind.
+                    PlannedImportEnv::NoEnv
                 };
 
-                function_imports.push(VMFunctionImport {
-                    body: FunctionBodyPtr(address),
-                    signature: *sig,
-                    environment: VMFunctionEnvironment { host_env: env },
-                    trampoline,
+                function_imports.push(PlannedFunctionImport {
+                    import: VMFunctionImport {
+                        body: FunctionBodyPtr(address),
+                        signature: *sig,
+                        environment: VMFunctionEnvironment {
+                            host_env: unsafe { ex.vm_function.vmctx.host_env },
+                        },
+                        trampoline,
+                    },
+                    env,
                 });
-
-                let initializer = ex
-                    .metadata
-                    .as_ref()
-                    .and_then(|m| m.import_init_function_ptr);
-                let clone = ex.metadata.as_ref().map(|m| m.host_env_clone_fn);
-                let destructor = ex.metadata.as_ref().map(|m| m.host_env_drop_fn);
-                let import_function_env =
-                    if let (Some(clone), Some(destructor)) = (clone, destructor) {
-                        ImportFunctionEnv::Env {
-                            env,
-                            clone,
-                            initializer,
-                            destructor,
-                        }
-                    } else {
-                        ImportFunctionEnv::NoEnv
-                    };
-
-                host_function_env_initializers.push(import_function_env);
             }
             (Export::Table(ex), VMImportType::Table(im)) if is_compatible_table(ex.ty(), im) => {
                 let import_table_ty = ex.from.ty();
@@ -222,11 +321,10 @@ pub fn resolve_imports(
             }
         }
     }
-    Ok(Imports::new(
-        function_imports,
-        host_function_env_initializers,
-        table_imports,
-        memory_imports,
-        global_imports,
-    ))
+    Ok(ImportResolutionPlan {
+        functions: function_imports,
+        tables: table_imports.into_boxed_slice(),
+        memories: memory_imports.into_boxed_slice(),
+        globals: global_imports.into_boxed_slice(),
+    })
 }
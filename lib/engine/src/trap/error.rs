@@ -54,10 +54,10 @@ impl RuntimeError {
     /// assert_eq!("unexpected error", trap.message());
     /// ```
     pub fn new<I: Into<String>>(message: I) -> Self {
-        let info = FRAME_INFO.read().unwrap();
+        let mut info = FRAME_INFO.write().unwrap();
         let msg = message.into();
         Self::new_with_trace(
-            &info,
+            &mut info,
             None,
             RuntimeErrorSource::Generic(msg),
             Backtrace::new_unresolved(),
@@ -66,7 +66,9 @@ impl RuntimeError {
 
     /// Create a new RuntimeError from a Trap.
     pub fn from_trap(trap: Trap) -> Self {
-        let info = FRAME_INFO.read().unwrap();
+        // Errors are off the fast path, so the lookups below may take the
+        // write lock and resolve lazily registered frame information.
+        let mut info = FRAME_INFO.write().unwrap();
         match trap {
             // A user error
             Trap::User(error) => {
@@ -74,7 +76,7 @@ impl RuntimeError {
                     // The error is already a RuntimeError, we return it directly
                     Ok(runtime_error) => *runtime_error,
                     Err(e) => Self::new_with_trace(
-                        &info,
+                        &mut info,
                         None,
                         RuntimeErrorSource::User(e),
                         Backtrace::new_unresolved(),
@@ -83,7 +85,7 @@ impl RuntimeError {
             }
             // A trap caused by the VM being Out of Memory
             Trap::OOM { backtrace } => {
-                Self::new_with_trace(&info, None, RuntimeErrorSource::OOM, backtrace)
+                Self::new_with_trace(&mut info, None, RuntimeErrorSource::OOM, backtrace)
             }
             // A trap caused by an error on the generated machine code for a Wasm function
             Trap::Wasm {
@@ -96,13 +98,15 @@ impl RuntimeError {
                     .map_or(signal_trap.unwrap_or(TrapCode::StackOverflow), |info| {
                         info.trap_code
                     });
-                Self::new_with_trace(&info, Some(pc), RuntimeErrorSource::Trap(code), backtrace)
+                Self::new_with_trace(&mut info, Some(pc), RuntimeErrorSource::Trap(code), backtrace)
             }
             // A trap triggered manually from the Wasmer runtime
             Trap::Lib {
                 trap_code,
                 backtrace,
-            } => Self::new_with_trace(&info, None, RuntimeErrorSource::Trap(trap_code), backtrace),
+            } => {
+                Self::new_with_trace(&mut info, None, RuntimeErrorSource::Trap(trap_code), backtrace)
+            }
         }
     }
 
@@ -112,7 +116,7 @@ impl RuntimeError {
     }
 
     fn new_with_trace(
-        info: &GlobalFrameInfo,
+        info: &mut GlobalFrameInfo,
         trap_pc: Option<usize>,
         source: RuntimeErrorSource,
         native_trace: Backtrace,
@@ -5,17 +5,18 @@
 //!
 //! # Example
 //! ```ignore
-//! use wasmer_vm::{FRAME_INFO};
+//! use wasmer_engine::register_frame_info;
 //! use wasmer_types::ModuleInfo;
 //!
-//! let module: ModuleInfo = ...;
-//! FRAME_INFO.register(module, compiled_functions);
+//! let module: Arc<ModuleInfo> = ...;
+//! let registration = register_frame_info(module, extents, frame_infos);
 //! ```
 use std::collections::BTreeMap;
 use std::sync::{Arc, RwLock};
 use wasmer_compiler::{CompiledFunctionFrameInfo, SourceLoc, TrapInformation};
 use wasmer_types::entity::{EntityRef, PrimaryMap};
 use wasmer_types::{LocalFunctionIndex, ModuleInfo};
+use wasmer_vm::FunctionExtent;
 
 lazy_static::lazy_static! {
     /// This is a global cache of backtrace frame information for all active
@@ -48,22 +49,90 @@ pub struct GlobalFrameInfoRegistration {
     key: usize,
 }
 
-#[derive(Debug)]
+/// Produces the per-function frame details of a module on first use.
+///
+/// Traps are rare, so registration stores one of these instead of the details
+/// themselves and only invokes it from the first lookup that hits the module,
+/// keeping the cost of cloning or deserializing every
+/// [`CompiledFunctionFrameInfo`] off the module load path.
+pub type FrameInfosResolver =
+    Box<dyn FnOnce() -> PrimaryMap<LocalFunctionIndex, CompiledFunctionFrameInfo> + Send + Sync>;
+
 struct ModuleInfoFrameInfo {
     start: usize,
-    functions: BTreeMap<usize, FunctionInfo>,
     module: Arc<ModuleInfo>,
-    frame_infos: PrimaryMap<LocalFunctionIndex, CompiledFunctionFrameInfo>,
+    details: ModuleFrameDetails,
+}
+
+/// The per-function information of a registered module, resolved lazily.
+enum ModuleFrameDetails {
+    /// Not looked at since registration: just the function extents, in local
+    /// function index order, and the resolver for the frame details.
+    Deferred {
+        extents: Box<[FunctionExtent]>,
+        resolve: FrameInfosResolver,
+    },
+    /// The lookup tables, built by [`ModuleInfoFrameInfo::materialize`].
+    Resolved {
+        functions: BTreeMap<usize, FunctionInfo>,
+        frame_infos: PrimaryMap<LocalFunctionIndex, CompiledFunctionFrameInfo>,
+    },
 }
 
 impl ModuleInfoFrameInfo {
+    /// Builds the per-function lookup tables if they have not been built yet.
+    fn materialize(&mut self) {
+        if let ModuleFrameDetails::Resolved { .. } = self.details {
+            return;
+        }
+        let placeholder = ModuleFrameDetails::Resolved {
+            functions: BTreeMap::new(),
+            frame_infos: PrimaryMap::new(),
+        };
+        let (extents, resolve) = match std::mem::replace(&mut self.details, placeholder) {
+            ModuleFrameDetails::Deferred { extents, resolve } => (extents, resolve),
+            ModuleFrameDetails::Resolved { .. } => unreachable!(),
+        };
+        let mut functions = BTreeMap::new();
+        for (index, extent) in extents.iter().enumerate() {
+            let start = extent.address.0 as usize;
+            functions.insert(
+                start + extent.length,
+                FunctionInfo {
+                    start,
+                    local_index: LocalFunctionIndex::new(index),
+                },
+            );
+        }
+        self.details = ModuleFrameDetails::Resolved {
+            functions,
+            frame_infos: resolve(),
+        };
+    }
+
+    /// Gets the frame details of a function. The module's details must have
+    /// been materialized beforehand.
     fn function_debug_info(&self, local_index: LocalFunctionIndex) -> &CompiledFunctionFrameInfo {
-        &self.frame_infos.get(local_index).unwrap()
+        match &self.details {
+            ModuleFrameDetails::Resolved { frame_infos, .. } => {
+                frame_infos.get(local_index).unwrap()
+            }
+            ModuleFrameDetails::Deferred { .. } => {
+                unreachable!("frame details are materialized before lookup")
+            }
+        }
     }
 
-    /// Gets a function given a pc
+    /// Gets a function given a pc. The module's details must have been
+    /// materialized beforehand.
     fn function_info(&self, pc: usize) -> Option<&FunctionInfo> {
-        let (end, func) = self.functions.range(pc..).next()?;
+        let functions = match &self.details {
+            ModuleFrameDetails::Resolved { functions, .. } => functions,
+            ModuleFrameDetails::Deferred { .. } => {
+                unreachable!("frame details are materialized before lookup")
+            }
+        };
+        let (end, func) = functions.range(pc..).next()?;
         if func.start <= pc && pc <= *end {
             return Some(func);
         } else {
@@ -82,9 +151,12 @@ impl GlobalFrameInfo {
     /// Fetches frame information about a program counter in a backtrace.
     ///
     /// Returns an object if this `pc` is known to some previously registered
-    /// module, or returns `None` if no information can be found.
-    pub fn lookup_frame_info(&self, pc: usize) -> Option<FrameInfo> {
+    /// module, or returns `None` if no information can be found. Takes `&mut
+    /// self` because the module's frame details are resolved on first use.
+    pub fn lookup_frame_info(&mut self, pc: usize) -> Option<FrameInfo> {
         let module = self.module_info(pc)?;
+        module.materialize();
+        let module = &*module;
         let func = module.function_info(pc)?;
 
         // Use our relative position from the start of the function to find the
@@ -137,8 +209,13 @@ impl GlobalFrameInfo {
     }
 
     /// Fetches trap information about a program counter in a backtrace.
-    pub fn lookup_trap_info(&self, pc: usize) -> Option<&TrapInformation> {
+    ///
+    /// Takes `&mut self` because the module's frame details are resolved on
+    /// first use.
+    pub fn lookup_trap_info(&mut self, pc: usize) -> Option<&TrapInformation> {
         let module = self.module_info(pc)?;
+        module.materialize();
+        let module = &*module;
         let func = module.function_info(pc)?;
         let traps = &module.function_debug_info(func.local_index).traps;
         let idx = traps
@@ -148,8 +225,8 @@ impl GlobalFrameInfo {
     }
 
     /// Gets a module given a pc
-    fn module_info(&self, pc: usize) -> Option<&ModuleInfoFrameInfo> {
-        let (end, module_info) = self.ranges.range(pc..).next()?;
+    fn module_info(&mut self, pc: usize) -> Option<&mut ModuleInfoFrameInfo> {
+        let (end, module_info) = self.ranges.range_mut(pc..).next()?;
         if module_info.start <= pc && pc <= *end {
             Some(module_info)
         } else {
@@ -158,6 +235,60 @@ impl GlobalFrameInfo {
     }
 }
 
+/// Registers a new compiled module's frame information.
+///
+/// Only the extent of the module's code is recorded under the global lock
+/// here; everything needed to symbolicate a trap — the per-function lookup
+/// table and the frame details produced by `frame_infos` — is materialized by
+/// the first lookup that hits the module. Traps are rare, so this keeps the
+/// per-function work off the module load path entirely.
+///
+/// `finished_functions` must yield the extents of the module's local
+/// functions in local function index order.
+///
+/// Returns `None` if the module has no code. Otherwise the returned
+/// registration unregisters the module when dropped, so it must be kept alive
+/// for as long as the module's code may appear in a backtrace.
+pub fn register_frame_info(
+    module: Arc<ModuleInfo>,
+    finished_functions: impl IntoIterator<Item = FunctionExtent>,
+    frame_infos: FrameInfosResolver,
+) -> Option<GlobalFrameInfoRegistration> {
+    let extents: Box<[FunctionExtent]> = finished_functions.into_iter().collect();
+    let mut min = usize::max_value();
+    let mut max = 0;
+    for extent in extents.iter() {
+        let start = extent.address.0 as usize;
+        min = min.min(start);
+        max = max.max(start + extent.length);
+    }
+    if extents.is_empty() {
+        return None;
+    }
+    let mut info = FRAME_INFO.write().unwrap();
+    // Assert that this module's code doesn't overlap with any previously
+    // registered module.
+    if let Some((_, prev)) = info.ranges.range(max..).next() {
+        assert!(prev.start > max);
+    }
+    if let Some((prev_end, _)) = info.ranges.range(..=min).next_back() {
+        assert!(*prev_end < min);
+    }
+    let prev = info.ranges.insert(
+        max,
+        ModuleInfoFrameInfo {
+            start: min,
+            module,
+            details: ModuleFrameDetails::Deferred {
+                extents,
+                resolve: frame_infos,
+            },
+        },
+    );
+    assert!(prev.is_none());
+    Some(GlobalFrameInfoRegistration { key: max })
+}
+
 impl Drop for GlobalFrameInfoRegistration {
     fn drop(&mut self) {
         if let Ok(mut info) = FRAME_INFO.write() {
@@ -1,4 +1,6 @@
 mod error;
 mod frame_info;
 pub use error::RuntimeError;
-pub use frame_info::{FrameInfo, GlobalFrameInfoRegistration};
+pub use frame_info::{
+    register_frame_info, FrameInfo, FrameInfosResolver, GlobalFrameInfoRegistration,
+};
@@ -624,11 +624,22 @@ pub struct InstanceConfig {
     default_gas_counter: Option<Rc<UnsafeCell<FastGasCounter>>>,
     /// Stack limit, in 8-byte slots.
     pub stack_limit: i32,
+    /// Shared epoch counter pointer, read by code compiled with epoch
+    /// interruption enabled. The host bumps the counter, typically from a
+    /// timer thread; execution traps once it reaches `epoch_deadline`.
+    pub epoch_counter: *const u64,
+    /// The epoch value at which code compiled with epoch interruption traps.
+    pub epoch_deadline: u64,
 }
 
 // Default stack limit, in 8-byte stack slots.
 const DEFAULT_STACK_LIMIT: i32 = 100 * 1024;
 
+// The epoch read by instances whose configuration carries no counter of
+// their own. It never advances, so with the `u64::MAX` default deadline the
+// emitted epoch checks never trap.
+static DEFAULT_EPOCH_COUNTER: u64 = 0;
+
 impl InstanceConfig {
     /// Create default instance configuration.
     pub fn default() -> Self {
@@ -641,6 +652,8 @@ impl InstanceConfig {
             gas_counter: result.get(),
             default_gas_counter: Some(result),
             stack_limit: DEFAULT_STACK_LIMIT,
+            epoch_counter: &DEFAULT_EPOCH_COUNTER,
+            epoch_deadline: u64::max_value(),
         }
     }
 
@@ -658,6 +671,21 @@ impl InstanceConfig {
         self.stack_limit = stack_limit;
         self
     }
+
+    /// Create instance configuration with a shared epoch counter and a
+    /// deadline, unsafe as it creates an alias on raw memory of the counter.
+    /// This memory could be accessed until any instance configured with this
+    /// `InstanceConfig` exists, and must only be written to with 8-byte
+    /// atomic stores (for example through an `AtomicU64`).
+    ///
+    /// Code compiled with epoch interruption (see
+    /// `Singlepass::epoch_interruption`) traps once `*counter >= deadline`;
+    /// other code ignores both values.
+    pub unsafe fn with_epoch(mut self, counter: *const u64, deadline: u64) -> Self {
+        self.epoch_counter = counter;
+        self.epoch_deadline = deadline;
+        self
+    }
 }
 
 #[cfg(test)]
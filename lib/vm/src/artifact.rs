@@ -1,8 +1,8 @@
 use crate::{InstanceHandle, Resolver, Tunables, VMLocalFunction, VMSharedSignatureIndex};
 use std::{any::Any, collections::BTreeMap, sync::Arc};
 use wasmer_types::{
-    entity::BoxedSlice, ElemIndex, FunctionIndex, GlobalInit, GlobalType, ImportCounts,
-    InstanceConfig, LocalFunctionIndex, OwnedDataInitializer, OwnedTableInitializer,
+    entity::BoxedSlice, DataInitializer, ElemIndex, FunctionIndex, GlobalInit, GlobalType,
+    ImportCounts, InstanceConfig, LocalFunctionIndex, OwnedTableInitializer,
 };
 
 mod private {
@@ -63,8 +63,21 @@ pub trait Artifact: Send + Sync {
     fn element_segments(&self) -> &[OwnedTableInitializer];
 
     /// Memory initializers.
-    /// TODO: consider making it an iterator of `DataInitializer`s instead?
-    fn data_segments(&self) -> &[OwnedDataInitializer];
+    ///
+    /// The segment bytes may be borrowed from a buffer the artifact keeps
+    /// alive (such as a file mapping) rather than owned heap memory.
+    fn data_segments(&self) -> Vec<DataInitializer<'_>>;
+
+    /// Copy-on-write images of the initial memory contents, for the local
+    /// memories whose data segments could be materialized into one at load
+    /// time (see [`MemoryImage`](crate::MemoryImage)).
+    ///
+    /// Instantiation maps these over the fresh linear memories instead of
+    /// copying the corresponding data segments byte by byte.
+    #[cfg(target_os = "linux")]
+    fn memory_images(&self) -> &[(wasmer_types::MemoryIndex, Arc<crate::MemoryImage>)] {
+        &[]
+    }
 
     /// Passive table elements.
     fn globals(&self) -> &[(GlobalType, GlobalInit)];
@@ -80,6 +93,23 @@ pub trait Artifact: Send + Sync {
 
     /// Obtain the function signature for either the import or local definition.
     fn function_signature(&self, index: FunctionIndex) -> Option<VMSharedSignatureIndex>;
+
+    /// Compile the body for the local function `index` on its first call.
+    ///
+    /// This is only ever invoked by the `wasmer_vm_lazy_compile` libcall, from
+    /// the stub an engine with lazy compilation enabled placed in the function
+    /// body slot. Artifacts produced by eager compilation never see this
+    /// called.
+    fn lazy_compile(
+        &self,
+        index: LocalFunctionIndex,
+    ) -> Result<*const crate::VMFunctionBody, Box<dyn std::error::Error + Send + Sync>> {
+        Err(format!(
+            "this artifact does not support lazy compilation of function {:?}",
+            index
+        )
+        .into())
+    }
 }
 
 impl dyn Artifact {
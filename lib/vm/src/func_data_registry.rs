@@ -6,17 +6,26 @@
 
 use crate::vmcontext::VMCallerCheckedAnyfunc;
 use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
 use std::sync::Mutex;
 
+/// The number of independently locked shards in the registry.
+const SHARDS: usize = 16;
+
+/// The number of anyfuncs in one arena chunk.
+const CHUNK: usize = 128;
+
 /// The registry that holds the values that `VMFuncRef`s point to.
 #[derive(Debug)]
 pub struct FuncDataRegistry {
     // This structure is stored in an `Engine` and is intended to be shared
-    // across many instances. Ideally instances can themselves be sent across
-    // threads, and ideally we can compile across many threads. As a result we
-    // use interior mutability here with a lock to avoid having callers to
-    // externally synchronize calls to compilation.
-    inner: Mutex<Inner>,
+    // across many instances, which may register their funcrefs from many
+    // threads at once. Each anyfunc hashes to one of several independently
+    // locked shards, so concurrent registrations only serialize when they
+    // collide, and each shard bump-allocates its anyfuncs out of fixed-size
+    // chunks: addresses are stable for the lifetime of the registry, and
+    // funcrefs registered together land in contiguous memory.
+    shards: [Mutex<Shard>; SHARDS],
 }
 
 // We use raw pointers but the data never moves, so it's not a problem
@@ -87,30 +96,79 @@ unsafe impl Send for VMFuncRef {}
 unsafe impl Sync for VMFuncRef {}
 
 #[derive(Debug, Default)]
-struct Inner {
-    func_data: Vec<VMCallerCheckedAnyfunc>,
-    anyfunc_to_index: HashMap<VMCallerCheckedAnyfunc, usize>,
+struct Shard {
+    anyfunc_to_ref: HashMap<VMCallerCheckedAnyfunc, VMFuncRef>,
+    /// The arena: every chunk is allocated with `CHUNK` capacity up front and
+    /// never grown past it, so anyfuncs never move once written.
+    chunks: Vec<Vec<VMCallerCheckedAnyfunc>>,
 }
 
 impl FuncDataRegistry {
     /// Create a new `FuncDataRegistry`.
     pub fn new() -> Self {
         Self {
-            inner: Default::default(),
+            shards: Default::default(),
         }
     }
 
     /// Register a signature and return its unique index.
     pub fn register(&self, anyfunc: VMCallerCheckedAnyfunc) -> VMFuncRef {
-        let mut inner = self.inner.lock().unwrap();
-        let data = if let Some(&idx) = inner.anyfunc_to_index.get(&anyfunc) {
-            &inner.func_data[idx]
-        } else {
-            let idx = inner.func_data.len();
-            inner.func_data.push(anyfunc);
-            inner.anyfunc_to_index.insert(anyfunc, idx);
-            &inner.func_data[idx]
-        };
-        VMFuncRef(data)
+        let mut hasher = std::collections::hash_map::DefaultHasher::new();
+        anyfunc.hash(&mut hasher);
+        let mut shard = self.shards[hasher.finish() as usize % SHARDS]
+            .lock()
+            .unwrap();
+        if let Some(&funcref) = shard.anyfunc_to_ref.get(&anyfunc) {
+            return funcref;
+        }
+        if shard.chunks.last().map_or(true, |c| c.len() == CHUNK) {
+            shard.chunks.push(Vec::with_capacity(CHUNK));
+        }
+        let chunk = shard.chunks.last_mut().unwrap();
+        chunk.push(anyfunc);
+        let funcref = VMFuncRef(chunk.last().unwrap());
+        shard.anyfunc_to_ref.insert(anyfunc, funcref);
+        funcref
+    }
+
+    /// The number of distinct anyfuncs registered so far.
+    pub fn len(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| shard.lock().unwrap().anyfunc_to_ref.len())
+            .sum()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::vmcontext::VMFunctionEnvironment;
+    use crate::VMSharedSignatureIndex;
+
+    fn anyfunc(n: u32) -> VMCallerCheckedAnyfunc {
+        VMCallerCheckedAnyfunc {
+            func_ptr: n as usize as *const _,
+            type_index: VMSharedSignatureIndex::new(n),
+            vmctx: VMFunctionEnvironment {
+                host_env: std::ptr::null_mut(),
+            },
+        }
+    }
+
+    #[test]
+    fn register_dedupes_and_addresses_are_stable() {
+        let registry = FuncDataRegistry::new();
+        let early = (0..10).map(|n| registry.register(anyfunc(n))).collect::<Vec<_>>();
+        assert_eq!(early[3], registry.register(anyfunc(3)));
+        // Fill well past one arena chunk and recheck the early pointers.
+        for n in 10..10 * CHUNK as u32 {
+            registry.register(anyfunc(n));
+        }
+        for (n, funcref) in early.iter().enumerate() {
+            assert_eq!(*funcref, registry.register(anyfunc(n as u32)));
+            let data = unsafe { &*funcref.0 };
+            assert_eq!(data.type_index, VMSharedSignatureIndex::new(n as u32));
+        }
     }
 }
@@ -5,9 +5,97 @@ use std::alloc::{self, Layout};
 use std::convert::TryFrom;
 use std::mem;
 use std::ptr::{self, NonNull};
+use std::sync::{Arc, Mutex};
 use wasmer_types::entity::EntityRef;
 use wasmer_types::{LocalMemoryIndex, LocalTableIndex};
 
+/// A pool of preallocated, fixed-capacity instance slots.
+///
+/// Repeated instantiation pays one variable-length allocation per instance
+/// for the `Instance` plus its `VMContext` area. A pool sized for a given
+/// module (see [`VMOffsets`]) turns that into popping a slot off a free list;
+/// when the instance is deallocated its slot returns to the pool rather than
+/// to the global allocator.
+///
+/// Cloning the pool is cheap and yields a handle to the same slots. The
+/// backing slab is freed once the pool and every instance allocated from it
+/// are gone.
+#[derive(Clone, Debug)]
+pub struct InstancePool {
+    inner: Arc<InstancePoolInner>,
+}
+
+#[derive(Debug)]
+struct InstancePoolInner {
+    /// The backing allocation holding `capacity` contiguous slots.
+    slab: NonNull<u8>,
+    slab_layout: Layout,
+    /// The layout of a single slot.
+    slot_layout: Layout,
+    /// Slots not currently occupied by a live instance.
+    free: Mutex<Vec<NonNull<u8>>>,
+}
+
+// SAFETY: the raw pointers refer to the pool-owned slab; slot hand-out and
+// return are synchronized through the `free` list's mutex.
+unsafe impl Send for InstancePoolInner {}
+unsafe impl Sync for InstancePoolInner {}
+
+impl Drop for InstancePoolInner {
+    fn drop(&mut self) {
+        unsafe {
+            alloc::dealloc(self.slab.as_ptr(), self.slab_layout);
+        }
+    }
+}
+
+impl InstancePool {
+    /// Preallocate `capacity` instance slots, each large enough for an
+    /// instance of the module described by `offsets`.
+    pub fn new(capacity: usize, offsets: &VMOffsets) -> Self {
+        let slot_layout = InstanceAllocator::instance_layout(offsets);
+        let slab_layout = Layout::from_size_align(
+            slot_layout.size().checked_mul(capacity).unwrap(),
+            slot_layout.align(),
+        )
+        .expect("failed to create a layout for the instance pool slab");
+        let slab = if let Some(ptr) = NonNull::new(unsafe { alloc::alloc(slab_layout) }) {
+            ptr
+        } else {
+            alloc::handle_alloc_error(slab_layout);
+        };
+        let free = (0..capacity)
+            .map(|i| unsafe { NonNull::new_unchecked(slab.as_ptr().add(i * slot_layout.size())) })
+            .collect();
+        Self {
+            inner: Arc::new(InstancePoolInner {
+                slab,
+                slab_layout,
+                slot_layout,
+                free: Mutex::new(free),
+            }),
+        }
+    }
+
+    /// Whether an instance of the module described by `offsets` fits in one
+    /// of this pool's slots.
+    pub fn fits(&self, offsets: &VMOffsets) -> bool {
+        let layout = InstanceAllocator::instance_layout(offsets);
+        layout.size() <= self.inner.slot_layout.size()
+            && layout.align() <= self.inner.slot_layout.align()
+    }
+
+    /// Take a free slot out of the pool, if any remain.
+    fn acquire(&self) -> Option<NonNull<u8>> {
+        self.inner.free.lock().unwrap().pop()
+    }
+
+    /// Return a slot to the pool.
+    pub(super) fn release(&self, slot: NonNull<u8>) {
+        self.inner.free.lock().unwrap().push(slot);
+    }
+}
+
 /// This is an intermediate type that manages the raw allocation and
 /// metadata when creating an [`Instance`].
 ///
@@ -37,6 +125,9 @@ pub struct InstanceAllocator {
     /// the dynamic fields.
     offsets: VMOffsets,
 
+    /// The pool the `instance_ptr` buffer was acquired from, if any.
+    pool: Option<InstancePool>,
+
     /// Whether or not this type has transferred ownership of the
     /// `instance_ptr` buffer. If it has not when being dropped,
     /// the buffer should be freed.
@@ -50,8 +141,11 @@ impl Drop for InstanceAllocator {
             // over the buffer and must free it.
             let instance_ptr = self.instance_ptr.as_ptr();
 
-            unsafe {
-                std::alloc::dealloc(instance_ptr as *mut u8, self.instance_layout);
+            match &self.pool {
+                Some(pool) => pool.release(self.instance_ptr.cast()),
+                None => unsafe {
+                    std::alloc::dealloc(instance_ptr as *mut u8, self.instance_layout);
+                },
             }
         }
     }
@@ -89,6 +183,7 @@ impl InstanceAllocator {
             instance_ptr,
             instance_layout,
             offsets,
+            pool: None,
             consumed: false,
         };
 
@@ -102,6 +197,44 @@ impl InstanceAllocator {
         (allocator, memories, tables)
     }
 
+    /// Like [`InstanceAllocator::new`], but acquires the instance buffer
+    /// from `pool` instead of the global allocator.
+    ///
+    /// Returns `None` when the instance does not fit in one of the pool's
+    /// slots or the pool is exhausted; callers are expected to fall back
+    /// to [`InstanceAllocator::new`].
+    pub fn new_pooled(
+        offsets: VMOffsets,
+        pool: &InstancePool,
+    ) -> Option<(
+        Self,
+        Vec<NonNull<VMMemoryDefinition>>,
+        Vec<NonNull<VMTableDefinition>>,
+    )> {
+        if !pool.fits(&offsets) {
+            return None;
+        }
+        let instance_layout = Self::instance_layout(&offsets);
+        let instance_ptr = pool.acquire()?.cast::<Instance>();
+
+        let allocator = Self {
+            instance_ptr,
+            instance_layout,
+            offsets,
+            pool: Some(pool.clone()),
+            consumed: false,
+        };
+
+        // # Safety
+        // `fits` above checked that the slot is large enough for the same
+        // `offsets` that these functions use, so there will be enough valid
+        // memory for both of them.
+        let memories = unsafe { allocator.memory_definition_locations() };
+        let tables = unsafe { allocator.table_definition_locations() };
+
+        Some((allocator, memories, tables))
+    }
+
     /// Calculate the appropriate layout for the [`Instance`].
     fn instance_layout(offsets: &VMOffsets) -> Layout {
         let vmctx_size = usize::try_from(offsets.size_of_vmctx())
@@ -200,9 +333,10 @@ impl InstanceAllocator {
         }
         let instance = self.instance_ptr;
         let instance_layout = self.instance_layout;
+        let pool = self.pool.clone();
 
         // This is correct because of the invariants of `Self` and
         // because we write `Instance` to the pointer in this function.
-        unsafe { InstanceRef::new(instance, instance_layout) }
+        unsafe { InstanceRef::new(instance, instance_layout, pool) }
     }
 }
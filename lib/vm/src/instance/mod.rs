@@ -10,7 +10,7 @@
 mod allocator;
 mod r#ref;
 
-pub use allocator::InstanceAllocator;
+pub use allocator::{InstanceAllocator, InstancePool};
 pub use r#ref::{InstanceRef, WeakInstanceRef, WeakOrStrongInstanceRef};
 
 use crate::func_data_registry::VMFuncRef;
@@ -357,6 +357,16 @@ impl Instance {
         unsafe { self.vmctx_plus_offset(self.offsets().vmctx_gas_limiter_pointer()) }
     }
 
+    /// Return a pointer to the epoch counter pointer.
+    pub fn epoch_counter_ptr(&self) -> *mut *const u64 {
+        unsafe { self.vmctx_plus_offset(self.offsets().vmctx_epoch_counter_pointer()) }
+    }
+
+    /// Return a pointer to the epoch deadline.
+    pub fn epoch_deadline_ptr(&self) -> *mut u64 {
+        unsafe { self.vmctx_plus_offset(self.offsets().vmctx_epoch_deadline_begin()) }
+    }
+
     /// Return a pointer to initial stack limit.
     pub fn stack_limit_initial_ptr(&self) -> *mut i32 {
         unsafe { self.vmctx_plus_offset(self.offsets().vmctx_stack_limit_initial_begin()) }
@@ -614,18 +624,13 @@ impl Instance {
         if src
             .checked_add(len)
             .map_or(true, |n| n as usize > elem.len())
-            || dst.checked_add(len).map_or(true, |m| m > table.size())
         {
             return Err(Trap::lib(TrapCode::TableAccessOutOfBounds));
         }
 
-        for (dst, src) in (dst..dst + len).zip(src..src + len) {
-            table
-                .set(dst, TableElement::FuncRef(elem[src as usize]))
-                .expect("should never panic because we already did the bounds check above");
-        }
-
-        Ok(())
+        // `init_funcs` bounds-checks the destination range and writes the
+        // whole range under a single lock.
+        table.init_funcs(dst, &elem[src as usize..(src + len) as usize])
     }
 
     /// The `table.fill` operation: fills a portion of a table with a given value.
@@ -891,6 +896,8 @@ impl InstanceHandle {
                 *(instance.gas_counter_ptr()) = instance_config.gas_counter;
                 *(instance.stack_limit_ptr()) = instance_config.stack_limit;
                 *(instance.stack_limit_initial_ptr()) = instance_config.stack_limit;
+                *(instance.epoch_counter_ptr()) = instance_config.epoch_counter;
+                *(instance.epoch_deadline_ptr()) = instance_config.epoch_deadline;
             }
 
             Self {
@@ -960,10 +967,7 @@ impl InstanceHandle {
 
         // Apply the initializers.
         initialize_tables(instance)?;
-        initialize_memories(
-            instance,
-            instance.artifact.data_segments().iter().map(Into::into),
-        )?;
+        initialize_memories(instance, instance.artifact.data_segments().into_iter())?;
 
         // The WebAssembly spec specifies that the start function is
         // invoked automatically at instantiation time.
@@ -1239,22 +1243,15 @@ fn initialize_tables(instance: &Instance) -> Result<(), Trap> {
         let start = get_table_init_start(init, instance);
         let table = instance.get_table(init.table_index);
 
-        if start
-            .checked_add(init.elements.len())
-            .map_or(true, |end| end > table.size() as usize)
-        {
-            return Err(Trap::lib(TrapCode::TableAccessOutOfBounds));
-        }
-
-        for (i, func_idx) in init.elements.iter().enumerate() {
-            let anyfunc = instance.get_vm_funcref(*func_idx);
-            table
-                .set(
-                    u32::try_from(start + i).unwrap(),
-                    TableElement::FuncRef(anyfunc),
-                )
-                .unwrap();
-        }
+        // A start beyond `u32` is necessarily beyond the table's size too.
+        let start =
+            u32::try_from(start).map_err(|_| Trap::lib(TrapCode::TableAccessOutOfBounds))?;
+        let funcrefs: Vec<VMFuncRef> = init
+            .elements
+            .iter()
+            .map(|func_idx| instance.get_vm_funcref(*func_idx))
+            .collect();
+        table.init_funcs(start, &funcrefs)?;
     }
 
     Ok(())
@@ -1288,11 +1285,51 @@ fn initialize_passive_elements(instance: &Instance) {
     );
 }
 
+/// Map the artifact's copy-on-write memory images over the memories they
+/// cover, returning the indices of the memories so initialized.
+///
+/// Memories whose image does not fit or cannot be mapped are left for the
+/// byte-copy path in `initialize_memories`, which also raises the right trap
+/// for out-of-bounds segments.
+#[cfg(target_os = "linux")]
+fn apply_memory_images(instance: &Instance) -> Vec<MemoryIndex> {
+    let mut mapped = Vec::new();
+    for (memory_index, image) in instance.artifact.memory_images() {
+        let memory = instance.memory_definition(*memory_index);
+        if image.len() <= memory.current_length {
+            // SAFETY: the linear memory base is page-aligned and has at least
+            // `current_length` accessible bytes, and no references into it
+            // exist yet at initialization time.
+            if unsafe { image.map_at(memory.base) }.is_ok() {
+                // The covered pages are now file-backed: the memory must know,
+                // so that a pooled reservation is remapped anonymously rather
+                // than reset in place when it is released.
+                match instance
+                    .artifact
+                    .import_counts()
+                    .local_memory_index(*memory_index)
+                {
+                    Ok(local) => instance.memories[local].mark_image_mapped(),
+                    Err(import) => instance.imported_memory(import).from.mark_image_mapped(),
+                }
+                mapped.push(*memory_index);
+            }
+        }
+    }
+    mapped
+}
+
+#[cfg(not(target_os = "linux"))]
+fn apply_memory_images(_instance: &Instance) -> Vec<MemoryIndex> {
+    Vec::new()
+}
+
 /// Initialize the table memory from the provided initializers.
 fn initialize_memories<'a>(
     instance: &Instance,
     data_initializers: impl Iterator<Item = DataInitializer<'a>>,
 ) -> Result<(), Trap> {
+    let image_initialized = apply_memory_images(instance);
     for init in data_initializers {
         let memory = instance.memory_definition(init.location.memory_index);
 
@@ -1304,6 +1341,11 @@ fn initialize_memories<'a>(
             return Err(Trap::lib(TrapCode::HeapAccessOutOfBounds));
         }
 
+        if image_initialized.contains(&init.location.memory_index) {
+            // This memory's contents were already mapped in from an image.
+            continue;
+        }
+
         unsafe {
             let mem_slice = get_memory_slice(&init, instance);
             let end = start + init.data.len();
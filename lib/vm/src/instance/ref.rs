@@ -1,4 +1,4 @@
-use super::Instance;
+use super::{Instance, InstancePool};
 use std::alloc::Layout;
 use std::convert::TryFrom;
 use std::ptr::{self, NonNull};
@@ -19,6 +19,11 @@ struct InstanceInner {
     /// The layout of `Instance` (which can vary).
     instance_layout: Layout,
 
+    /// The pool the `Instance`'s buffer was acquired from, if any. When
+    /// set, deallocating returns the buffer to the pool instead of the
+    /// global allocator.
+    pool: Option<InstancePool>,
+
     /// The `Instance` itself. It must be the last field of
     /// `InstanceRef` since `Instance` is dyamically-sized.
     ///
@@ -43,7 +48,10 @@ impl InstanceInner {
         let instance_ptr = self.instance.as_ptr();
 
         ptr::drop_in_place(instance_ptr);
-        std::alloc::dealloc(instance_ptr as *mut u8, self.instance_layout);
+        match &self.pool {
+            Some(pool) => pool.release(self.instance.cast()),
+            None => std::alloc::dealloc(instance_ptr as *mut u8, self.instance_layout),
+        }
     }
 
     /// Get a reference to the `Instance`.
@@ -113,9 +121,14 @@ impl InstanceRef {
     /// and correctly initialized pointer to `Instance`. See
     /// [`InstanceAllocator`] for an example of how to correctly use
     /// this API.
-    pub(super) unsafe fn new(instance: NonNull<Instance>, instance_layout: Layout) -> Self {
+    pub(super) unsafe fn new(
+        instance: NonNull<Instance>,
+        instance_layout: Layout,
+        pool: Option<InstancePool>,
+    ) -> Self {
         Self(Arc::new(InstanceInner {
             instance_layout,
+            pool,
             instance,
         }))
     }
@@ -28,6 +28,8 @@ mod global;
 mod imports;
 mod instance;
 mod memory;
+#[cfg(target_os = "linux")]
+mod memory_image;
 mod mmap;
 mod probestack;
 mod resolver;
@@ -47,9 +49,11 @@ pub use crate::global::*;
 pub use crate::imports::{Imports, VMImport, VMImportType};
 pub use crate::instance::{
     initialize_host_envs, ImportFunctionEnv, ImportInitializerFuncPtr, InstanceAllocator,
-    InstanceHandle, WeakOrStrongInstanceRef,
+    InstanceHandle, InstancePool, WeakOrStrongInstanceRef,
 };
-pub use crate::memory::{LinearMemory, Memory, MemoryError, MemoryStyle};
+pub use crate::memory::{LinearMemory, Memory, MemoryError, MemoryPool, MemoryStyle};
+#[cfg(target_os = "linux")]
+pub use crate::memory_image::MemoryImage;
 pub use crate::mmap::Mmap;
 pub use crate::probestack::PROBESTACK;
 pub use crate::resolver::{
@@ -40,13 +40,13 @@
 use crate::func_data_registry::VMFuncRef;
 use crate::probestack::PROBESTACK;
 use crate::table::{RawTableElement, TableElement};
-use crate::trap::{raise_lib_trap, Trap, TrapCode};
-use crate::vmcontext::VMContext;
+use crate::trap::{raise_lib_trap, raise_user_trap, Trap, TrapCode};
+use crate::vmcontext::{VMContext, VMFunctionBody};
 use crate::VMExternRef;
 use std::fmt;
 use wasmer_types::{
-    DataIndex, ElemIndex, FunctionIndex, LocalMemoryIndex, LocalTableIndex, MemoryIndex,
-    TableIndex, Type,
+    DataIndex, ElemIndex, FunctionIndex, LocalFunctionIndex, LocalMemoryIndex, LocalTableIndex,
+    MemoryIndex, TableIndex, Type,
 };
 
 /// Implementation of f32.ceil
@@ -674,6 +674,33 @@ pub unsafe extern "C" fn wasmer_vm_raise_trap(trap_code: TrapCode) -> ! {
 #[no_mangle]
 pub static wasmer_vm_probestack: unsafe extern "C" fn() = PROBESTACK;
 
+/// Implementation of lazy (per-function) compilation.
+///
+/// This is called from the stub the engine places in the body slot of a
+/// not-yet-compiled local function. The artifact compiles the one function,
+/// publishes it and returns the address of the fresh body, which the stub then
+/// tail-calls. Compilation failures are raised as (user) traps.
+///
+/// # Safety
+///
+/// `vmctx` must be dereferenceable. Only safe to call when wasm code is on the
+/// stack, as a compilation failure unwinds to the closest `catch_traps`.
+#[no_mangle]
+pub unsafe extern "C" fn wasmer_vm_lazy_compile(
+    vmctx: *mut VMContext,
+    function_index: u32,
+) -> *const VMFunctionBody {
+    let result = {
+        let function_index = LocalFunctionIndex::from_u32(function_index);
+        let instance = (&*vmctx).instance();
+        instance.artifact.lazy_compile(function_index)
+    };
+    match result {
+        Ok(body) => body,
+        Err(error) => raise_user_trap(error),
+    }
+}
+
 /// The name of a runtime library routine.
 ///
 /// This list is likely to grow over time.
@@ -771,6 +798,9 @@ pub enum LibCall {
     /// A custom trap
     RaiseTrap,
 
+    /// lazy per-function compilation
+    LazyCompile,
+
     /// probe for stack overflow. These are emitted for functions which need
     /// when the `enable_probestack` setting is true.
     Probestack,
@@ -811,6 +841,7 @@ impl LibCall {
             Self::DataDrop => wasmer_vm_data_drop as usize,
             Self::Probestack => wasmer_vm_probestack as usize,
             Self::RaiseTrap => wasmer_vm_raise_trap as usize,
+            Self::LazyCompile => wasmer_vm_lazy_compile as usize,
         }
     }
 
@@ -847,6 +878,7 @@ impl LibCall {
             Self::Memory32Init => "wasmer_vm_memory32_init",
             Self::DataDrop => "wasmer_vm_data_drop",
             Self::RaiseTrap => "wasmer_vm_raise_trap",
+            Self::LazyCompile => "wasmer_vm_lazy_compile",
             // We have to do this because macOS requires a leading `_` and it's not
             // a normal function, it's a static variable, so we have to do it manually.
             #[cfg(target_vendor = "apple")]
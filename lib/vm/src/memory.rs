@@ -12,8 +12,10 @@ use std::borrow::BorrowMut;
 use std::cell::UnsafeCell;
 use std::convert::TryInto;
 use std::fmt;
+use std::mem;
 use std::ptr::NonNull;
-use std::sync::Mutex;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex};
 use thiserror::Error;
 use wasmer_types::{Bytes, MemoryType, Pages};
 
@@ -79,6 +81,10 @@ pub enum MemoryStyle {
         /// It represents the size in bytes of extra guard pages after the end
         /// to optimize loads and stores with constant offsets.
         offset_guard_size: u64,
+        /// Whether to ask the OS to back the memory with huge pages, to cut
+        /// dTLB pressure on large guest heaps (see
+        /// [`Mmap::accessible_reserved_huge_pages`]).
+        huge_pages: bool,
     },
 }
 
@@ -112,6 +118,170 @@ pub trait Memory: fmt::Debug + Send + Sync {
     ///
     /// The pointer returned in [`VMMemoryDefinition`] must be valid for the lifetime of this memory.
     fn vmmemory(&self) -> NonNull<VMMemoryDefinition>;
+
+    /// Record that a file-backed image was mapped over this memory's pages
+    /// (see `MemoryImage::map_at`), so the backing mapping can no longer be
+    /// assumed to be anonymous. The default implementation does nothing.
+    fn mark_image_mapped(&self) {}
+}
+
+/// A pool of reusable linear-memory reservations.
+///
+/// Creating a [`LinearMemory`] mmaps a fresh region and unmaps it on drop;
+/// under frequent instantiation the mmap/munmap traffic and page zeroing show
+/// up as kernel time. A pool preallocates a fixed set of reservations sized
+/// for one [`MemoryStyle::Static`] and hands them out to new memories; on
+/// drop, a pooled memory's mapping is reset — made inaccessible again and its
+/// pages returned to the kernel with `madvise(MADV_DONTNEED)`, so they read
+/// as zero on reuse — instead of being unmapped.
+///
+/// Cloning the pool is cheap and yields a handle to the same reservations.
+#[derive(Clone, Debug)]
+pub struct MemoryPool {
+    inner: Arc<MemoryPoolInner>,
+}
+
+#[derive(Debug)]
+struct MemoryPoolInner {
+    /// The size of each reservation: the static bound plus the offset guard.
+    mapping_size: usize,
+    /// Reservations not currently backing a live memory. All pages are
+    /// inaccessible and read as zero once made accessible again.
+    free: Mutex<Vec<Mmap>>,
+}
+
+impl MemoryPool {
+    /// Preallocate `capacity` reservations sized for the given memory style,
+    /// which must be [`MemoryStyle::Static`].
+    pub fn new(capacity: usize, style: &MemoryStyle) -> Result<Self, MemoryError> {
+        let (bound, offset_guard_size, huge_pages) = match style {
+            MemoryStyle::Static {
+                bound,
+                offset_guard_size,
+                huge_pages,
+            } => (*bound, *offset_guard_size, *huge_pages),
+            MemoryStyle::Dynamic { .. } => {
+                return Err(MemoryError::Generic(
+                    "memory pools require a static memory style".to_string(),
+                ))
+            }
+        };
+        let mapping_size = bound
+            .bytes()
+            .0
+            .checked_add(offset_guard_size as usize)
+            .ok_or_else(|| {
+                MemoryError::Generic("memory pool reservation size overflow".to_string())
+            })?;
+        let free = (0..capacity)
+            .map(|_| {
+                if huge_pages {
+                    Mmap::accessible_reserved_huge_pages(0, mapping_size)
+                } else {
+                    Mmap::accessible_reserved(0, mapping_size)
+                }
+            })
+            .collect::<Result<Vec<_>, _>>()
+            .map_err(MemoryError::Region)?;
+        Ok(Self {
+            inner: Arc::new(MemoryPoolInner {
+                mapping_size,
+                free: Mutex::new(free),
+            }),
+        })
+    }
+
+    /// Take a reservation out of the pool, making its first
+    /// `accessible_size` bytes accessible.
+    ///
+    /// Returns `None` when `mapping_size` does not match the pool's
+    /// reservations or the pool is exhausted; callers are expected to fall
+    /// back to a fresh mapping.
+    fn acquire(&self, mapping_size: usize, accessible_size: usize) -> Option<Mmap> {
+        if mapping_size != self.inner.mapping_size {
+            return None;
+        }
+        let mut mmap = self.inner.free.lock().unwrap().pop()?;
+        if accessible_size != 0 && mmap.make_accessible(0, accessible_size).is_err() {
+            // The reservation is in an unknown state; drop it rather than
+            // returning it to the pool.
+            return None;
+        }
+        Some(mmap)
+    }
+
+    /// Reset a reservation and return it to the pool. Reservations that
+    /// cannot be reset are unmapped instead.
+    ///
+    /// `image_mapped` must be true when a file-backed image was mapped over
+    /// any part of the reservation: such reservations cannot be reset in
+    /// place and are remapped anonymously instead.
+    fn release(&self, mut mmap: Mmap, image_mapped: bool) {
+        let reset = if image_mapped {
+            remap_reservation_anonymous(&mut mmap)
+        } else {
+            reset_reservation(&mut mmap)
+        };
+        if mmap.len() == self.inner.mapping_size && reset.is_ok() {
+            self.inner.free.lock().unwrap().push(mmap);
+        }
+    }
+}
+
+/// Make all of a reservation's pages inaccessible again and return them to
+/// the kernel, so that the next use reads zeroes, without unmapping it.
+#[cfg(not(target_os = "windows"))]
+fn reset_reservation(mmap: &mut Mmap) -> Result<(), String> {
+    use std::io;
+    unsafe {
+        let ptr = mmap.as_mut_ptr() as *mut libc::c_void;
+        if libc::mprotect(ptr, mmap.len(), libc::PROT_NONE) != 0 {
+            return Err(io::Error::last_os_error().to_string());
+        }
+        if libc::madvise(ptr, mmap.len(), libc::MADV_DONTNEED) != 0 {
+            return Err(io::Error::last_os_error().to_string());
+        }
+    }
+    Ok(())
+}
+
+#[cfg(target_os = "windows")]
+fn reset_reservation(_mmap: &mut Mmap) -> Result<(), String> {
+    // There is no cheap way to decommit-and-zero in place here; dropping the
+    // mapping makes the pool hand out fresh reservations instead.
+    Err("memory reservation reuse is not supported on this platform".to_string())
+}
+
+/// Replace a reservation's pages with a fresh anonymous `PROT_NONE` mapping
+/// in place.
+///
+/// This is required instead of [`reset_reservation`] once a file-backed image
+/// has been mapped over part of the reservation: on file-backed pages,
+/// `madvise(MADV_DONTNEED)` restores the *file* contents rather than zeroes,
+/// so resetting in place would carry the previous instance's image into the
+/// next user of the reservation.
+#[cfg(not(target_os = "windows"))]
+fn remap_reservation_anonymous(mmap: &mut Mmap) -> Result<(), String> {
+    use std::io;
+    unsafe {
+        let ptr = libc::mmap(
+            mmap.as_mut_ptr() as *mut libc::c_void,
+            mmap.len(),
+            libc::PROT_NONE,
+            libc::MAP_PRIVATE | libc::MAP_ANON | libc::MAP_FIXED,
+            -1,
+            0,
+        );
+        if ptr as isize == -1_isize {
+            return Err(io::Error::last_os_error().to_string());
+        }
+    }
+    Ok(())
+}
+
+#[cfg(target_os = "windows")]
+fn remap_reservation_anonymous(_mmap: &mut Mmap) -> Result<(), String> {
+    Err("memory reservation reuse is not supported on this platform".to_string())
 }
 
 /// A linear memory instance.
@@ -133,6 +303,16 @@ pub struct LinearMemory {
     // constant offsets.
     offset_guard_size: usize,
 
+    /// The pool the backing reservation was acquired from, if any. When set,
+    /// dropping this memory returns the reservation to the pool instead of
+    /// unmapping it.
+    pool: Option<MemoryPool>,
+
+    /// Whether a file-backed image was mapped over this memory's pages (see
+    /// [`Memory::mark_image_mapped`]). A pooled reservation so covered must
+    /// be remapped anonymously, not reset in place, when it is released.
+    image_mapped: AtomicBool,
+
     /// The owned memory definition used by the generated code
     vm_memory_definition: VMMemoryDefinitionOwnership,
 }
@@ -176,7 +356,18 @@ impl LinearMemory {
     /// This creates a `LinearMemory` with owned metadata: this can be used to create a memory
     /// that will be imported into Wasm modules.
     pub fn new(memory: &MemoryType, style: &MemoryStyle) -> Result<Self, MemoryError> {
-        unsafe { Self::new_internal(memory, style, None) }
+        unsafe { Self::new_internal(memory, style, None, None) }
+    }
+
+    /// Like [`LinearMemory::new`], but drawing the backing reservation from
+    /// `pool` when the style matches the pool's reservations, and falling
+    /// back to a fresh mapping otherwise.
+    pub fn new_pooled(
+        memory: &MemoryType,
+        style: &MemoryStyle,
+        pool: &MemoryPool,
+    ) -> Result<Self, MemoryError> {
+        unsafe { Self::new_internal(memory, style, None, Some(pool)) }
     }
 
     /// Create a new linear memory instance with specified minimum and maximum number of wasm pages.
@@ -191,7 +382,22 @@ impl LinearMemory {
         style: &MemoryStyle,
         vm_memory_location: NonNull<VMMemoryDefinition>,
     ) -> Result<Self, MemoryError> {
-        Self::new_internal(memory, style, Some(vm_memory_location))
+        Self::new_internal(memory, style, Some(vm_memory_location), None)
+    }
+
+    /// Like [`LinearMemory::from_definition`], but drawing the backing
+    /// reservation from `pool` when the style matches the pool's
+    /// reservations, and falling back to a fresh mapping otherwise.
+    ///
+    /// # Safety
+    /// - `vm_memory_location` must point to a valid location in VM memory.
+    pub unsafe fn from_definition_pooled(
+        memory: &MemoryType,
+        style: &MemoryStyle,
+        vm_memory_location: NonNull<VMMemoryDefinition>,
+        pool: &MemoryPool,
+    ) -> Result<Self, MemoryError> {
+        Self::new_internal(memory, style, Some(vm_memory_location), Some(pool))
     }
 
     /// Build a `LinearMemory` with either self-owned or VM owned metadata.
@@ -199,6 +405,7 @@ impl LinearMemory {
         memory: &MemoryType,
         style: &MemoryStyle,
         vm_memory_location: Option<NonNull<VMMemoryDefinition>>,
+        pool: Option<&MemoryPool>,
     ) -> Result<Self, MemoryError> {
         if memory.minimum > Pages::max_value() {
             return Err(MemoryError::MinimumMemoryTooLarge {
@@ -238,9 +445,32 @@ impl LinearMemory {
         let mapped_pages = memory.minimum;
         let mapped_bytes = mapped_pages.bytes();
 
-        let mut mmap = WasmMmap {
-            alloc: Mmap::accessible_reserved(mapped_bytes.0, request_bytes)
+        // Acquire a pooled reservation when one matches the requested style;
+        // `None` (no pool, size mismatch or exhaustion) means a fresh mapping.
+        let pooled_alloc = pool.and_then(|pool| pool.acquire(request_bytes, mapped_bytes.0));
+        let used_pool = if pooled_alloc.is_some() {
+            pool.cloned()
+        } else {
+            None
+        };
+        let alloc = match pooled_alloc {
+            Some(alloc) => alloc,
+            None if matches!(
+                style,
+                MemoryStyle::Static {
+                    huge_pages: true,
+                    ..
+                }
+            ) =>
+            {
+                Mmap::accessible_reserved_huge_pages(mapped_bytes.0, request_bytes)
+                    .map_err(MemoryError::Region)?
+            }
+            None => Mmap::accessible_reserved(mapped_bytes.0, request_bytes)
                 .map_err(MemoryError::Region)?,
+        };
+        let mut mmap = WasmMmap {
+            alloc,
             size: memory.minimum,
         };
 
@@ -250,6 +480,8 @@ impl LinearMemory {
             mmap: Mutex::new(mmap),
             maximum: memory.maximum,
             offset_guard_size: offset_guard_bytes,
+            pool: used_pool,
+            image_mapped: AtomicBool::new(false),
             vm_memory_definition: if let Some(mem_loc) = vm_memory_location {
                 {
                     let mut ptr = mem_loc;
@@ -286,6 +518,16 @@ impl LinearMemory {
     }
 }
 
+impl Drop for LinearMemory {
+    fn drop(&mut self) {
+        if let Some(pool) = self.pool.take() {
+            let mut mmap_guard = self.mmap.lock().unwrap();
+            let alloc = mem::replace(&mut mmap_guard.alloc, Mmap::new());
+            pool.release(alloc, self.image_mapped.load(Ordering::Relaxed));
+        }
+    }
+}
+
 impl Memory for LinearMemory {
     /// Returns the type for this memory.
     fn ty(&self) -> MemoryType {
@@ -400,4 +642,9 @@ impl Memory for LinearMemory {
         let _mmap_guard = self.mmap.lock().unwrap();
         unsafe { self.get_vm_memory_definition() }
     }
+
+    /// Record that a file-backed image was mapped over this memory's pages.
+    fn mark_image_mapped(&self) {
+        self.image_mapped.store(true, Ordering::Relaxed);
+    }
 }
@@ -0,0 +1,101 @@
+//! Copy-on-write images of initialized linear memory contents.
+//!
+//! A [`MemoryImage`] materializes the data segments of one linear memory into
+//! an anonymous memfd once, when an artifact is loaded. Instantiation then
+//! maps the file `MAP_PRIVATE` over the freshly reserved linear memory, so
+//! initialization costs O(page tables) instead of a memcpy of every data
+//! segment, and writes fault in private pages lazily.
+
+use std::fs::File;
+use std::io;
+use std::os::unix::fs::FileExt;
+use std::os::unix::io::{AsRawFd, FromRawFd};
+use wasmer_types::DataInitializer;
+
+/// The initial contents of one linear memory, backed by a memfd.
+///
+/// The image covers the pages from the start of the memory up to the end of
+/// the highest data segment; pages not covered by any segment read as zero,
+/// exactly like the anonymous mapping they replace.
+///
+/// An image can only be built for a memory whose data segments all have
+/// statically known offsets (no global base), as the contents must not depend
+/// on the instance being created.
+#[derive(Debug)]
+pub struct MemoryImage {
+    /// The memfd holding the initialized contents.
+    file: File,
+    /// The page-aligned length of the image.
+    len: usize,
+}
+
+impl MemoryImage {
+    /// Materialize the given data segments, which must all target the same
+    /// memory and have no dynamic base, into a new image.
+    pub fn new(initializers: &[DataInitializer<'_>]) -> Result<Self, String> {
+        let page_size = region::page::size();
+        let mut len = 0;
+        for init in initializers {
+            debug_assert!(
+                init.location.base.is_none(),
+                "memory images require statically known segment offsets"
+            );
+            len = std::cmp::max(len, init.location.offset + init.data.len());
+        }
+        let len = (len + (page_size - 1)) & !(page_size - 1);
+
+        let fd = unsafe {
+            libc::memfd_create(
+                b"wasmer-memory-image\0".as_ptr() as *const libc::c_char,
+                libc::MFD_CLOEXEC,
+            )
+        };
+        if fd == -1 {
+            return Err(io::Error::last_os_error().to_string());
+        }
+        // SAFETY: `fd` is a freshly created, owned file descriptor.
+        let file = unsafe { File::from_raw_fd(fd) };
+        file.set_len(len as u64).map_err(|e| e.to_string())?;
+        for init in initializers {
+            file.write_all_at(init.data, init.location.offset as u64)
+                .map_err(|e| e.to_string())?;
+        }
+        Ok(Self { file, len })
+    }
+
+    /// The page-aligned length of the image, from the start of the memory.
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Whether the image contains no pages.
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Map the image copy-on-write over the start of a linear memory.
+    ///
+    /// # Safety
+    ///
+    /// `base` must be the page-aligned start of a mapping at least
+    /// [`len`](Self::len) accessible bytes long, and no other code may hold
+    /// references into the replaced range for the duration of the call.
+    pub unsafe fn map_at(&self, base: *mut u8) -> Result<(), String> {
+        if self.len == 0 {
+            return Ok(());
+        }
+        let ptr = libc::mmap(
+            base as *mut libc::c_void,
+            self.len,
+            libc::PROT_READ | libc::PROT_WRITE,
+            libc::MAP_PRIVATE | libc::MAP_FIXED,
+            self.file.as_raw_fd(),
+            0,
+        );
+        if ptr as isize == -1_isize {
+            return Err(io::Error::last_os_error().to_string());
+        }
+        debug_assert_eq!(ptr as *mut u8, base);
+        Ok(())
+    }
+}
@@ -4,9 +4,12 @@
 //! Implement a registry of function signatures, for fast indirect call
 //! signature checking.
 
-use std::collections::{hash_map, HashMap};
+use std::collections::HashMap;
 use std::convert::TryFrom;
-use wasmer_types::{FunctionType, FunctionTypeRef};
+use std::hash::{Hash, Hasher};
+use std::sync::atomic::{AtomicPtr, Ordering};
+use std::sync::{Arc, Mutex};
+use wasmer_types::{FunctionType, FunctionTypeRef, Type};
 
 /// An index into the shared signature registry, usable for checking signatures
 /// at indirect calls.
@@ -21,49 +24,115 @@ impl VMSharedSignatureIndex {
     }
 }
 
+/// The number of shards in the index, enough for the whole `u32` index space.
+const INDEX_SHARDS: usize = 32;
+
 /// WebAssembly requires that the caller and callee signatures in an indirect
 /// call must match. To implement this efficiently, keep a registry of all
 /// signatures, shared by all instances, so that call sites can just do an
 /// index comparison.
+///
+/// The registry is intended to be shared by all the threads that load
+/// modules: `register` interns the signature — allocating a `FunctionType`
+/// only the first time a signature is seen — under an internal lock, while
+/// `lookup` reads the append-only index through atomics and takes no lock at
+/// all, since indices never change once assigned.
 #[derive(Debug)]
 pub struct SignatureRegistry {
-    type_to_index: HashMap<FunctionType, VMSharedSignatureIndex>,
-    index_to_data: Vec<FunctionType>,
+    state: Mutex<Inner>,
+    /// The append-only index, keyed by `VMSharedSignatureIndex`.
+    ///
+    /// Shard `s` holds the `2^s` signatures with indices in
+    /// `[2^s - 1, 2^(s+1) - 1)`, so no entry ever moves as the registry
+    /// grows. Entries point into the types interned in `Inner::type_to_index`
+    /// and are published with a release store once their index is assigned,
+    /// so readers only need an acquire load.
+    shards: [AtomicPtr<AtomicPtr<FunctionType>>; INDEX_SHARDS],
+}
+
+#[derive(Debug, Default)]
+struct Inner {
+    /// The interned signatures and their indices, keyed by the hash of the
+    /// signature so that registering an already-seen signature can query the
+    /// map from a `FunctionTypeRef` without allocating.
+    type_to_index: HashMap<u64, Vec<(Arc<FunctionType>, VMSharedSignatureIndex)>>,
+    /// The number of signatures registered so far.
+    len: usize,
+}
+
+fn hash_signature(params: &[Type], results: &[Type]) -> u64 {
+    let mut hasher = std::collections::hash_map::DefaultHasher::new();
+    params.hash(&mut hasher);
+    results.hash(&mut hasher);
+    hasher.finish()
 }
 
 impl SignatureRegistry {
     /// Create a new `SignatureRegistry`.
     pub fn new() -> Self {
+        const EMPTY_SHARD: AtomicPtr<AtomicPtr<FunctionType>> =
+            AtomicPtr::new(std::ptr::null_mut());
         Self {
-            type_to_index: HashMap::new(),
-            index_to_data: Vec::new(),
+            state: Mutex::new(Inner::default()),
+            shards: [EMPTY_SHARD; INDEX_SHARDS],
         }
     }
 
+    /// The shard an index lives in and its slot within that shard.
+    fn slot_of(index: u32) -> (usize, usize) {
+        let position = u64::from(index) + 1;
+        let shard = (63 - position.leading_zeros()) as usize;
+        (shard, (position - (1u64 << shard)) as usize)
+    }
+
     /// Register a signature and return its unique index.
-    pub fn register(&mut self, sig: FunctionTypeRef<'_>) -> VMSharedSignatureIndex {
-        let len = self.index_to_data.len();
-        // TODO(0-copy): this. should. not. allocate.
-        //
-        // This is pretty hard to avoid, however. In order to implement bijective map, we'd want
-        // a `Rc<FunctionType>`, but indexing into a map keyed by `Rc<FunctionType>` with
-        // `FunctionTypeRef` is… not possible given the current API either.
-        //
-        // Consider `transmute` or `hashbrown`'s raw_entry.
-        let sig = FunctionType::new(sig.params(), sig.results());
-        match self.type_to_index.entry(sig.clone()) {
-            hash_map::Entry::Occupied(entry) => *entry.get(),
-            hash_map::Entry::Vacant(entry) => {
-                debug_assert!(
-                    u32::try_from(len).is_ok(),
-                    "invariant: can't have more than 2³²-1 signatures!"
-                );
-                let sig_id = VMSharedSignatureIndex::new(u32::try_from(len).unwrap());
-                entry.insert(sig_id);
-                self.index_to_data.push(sig);
-                sig_id
-            }
+    pub fn register(&self, sig: FunctionTypeRef<'_>) -> VMSharedSignatureIndex {
+        let hash = hash_signature(sig.params(), sig.results());
+        let mut state = self.state.lock().unwrap();
+        let state = &mut *state;
+        let bucket = state.type_to_index.entry(hash).or_default();
+        let interned = bucket
+            .iter()
+            .find(|(ty, _)| ty.params() == sig.params() && ty.results() == sig.results());
+        if let Some(&(_, index)) = interned {
+            return index;
         }
+        debug_assert!(
+            u32::try_from(state.len).is_ok(),
+            "invariant: can't have more than 2³²-1 signatures!"
+        );
+        let index = VMSharedSignatureIndex::new(u32::try_from(state.len).unwrap());
+        state.len += 1;
+        let ty = Arc::new(FunctionType::new(sig.params(), sig.results()));
+        self.publish(index, &ty);
+        bucket.push((ty, index));
+        index
+    }
+
+    /// Publish a freshly assigned index to the lock-free index.
+    ///
+    /// Must be called with the `state` lock held: registrations are
+    /// serialized by it, so no other thread can be installing a shard or
+    /// storing into a slot concurrently.
+    fn publish(&self, index: VMSharedSignatureIndex, ty: &Arc<FunctionType>) {
+        let (shard, slot) = Self::slot_of(index.0);
+        let mut entries = self.shards[shard].load(Ordering::Acquire);
+        if entries.is_null() {
+            let fresh = (0..1usize << shard)
+                .map(|_| AtomicPtr::new(std::ptr::null_mut()))
+                .collect::<Box<[AtomicPtr<FunctionType>]>>();
+            entries = Box::into_raw(fresh) as *mut AtomicPtr<FunctionType>;
+            self.shards[shard].store(entries, Ordering::Release);
+        }
+        // The slot is what `lookup` synchronizes on; the type it points to is
+        // kept alive by the intern map until the registry is dropped.
+        unsafe { &*entries.add(slot) }
+            .store(Arc::as_ptr(ty) as *mut FunctionType, Ordering::Release);
+    }
+
+    /// The number of distinct signatures registered so far.
+    pub fn len(&self) -> usize {
+        self.state.lock().unwrap().len
     }
 
     /// Looks up a shared signature index within this registry.
@@ -71,6 +140,84 @@ impl SignatureRegistry {
     /// Note that for this operation to be semantically correct the `idx` must
     /// have previously come from a call to `register` of this same object.
     pub fn lookup(&self, idx: VMSharedSignatureIndex) -> Option<&FunctionType> {
-        self.index_to_data.get(idx.0 as usize)
+        let (shard, slot) = Self::slot_of(idx.0);
+        let entries = self.shards.get(shard)?.load(Ordering::Acquire);
+        if entries.is_null() {
+            return None;
+        }
+        let ty = unsafe { &*entries.add(slot) }.load(Ordering::Acquire);
+        if ty.is_null() {
+            return None;
+        }
+        // SAFETY: published slots point into types interned in `state`, which
+        // are neither dropped nor moved for as long as `self` lives.
+        Some(unsafe { &*ty })
+    }
+}
+
+impl Drop for SignatureRegistry {
+    fn drop(&mut self) {
+        for (shard, entries) in self.shards.iter_mut().enumerate() {
+            let entries = *entries.get_mut();
+            if !entries.is_null() {
+                // The types the slots point to are owned by the intern map
+                // and freed with it; only the shard storage goes here.
+                drop(unsafe {
+                    Box::from_raw(std::slice::from_raw_parts_mut(entries, 1 << shard))
+                });
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn register_dedupes_and_lookup_roundtrips() {
+        let registry = SignatureRegistry::new();
+        let i32_to_i32 = FunctionType::new(vec![Type::I32], vec![Type::I32]);
+        let i64_to_none = FunctionType::new(vec![Type::I64], vec![]);
+        let a = registry.register(FunctionTypeRef::from(&i32_to_i32));
+        let b = registry.register(FunctionTypeRef::from(&i64_to_none));
+        assert_ne!(a, b);
+        assert_eq!(a, registry.register(FunctionTypeRef::from(&i32_to_i32)));
+        assert_eq!(registry.lookup(a), Some(&i32_to_i32));
+        assert_eq!(registry.lookup(b), Some(&i64_to_none));
+        assert_eq!(registry.lookup(VMSharedSignatureIndex::new(2)), None);
+        assert_eq!(registry.lookup(VMSharedSignatureIndex::new(u32::MAX)), None);
+    }
+
+    #[test]
+    fn concurrent_registration() {
+        let registry = Arc::new(SignatureRegistry::new());
+        let threads = (0..4)
+            .map(|_| {
+                let registry = Arc::clone(&registry);
+                std::thread::spawn(move || {
+                    (0..100)
+                        .map(|arity| {
+                            let ty = FunctionType::new(vec![Type::I32; arity], vec![]);
+                            registry.register(FunctionTypeRef::from(&ty))
+                        })
+                        .collect::<Vec<_>>()
+                })
+            })
+            .collect::<Vec<_>>();
+        let indices = threads
+            .into_iter()
+            .map(|t| t.join().unwrap())
+            .collect::<Vec<_>>();
+        // Every thread resolved each signature to the same index...
+        for per_thread in &indices[1..] {
+            assert_eq!(&indices[0], per_thread);
+        }
+        // ...and the lock-free read path sees every registration.
+        for (arity, &index) in indices[0].iter().enumerate() {
+            let ty = registry.lookup(index).unwrap();
+            assert_eq!(ty.params().len(), arity);
+            assert_eq!(ty.results(), []);
+        }
     }
 }
@@ -53,6 +53,29 @@ pub trait Table: fmt::Debug + Send + Sync {
     /// Returns an error if the index is out of bounds.
     fn set(&self, index: u32, reference: TableElement) -> Result<(), Trap>;
 
+    /// Fill `self[start..start + funcs.len()]` with the given function
+    /// references.
+    ///
+    /// This behaves like calling [`set`](Self::set) for every entry, but
+    /// implementations can amortize the per-entry synchronization and bounds
+    /// checks across the whole range; it is how element segments are written
+    /// into funcref tables at instantiation.
+    ///
+    /// # Errors
+    ///
+    /// Returns an error if the range is out of bounds. Nothing is written in
+    /// that case.
+    fn init_funcs(&self, start: u32, funcs: &[VMFuncRef]) -> Result<(), Trap> {
+        let len = u32::try_from(funcs.len()).map_err(|_| Trap::lib(TrapCode::TableAccessOutOfBounds))?;
+        if start.checked_add(len).map_or(true, |end| end > self.size()) {
+            return Err(Trap::lib(TrapCode::TableAccessOutOfBounds));
+        }
+        for (i, func_ref) in funcs.iter().enumerate() {
+            self.set(start + i as u32, TableElement::FuncRef(*func_ref))?;
+        }
+        Ok(())
+    }
+
     /// Return a `VMTableDefinition` for exposing the table to compiled wasm code.
     fn vmtable(&self) -> NonNull<VMTableDefinition>;
 
@@ -401,6 +424,32 @@ impl Table for LinearTable {
         }
     }
 
+    /// Fill `self[start..start + funcs.len()]` with the given function
+    /// references, taking the lock and checking the bounds only once for the
+    /// whole range.
+    fn init_funcs(&self, start: u32, funcs: &[VMFuncRef]) -> Result<(), Trap> {
+        // Element segments only ever target funcref tables; writing a funcref
+        // over an externref would leak the latter's refcount.
+        debug_assert_eq!(self.table.ty, ValType::FuncRef);
+        let mut vec_guard = self.vec.lock().unwrap();
+        let vec = vec_guard.borrow_mut();
+        let start = start as usize;
+        match start
+            .checked_add(funcs.len())
+            .and_then(|end| vec.get_mut(start..end))
+        {
+            Some(slots) => {
+                for (slot, func_ref) in slots.iter_mut().zip(funcs) {
+                    *slot = RawTableElement {
+                        func_ref: *func_ref,
+                    };
+                }
+                Ok(())
+            }
+            None => Err(Trap::lib(TrapCode::TableAccessOutOfBounds)),
+        }
+    }
+
     /// Return a `VMTableDefinition` for exposing the table to compiled wasm code.
     fn vmtable(&self) -> NonNull<VMTableDefinition> {
         let _vec_guard = self.vec.lock().unwrap();
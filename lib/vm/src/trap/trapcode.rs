@@ -69,6 +69,9 @@ pub enum TrapCode {
 
     /// Hit the gas limit.
     GasExceeded = 12,
+
+    /// The shared epoch counter passed the execution deadline.
+    DeadlineExceeded = 13,
 }
 
 impl TrapCode {
@@ -88,6 +91,7 @@ impl TrapCode {
             Self::UnreachableCodeReached => "unreachable",
             Self::UnalignedAtomic => "unaligned atomic access",
             Self::GasExceeded => "gas limit exceeded",
+            Self::DeadlineExceeded => "execution deadline exceeded",
         }
     }
 }
@@ -108,6 +112,7 @@ impl Display for TrapCode {
             Self::UnreachableCodeReached => "unreachable",
             Self::UnalignedAtomic => "unalign_atom",
             Self::GasExceeded => "out_of_gas",
+            Self::DeadlineExceeded => "deadline",
         };
         f.write_str(identifier)
     }
@@ -130,6 +135,7 @@ impl FromStr for TrapCode {
             "bad_toint" => Ok(Self::BadConversionToInteger),
             "unreachable" => Ok(Self::UnreachableCodeReached),
             "unalign_atom" => Ok(Self::UnalignedAtomic),
+            "deadline" => Ok(Self::DeadlineExceeded),
             _ => Err(()),
         }
     }
@@ -140,7 +146,7 @@ mod tests {
     use super::*;
 
     // Everything but user-defined codes.
-    const CODES: [TrapCode; 12] = [
+    const CODES: [TrapCode; 13] = [
         TrapCode::StackOverflow,
         TrapCode::HeapAccessOutOfBounds,
         TrapCode::HeapMisaligned,
@@ -153,6 +159,7 @@ mod tests {
         TrapCode::BadConversionToInteger,
         TrapCode::UnreachableCodeReached,
         TrapCode::UnalignedAtomic,
+        TrapCode::DeadlineExceeded,
     ];
 
     #[test]
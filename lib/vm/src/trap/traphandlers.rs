@@ -209,6 +209,95 @@ where
     Ok(global_results.assume_init())
 }
 
+/// Runs `closure` within an established trap-handling scope, so that every
+/// call into wasm made through the provided [`CallScope`] skips the per-call
+/// setup.
+///
+/// [`wasmer_call_trampoline`] pays for a fresh `CallThreadState`, a
+/// thread-local swap and a `setjmp` on every invocation. A host that calls
+/// back into wasm many times in a row can instead enter a scope once and make
+/// every call through [`CallScope::call_trampoline`], paying the full setup
+/// only on entry of the nesting level.
+///
+/// # Safety
+///
+/// Soundness must not depend on `closure` destructors being run: when a call
+/// made through the scope traps, the closure is abandoned at the trapping
+/// call and this function returns the trap, skipping any destructors the
+/// closure has on the stack at that point.
+pub unsafe fn wasmer_call_scope<F, R>(mut closure: F) -> Result<R, Trap>
+where
+    F: FnMut(&CallScope<'_>) -> R,
+{
+    let mut result = MaybeUninit::<R>::uninit();
+    return CallThreadState::new()
+        .with(|cx| {
+            let mut payload = ScopePayload::<F, R> {
+                state: cx,
+                closure: &mut closure,
+                result: &mut result,
+            };
+            wasmer_register_setjmp(
+                cx.jmp_buf.as_ptr(),
+                call_scope_closure::<F, R>,
+                &mut payload as *mut ScopePayload<F, R> as *mut u8,
+            )
+        })
+        .map(|()| result.assume_init());
+
+    struct ScopePayload<'a, F, R> {
+        state: *const CallThreadState,
+        closure: &'a mut F,
+        result: &'a mut MaybeUninit<R>,
+    }
+
+    extern "C" fn call_scope_closure<F, R>(payload: *mut u8)
+    where
+        F: FnMut(&CallScope<'_>) -> R,
+    {
+        unsafe {
+            let payload = &mut *(payload as *mut ScopePayload<F, R>);
+            let scope = CallScope {
+                _state: &*payload.state,
+            };
+            payload.result.as_mut_ptr().write((payload.closure)(&scope));
+        }
+    }
+}
+
+/// A trap-handling scope established by [`wasmer_call_scope`].
+///
+/// The `CallThreadState`, its thread-local registration and its `setjmp`
+/// context stay alive for the whole scope, so calls made through
+/// [`Self::call_trampoline`] need no per-call setup.
+pub struct CallScope<'a> {
+    _state: &'a CallThreadState,
+}
+
+impl CallScope<'_> {
+    /// Call the VM function pointed to by `callee`, without the per-call
+    /// trap-handling setup of [`wasmer_call_trampoline`].
+    ///
+    /// The arguments are those of [`wasmer_call_trampoline`].
+    ///
+    /// # Safety
+    ///
+    /// As for [`wasmer_call_trampoline`]. Additionally, if the call traps,
+    /// control returns directly from [`wasmer_call_scope`] with the trap;
+    /// see the safety requirements there.
+    pub unsafe fn call_trampoline(
+        &self,
+        callee_env: VMFunctionEnvironment,
+        trampoline: VMTrampoline,
+        callee: *const VMFunctionBody,
+        values_vec: *mut u8,
+    ) {
+        mem::transmute::<_, extern "C" fn(VMFunctionEnvironment, *const VMFunctionBody, *mut u8)>(
+            trampoline,
+        )(callee_env, callee, values_vec)
+    }
+}
+
 /// Temporary state stored on the stack which is registered in the `tls` module
 /// below for calls into wasm.
 pub struct CallThreadState {
@@ -426,3 +515,40 @@ extern "C" fn signal_less_trap_handler(pc: *const u8, trap: TrapCode) {
 pub fn get_trap_handler() -> *const u8 {
     signal_less_trap_handler as *const u8
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn call_scope_returns_closure_result() {
+        let result: Result<u32, Trap> = unsafe { wasmer_call_scope(|_scope| 42) };
+        assert_eq!(result.unwrap(), 42);
+    }
+
+    #[test]
+    fn call_scope_catches_trap() {
+        // No destructors on the closure's stack, as the safety contract of
+        // `wasmer_call_scope` requires.
+        let result: Result<u32, Trap> =
+            unsafe { wasmer_call_scope(|_scope| raise_lib_trap(Trap::lib(TrapCode::BadSignature))) };
+        match result {
+            Err(Trap::Lib { trap_code, .. }) => assert_eq!(trap_code, TrapCode::BadSignature),
+            _ => panic!("expected a library trap"),
+        }
+    }
+
+    #[test]
+    fn call_scopes_nest() {
+        let result: Result<u32, Trap> = unsafe {
+            wasmer_call_scope(|_outer| {
+                let inner: Result<u32, Trap> = wasmer_call_scope(|_inner| {
+                    raise_lib_trap(Trap::lib(TrapCode::UnreachableCodeReached))
+                });
+                assert!(inner.is_err());
+                7
+            })
+        };
+        assert_eq!(result.unwrap(), 7);
+    }
+}
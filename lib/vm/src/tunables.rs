@@ -8,7 +8,10 @@ use wasmer_types::{MemoryType, TableType};
 
 /// An engine delegates the creation of memories, tables, and globals
 /// to a foreign implementor of this trait.
-pub trait Tunables {
+///
+/// Tunables are consulted from whichever thread compiles or instantiates a
+/// module, so implementations must be thread-safe.
+pub trait Tunables: Send + Sync {
     /// Construct a `MemoryStyle` for the provided `MemoryType`
     fn memory_style(&self, memory: &MemoryType) -> MemoryStyle;
 
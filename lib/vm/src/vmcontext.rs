@@ -1141,3 +1141,13 @@ impl std::ops::Deref for SectionBodyPtr {
         &self.0
     }
 }
+
+// SAFETY: No data is read or written through this pointer by safe code; the
+// unsafe users dereferencing it are responsible for synchronizing access to
+// the section body. This is essentially a usize.
+unsafe impl Send for SectionBodyPtr {}
+
+/// SAFETY: No data is read or written through this pointer by safe code; the
+/// unsafe users dereferencing it are responsible for synchronizing access to
+/// the section body. This is essentially a usize.
+unsafe impl Sync for SectionBodyPtr {}
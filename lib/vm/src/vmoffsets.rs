@@ -512,13 +512,25 @@ impl VMOffsets {
         self.vmctx_stack_limit_begin().checked_add(4).unwrap()
     }
 
+    /// The offset of the epoch counter pointer.
+    pub fn vmctx_epoch_counter_pointer(&self) -> u32 {
+        // The two 4-byte stack limits preceding this leave the offset aligned
+        // for a pointer.
+        self.vmctx_stack_limit_initial_begin().checked_add(4).unwrap()
+    }
+
+    /// The offset of the epoch deadline.
+    pub fn vmctx_epoch_deadline_begin(&self) -> u32 {
+        self.vmctx_epoch_counter_pointer()
+            .checked_add(u32::from(self.pointer_size))
+            .unwrap()
+    }
+
     /// Return the size of the [`VMContext`] allocation.
     ///
     /// [`VMContext`]: crate::vmcontext::VMContext
     pub fn size_of_vmctx(&self) -> u32 {
-        self.vmctx_stack_limit_initial_begin()
-            .checked_add(4)
-            .unwrap()
+        self.vmctx_epoch_deadline_begin().checked_add(8).unwrap()
     }
 
     /// Return the offset to [`VMSharedSignatureIndex`] index `index`.
@@ -66,6 +66,309 @@ fn write_perf_profiler_map(functions: &Vec<NamedFunction>) -> Result<(), Box<dyn
 }
 */
 
+#[test]
+#[cfg(target_arch = "x86_64")]
+fn lazy_compilation() {
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (func $double (param i32) (result i32)
+           (i32.mul (local.get 0) (i32.const 2)))
+       (func (export "main") (param i32) (result i32)
+           (i32.add (call $double (call $host (local.get 0))) (i32.const 1))))"#;
+    let compiler = Singlepass::default();
+    let engine = Universal::new(compiler).lazy_compilation(true).engine();
+    let store = Store::new(&engine);
+    let module = Module::new(&store, wat).unwrap();
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x + 1) },
+    };
+    let instance = Instance::new(&module, &import_object).unwrap();
+    let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+    // The first call compiles both local functions through their stubs, the
+    // second one takes the already-resolved fast path.
+    assert_eq!(main.call(20).unwrap(), 43);
+    assert_eq!(main.call(-2).unwrap(), -1);
+}
+
+#[test]
+#[cfg(target_arch = "x86_64")]
+fn tier_up() {
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (func $double (param i32) (result i32)
+           (i32.mul (local.get 0) (i32.const 2)))
+       (func (export "main") (param i32) (result i32)
+           (i32.add (call $double (call $host (local.get 0))) (i32.const 1))))"#;
+    let engine = Universal::new(Singlepass::default())
+        .tier_up(Singlepass::default(), 10)
+        .engine();
+    let store = Store::new(&engine);
+    let module = Module::new(&store, wat).unwrap();
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x + 1) },
+    };
+    let instance = Instance::new(&module, &import_object).unwrap();
+    let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+    for i in 0..100 {
+        assert_eq!(main.call(i).unwrap(), (i + 1) * 2 + 1);
+    }
+    // Give the monitor time to recompile the now-hot functions and swap their
+    // bodies, then check that calls keep producing correct results.
+    std::thread::sleep(std::time::Duration::from_millis(100));
+    for i in 0..100 {
+        assert_eq!(main.call(i).unwrap(), (i + 1) * 2 + 1);
+    }
+}
+
+#[test]
+#[cfg(target_os = "linux")]
+fn cow_memory_initialization() {
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (memory 1)
+       (data (i32.const 16) "\01\02\03\04")
+       (func (export "read") (param i32) (result i32)
+           (i32.add (i32.load8_u (local.get 0)) (call $host (i32.const 0))))
+       (func (export "write") (param i32 i32)
+           (i32.store8 (local.get 0) (local.get 1))))"#;
+    let engine = Universal::new(Singlepass::default()).engine();
+    let store = Store::new(&engine);
+    let module = Module::new(&store, wat).unwrap();
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x) },
+    };
+    let a = Instance::new(&module, &import_object).unwrap();
+    let b = Instance::new(&module, &import_object).unwrap();
+    let read_a: NativeFunc<i32, i32> = a.get_native_function("read").unwrap();
+    let read_b: NativeFunc<i32, i32> = b.get_native_function("read").unwrap();
+    let write_a: NativeFunc<(i32, i32), ()> = a.get_native_function("write").unwrap();
+    // Both instances see the data segment, and bytes outside it read as zero.
+    assert_eq!(read_a.call(16).unwrap(), 1);
+    assert_eq!(read_a.call(19).unwrap(), 4);
+    assert_eq!(read_a.call(20).unwrap(), 0);
+    assert_eq!(read_b.call(17).unwrap(), 2);
+    // Writes fault in private pages: the other instance is unaffected.
+    write_a.call(16, 9).unwrap();
+    assert_eq!(read_a.call(16).unwrap(), 9);
+    assert_eq!(read_b.call(16).unwrap(), 1);
+}
+
+#[test]
+fn truncated_function_body() {
+    // A module whose only function body is a `nop` with no terminating
+    // `end`. The fused validator only sees operators as the compiler pulls
+    // them, so the compiler must report the truncation as a validation
+    // error rather than running the operator reader dry.
+    let wasm = [
+        0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, // header
+        0x01, 0x04, 0x01, 0x60, 0x00, 0x00, // type section: () -> ()
+        0x03, 0x02, 0x01, 0x00, // function section: one function of type 0
+        0x0a, 0x04, 0x01, 0x02, 0x00, 0x01, // code section: no locals, `nop`, no `end`
+    ];
+    let engine = Universal::new(Singlepass::default()).engine();
+    let store = Store::new(&engine);
+    let error = Module::new(&store, &wasm[..]).unwrap_err();
+    assert!(
+        matches!(error, CompileError::Validate(_)),
+        "expected a validation error, got: {}",
+        error
+    );
+}
+
+#[test]
+fn instance_pooling() {
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (memory 1)
+       (func (export "main") (param i32) (result i32)
+           (i32.add (call $host (local.get 0)) (i32.const 1))))"#;
+    let engine = Universal::new(Singlepass::default())
+        .instance_pool(2)
+        .engine();
+    let store = Store::new(&engine);
+    let module = Module::new(&store, wat).unwrap();
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x + 1) },
+    };
+    // Repeatedly instantiate the same module: slots are reused as instances
+    // are dropped, and instantiation keeps working past the pool capacity.
+    for i in 0..10 {
+        let instance = Instance::new(&module, &import_object).unwrap();
+        let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+        assert_eq!(main.call(i).unwrap(), i + 2);
+    }
+    // Also exercise the global-allocator fallback by keeping more instances
+    // live than the pool has slots.
+    let instances = (0..5)
+        .map(|_| Instance::new(&module, &import_object).unwrap())
+        .collect::<Vec<_>>();
+    for (i, instance) in instances.iter().enumerate() {
+        let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+        assert_eq!(main.call(i as i32).unwrap(), i as i32 + 2);
+    }
+}
+
+#[test]
+#[cfg(not(target_os = "windows"))]
+fn pooled_memory_tunables() {
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (memory 1 4)
+       (data (i32.const 8) "\2a")
+       (func (export "main") (param i32) (result i32)
+           (i32.add (i32.load8_u (call $host (local.get 0))) (i32.const 1))))"#;
+    let engine = Universal::new(Singlepass::default()).engine();
+    let tunables = PooledMemoryTunables::for_target(engine.target(), 2).unwrap();
+    let store = Store::new_with_tunables(&engine, tunables);
+    let module = Module::new(&store, wat).unwrap();
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x + 8) },
+    };
+    // Instantiate more times than the pool has reservations: dropped
+    // instances return theirs, and the pool hands out zeroed memory again.
+    for _ in 0..10 {
+        let instance = Instance::new(&module, &import_object).unwrap();
+        let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+        assert_eq!(main.call(0).unwrap(), 43);
+        assert_eq!(main.call(100).unwrap(), 1);
+    }
+    // A module without data segments drawing a reservation from the same
+    // pool must see zeroes, even where the previous module's copy-on-write
+    // memory image covered the reservation.
+    let empty_wat = r#"(module
+       (memory 1 4)
+       (func (export "read") (param i32) (result i32)
+           (i32.load8_u (local.get 0))))"#;
+    let module = Module::new(&store, empty_wat).unwrap();
+    let instance = Instance::new(&module, &imports! {}).unwrap();
+    let read: NativeFunc<i32, i32> = instance.get_native_function("read").unwrap();
+    assert_eq!(read.call(8).unwrap(), 0);
+}
+
+#[test]
+#[cfg(unix)]
+fn execute_in_place() {
+    use std::io::Write;
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (memory 1)
+       (data (i32.const 8) "\05")
+       (func $double (param i32) (result i32)
+           (i32.mul (local.get 0) (i32.const 2)))
+       (func (export "main") (param i32) (result i32)
+           (i32.add (call $double (call $host (local.get 0)))
+                    (i32.load8_u (i32.const 8)))))"#;
+    let wasm = wat2wasm(wat.as_bytes()).unwrap();
+    let engine = Universal::new(Singlepass::default()).engine();
+    let store = Store::new(&engine);
+    let executable = engine.compile_universal(&wasm, store.tunables()).unwrap();
+    let serialized = executable.serialize_xip().unwrap();
+    let mut file = tempfile::tempfile().unwrap();
+    file.write_all(&serialized).unwrap();
+    // The code runs directly out of the (copy-on-write) file mapping: cross
+    // function calls, trampolines and reads from data sections all work.
+    // SAFETY: the file was just serialized by this very engine.
+    let artifact = unsafe { engine.load_universal_executable_file(&file) }.unwrap();
+    let module = Module::from_artifact(&store, std::sync::Arc::new(artifact));
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x + 1) },
+    };
+    let instance = Instance::new(&module, &import_object).unwrap();
+    let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+    assert_eq!(main.call(20).unwrap(), 47);
+    assert_eq!(main.call(-3).unwrap(), 1);
+}
+
+#[test]
+fn compile_cache() {
+    let wat = r#"(module
+       (func (export "main") (param i32) (result i32)
+           (i32.add (local.get 0) (i32.const 2))))"#;
+    let dir = tempfile::tempdir().unwrap();
+    let run = |engine: &wasmer_engine_universal::UniversalEngine| {
+        let store = Store::new(engine);
+        let module = Module::new(&store, wat).unwrap();
+        let instance = Instance::new(&module, &imports! {}).unwrap();
+        let main: NativeFunc<i32, i32> = instance.get_native_function("main").unwrap();
+        assert_eq!(main.call(20).unwrap(), 22);
+    };
+    let entries = || {
+        std::fs::read_dir(dir.path())
+            .unwrap()
+            .map(|e| e.unwrap().file_name().into_string().unwrap())
+            .collect::<Vec<_>>()
+    };
+
+    let engine = Universal::new(Singlepass::default())
+        .compile_cache(dir.path())
+        .engine();
+    run(&engine);
+    let first = entries();
+    assert_eq!(first.len(), 1);
+    assert!(first[0].ends_with(".wasmu"), "{:?}", first);
+
+    // On unix the entry is stored in the execute-in-place format, so cache
+    // hits in sibling processes attach the file mapping and share its pages
+    // rather than copying the code out.
+    #[cfg(unix)]
+    {
+        let bytes = std::fs::read(dir.path().join(&first[0])).unwrap();
+        assert!(bytes.starts_with(b"\0wasmer-xip"), "{:?}", &bytes[..16]);
+    }
+
+    // A fresh engine sharing the directory serves the module straight from
+    // the cache entry, and the cached module behaves identically.
+    let engine = Universal::new(Singlepass::default())
+        .compile_cache(dir.path())
+        .engine();
+    run(&engine);
+    assert_eq!(entries(), first);
+
+    // A differently configured compiler generates different code, so it must
+    // miss and populate its own entry rather than load the first engine's.
+    let mut config = Singlepass::default();
+    config.epoch_interruption(true);
+    let engine = Universal::new(config).compile_cache(dir.path()).engine();
+    run(&engine);
+    assert_eq!(entries().len(), 2);
+}
+
+#[test]
+fn concurrent_module_loading() {
+    let engine = Universal::new(Singlepass::default()).engine();
+    let store = Store::new(&engine);
+    // Compile, load and run modules from several threads through one shared
+    // engine: loads don't serialize on an engine-wide lock, and the shared
+    // registries hand out consistent indices.
+    let threads = (0..8i32)
+        .map(|t| {
+            let store = store.clone();
+            std::thread::spawn(move || {
+                let wat = format!(
+                    r#"(module
+                       (func $host (import "env" "host") (param i32) (result i32))
+                       (func (export "main") (param i32) (result i32)
+                           (i32.add (call $host (local.get 0)) (i32.const {}))))"#,
+                    t
+                );
+                for i in 0..8 {
+                    let module = Module::new(&store, wat.as_str()).unwrap();
+                    let import_object = imports! {
+                        "env" => { "host" => Function::new_native(&store, |x: i32| x + 1) },
+                    };
+                    let instance = Instance::new(&module, &import_object).unwrap();
+                    let main: NativeFunc<i32, i32> =
+                        instance.get_native_function("main").unwrap();
+                    assert_eq!(main.call(i).unwrap(), i + 1 + t);
+                }
+            })
+        })
+        .collect::<Vec<_>>();
+    for thread in threads {
+        thread.join().unwrap();
+    }
+}
+
 #[test]
 fn profiling() {
     let wat = r#"
@@ -106,3 +409,76 @@ fn profiling() {
         }
     }
 }
+
+#[test]
+fn simd_arithmetic() {
+    // Exercises the v128 subset implemented by singlepass: constants, splats,
+    // lane accesses, shuffles, the bitwise/arithmetic ALU ops and v128 locals
+    // spanning loads and stores.
+    let wat = r#"(module
+       (func $host (import "env" "host") (param i32) (result i32))
+       (memory 1)
+       (func (export "main") (result i32)
+           (local $v v128)
+           (local $acc i32)
+           (local.set $v (i32x4.add (i32x4.splat (i32.const 10))
+                                    (v128.const i32x4 1 2 3 4)))
+           (local.set $acc (i32x4.extract_lane 0 (local.get $v)))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32x4.extract_lane 3 (local.get $v))))
+           (v128.store (i32.const 16) (local.get $v))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32x4.extract_lane 1 (v128.load (i32.const 16)))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i8x16.extract_lane_u 0 (i8x16.add_sat_u
+                   (i8x16.splat (i32.const 200)) (i8x16.splat (i32.const 100))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i16x8.extract_lane_s 2 (i16x8.mul
+                   (i16x8.splat (i32.const 7)) (i16x8.splat (i32.const 9))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i8x16.extract_lane_u 0
+                   (i8x16.shuffle 16 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15
+                       (v128.const i8x16 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0)
+                       (v128.const i8x16 42 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0)))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i8x16.extract_lane_u 0 (i8x16.swizzle
+                   (v128.const i8x16 5 6 7 8 0 0 0 0 0 0 0 0 0 0 0 0)
+                   (v128.const i8x16 1 255 0 0 0 0 0 0 0 0 0 0 0 0 0 0)))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32.trunc_f32_s (f32x4.extract_lane 1 (f32x4.mul
+                   (f32x4.add (f32x4.splat (f32.const 2)) (f32x4.splat (f32.const 3)))
+                   (f32x4.splat (f32.const 4)))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32.trunc_f64_s (f64x2.extract_lane 1
+                   (f64x2.sqrt (f64x2.splat (f64.const 81)))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32.wrap_i64 (i64x2.extract_lane 0 (i64x2.add
+                   (i64x2.splat (i64.const 40)) (i64x2.splat (i64.const 2)))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32x4.extract_lane 2
+                   (i32x4.replace_lane 2 (local.get $v) (i32.const 100)))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32x4.extract_lane 0 (i32x4.max_s
+                   (i32x4.splat (i32.const -5)) (i32x4.splat (i32.const 3))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32x4.extract_lane 0 (i32x4.neg (i32x4.splat (i32.const -25))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i8x16.extract_lane_u 0 (v128.andnot
+                   (i8x16.splat (i32.const 255)) (i8x16.splat (i32.const 15))))))
+           (local.set $acc (i32.add (local.get $acc)
+               (i32x4.extract_lane 0 (v128.bitselect
+                   (i32x4.splat (i32.const 1)) (i32x4.splat (i32.const 2))
+                   (v128.const i64x2 -1 -1)))))
+           (call $host (local.get $acc))))"#;
+    let engine = Universal::new(Singlepass::default()).engine();
+    let store = Store::new(&engine);
+    let module = Module::new(&store, wat).unwrap();
+    let import_object = imports! {
+        "env" => { "host" => Function::new_native(&store, |x: i32| x + 1) },
+    };
+    let instance = Instance::new(&module, &import_object).unwrap();
+    let main: NativeFunc<(), i32> = instance.get_native_function("main").unwrap();
+    // 11 + 14 + 12 + 255 + 63 + 42 + 6 + 20 + 9 + 42 + 100 + 3 + 25 + 240 + 1,
+    // plus one from the host function.
+    assert_eq!(main.call().unwrap(), 844);
+}
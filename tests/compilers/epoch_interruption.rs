@@ -0,0 +1,93 @@
+use std::sync::atomic::AtomicU64;
+use std::sync::atomic::Ordering::SeqCst;
+use std::sync::Arc;
+use wasmer::*;
+use wasmer_compiler_singlepass::Singlepass;
+use wasmer_engine_universal::Universal;
+use wasmer_types::InstanceConfig;
+
+fn epoch_store() -> Store {
+    let mut compiler = Singlepass::default();
+    compiler.epoch_interruption(true);
+    Store::new(&Universal::new(compiler).engine())
+}
+
+fn instantiate_with_epoch(
+    store: &Store,
+    wat: &str,
+    epoch: &Arc<AtomicU64>,
+    deadline: u64,
+) -> Instance {
+    let module = Module::new(store, wat).unwrap();
+    Instance::new_with_config(
+        &module,
+        unsafe {
+            InstanceConfig::default().with_epoch(epoch.as_ptr() as *const u64, deadline)
+        },
+        &imports! {},
+    )
+    .unwrap()
+}
+
+#[test]
+fn epoch_deadline_interrupts_loop() {
+    let wat = r#"(module
+        (func (export "main")
+            (loop br 0)))"#;
+    let store = epoch_store();
+    let epoch = Arc::new(AtomicU64::new(0));
+    let instance = instantiate_with_epoch(&store, wat, &epoch, 1);
+    let main = instance.lookup_function("main").unwrap();
+
+    // Bump the epoch past the deadline from a timer thread, the way a host
+    // would bound the runtime of a job.
+    let timer = {
+        let epoch = epoch.clone();
+        std::thread::spawn(move || {
+            std::thread::sleep(std::time::Duration::from_millis(50));
+            epoch.fetch_add(1, SeqCst);
+        })
+    };
+    let err = main.call(&[]).unwrap_err();
+    assert_eq!(err.message(), "execution deadline exceeded");
+    timer.join().unwrap();
+}
+
+#[test]
+fn epoch_deadline_interrupts_calls() {
+    // Runaway recursion crosses the deadline at a call site without ever
+    // executing a loop back-edge.
+    let wat = r#"(module
+        (func $f (call $f))
+        (func (export "main") (call $f)))"#;
+    let store = epoch_store();
+    let epoch = Arc::new(AtomicU64::new(1));
+    let instance = instantiate_with_epoch(&store, wat, &epoch, 1);
+    let main = instance.lookup_function("main").unwrap();
+    let err = main.call(&[]).unwrap_err();
+    assert_eq!(err.message(), "execution deadline exceeded");
+}
+
+#[test]
+fn epoch_deadline_ahead_does_not_interrupt() {
+    let wat = r#"(module
+        (func $id (param i32) (result i32) (local.get 0))
+        (func (export "main") (result i32) (local i32)
+            (local.set 0 (i32.const 10))
+            (loop $l
+                (local.set 0 (i32.sub (local.get 0) (i32.const 1)))
+                (br_if $l (i32.ne (local.get 0) (i32.const 0))))
+            (call $id (i32.const 42))))"#;
+    let store = epoch_store();
+    let epoch = Arc::new(AtomicU64::new(0));
+    let instance = instantiate_with_epoch(&store, wat, &epoch, 1);
+    let main = instance.lookup_function("main").unwrap();
+    assert_eq!(main.call(&[]).unwrap()[0], Val::I32(42));
+
+    // The default configuration points at an epoch that never advances, so
+    // epoch-compiled code without an explicit deadline runs unbounded.
+    let module = Module::new(&store, wat).unwrap();
+    let instance = Instance::new(&module, &imports! {}).unwrap();
+    let main = instance.lookup_function("main").unwrap();
+    assert_eq!(main.call(&[]).unwrap()[0], Val::I32(42));
+}
@@ -98,6 +98,13 @@ fn get_store() -> Store {
     store
 }
 
+fn get_store_consolidated() -> Store {
+    let mut compiler = Singlepass::default();
+    compiler.consolidate_gas_charges(true);
+    let store = Store::new(&Universal::new(compiler).engine());
+    store
+}
+
 #[test]
 fn test_gas_intrinsic_in_start() {
     let store = get_store();
@@ -236,6 +243,74 @@ fn test_gas_intrinsic_default() {
     assert_eq!(HITS.load(SeqCst), 5);
 }
 
+#[test]
+fn test_gas_intrinsic_consolidated() {
+    let store = get_store_consolidated();
+    let wat = r#"
+        (import "host" "func" (func))
+        (import "host" "gas" (func (param i32)))
+        (func (export "foo")
+            i32.const 10
+            call 1
+            i32.const 20
+            call 1
+            call 0
+            i32.const 30
+            call 1
+        )
+        (func (export "zoo")
+            i32.const 7
+            call 1
+            loop
+                i32.const 100
+                call 1
+                i32.const 1
+                call 1
+                br 0
+            end
+        )
+    "#;
+    let module = Module::new(&store, &wat).unwrap();
+    let mut gas_counter = FastGasCounter::new(1_000_000, 3);
+    static HITS: AtomicUsize = AtomicUsize::new(0);
+    let instance = Instance::new_with_config(
+        &module,
+        unsafe { InstanceConfig::default().with_counter(ptr::addr_of_mut!(gas_counter)) },
+        &imports! {
+            "host" => {
+                "func" => Function::new(&store, FunctionType::new(vec![], vec![]), |_values| {
+                    HITS.fetch_add(1, SeqCst);
+                    Ok(vec![])
+                }),
+                "gas" => Function::new(&store, FunctionType::new(vec![ValType::I32], vec![]), |_| {
+                    // It shall be never called, as call is intrinsified.
+                    assert!(false);
+                    Ok(vec![])
+                }),
+            },
+        },
+    )
+    .unwrap();
+    let foo_func = instance
+        .lookup_function("foo")
+        .expect("expected function foo");
+    let zoo_func = instance
+        .lookup_function("zoo")
+        .expect("expected function zoo");
+    let e = foo_func.call(&[]);
+    assert!(e.is_ok());
+    // Ensure "func" was called.
+    assert_eq!(HITS.load(SeqCst), 1);
+    // The consolidated charges must add up to the individual ones.
+    assert_eq!(gas_counter.burnt(), 180);
+    // Exhaust the limit in a loop. Each iteration charges its two gas calls
+    // in one go, and the charge before the loop must not be folded into the
+    // loop body.
+    gas_counter.gas_limit = 180 + (7 + 101 * 7) * 3 - 1;
+    let _e = zoo_func.call(&[]).err().expect("error calling function");
+    assert_eq!(gas_counter.burnt(), 180 + (7 + 101 * 7) * 3);
+}
+
 #[test]
 fn test_gas_intrinsic_tricky() {
     let store = get_store();
@@ -6,6 +6,7 @@ extern crate compiler_test_derive;
 
 mod config;
 mod deterministic;
+mod epoch_interruption;
 mod fast_gas_metering;
 mod imports;
 mod issues;
@@ -80,6 +80,38 @@ fn native_function_works_for_wasm(config: crate::Config) -> anyhow::Result<()> {
     Ok(())
 }
 
+#[compiler_test(native_functions)]
+fn call_with_results_into_works(config: crate::Config) -> anyhow::Result<()> {
+    let store = config.store();
+    let wat = r#"(module
+        (func (export "add") (param i32 i32) (result i32)
+           (i32.add (local.get 0)
+                    (local.get 1)))
+)"#;
+    let module = Module::new(&store, wat).unwrap();
+    let instance = Instance::new(&module, &imports! {})?;
+
+    {
+        let f: Function = instance.lookup_function("add").expect("lookup function");
+        let mut results = [Val::null()];
+        f.call_with_results_into(&[Val::I32(4), Val::I32(6)], &mut results)?;
+        assert_eq!(results[0], Val::I32(10));
+    }
+
+    {
+        let f = Function::new(
+            &store,
+            FunctionType::new(vec![ValType::I32], vec![ValType::I32]),
+            |values| Ok(vec![Value::I32(values[0].unwrap_i32() + 1)]),
+        );
+        let mut results = [Val::null()];
+        f.call_with_results_into(&[Val::I32(41)], &mut results)?;
+        assert_eq!(results[0], Val::I32(42));
+    }
+
+    Ok(())
+}
+
 #[should_panic(
     expected = "Closures (functions with captured environments) are currently unsupported with native functions. See: https://github.com/wasmerio/wasmer/issues/1840"
 )]
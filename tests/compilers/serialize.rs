@@ -22,6 +22,29 @@ fn test_serialize(config: crate::Config) -> Result<()> {
     Ok(())
 }
 
+#[compiler_test(serialize)]
+fn test_serialize_to_matches_serialize(config: crate::Config) -> Result<()> {
+    let store = config.store();
+    let wasm = wat2wasm(
+        r#"
+        (module
+        (func $hello (import "" "hello"))
+        (func (export "run") (call $hello))
+        )
+    "#
+        .as_bytes(),
+    )
+    .unwrap();
+    let engine = store.engine();
+    let tunables = BaseTunables::for_target(engine.target());
+    let executable = engine.compile(&wasm, &tunables).unwrap();
+    let serialized = executable.serialize().unwrap();
+    let mut streamed = Vec::new();
+    executable.serialize_to(&mut streamed).unwrap();
+    assert_eq!(serialized, streamed);
+    Ok(())
+}
+
 // #[compiler_test(serialize)]
 // fn test_deserialize(config: crate::Config) -> Result<()> {
 //     let store = config.store();
@@ -58,6 +58,10 @@ pub fn run_wast(mut config: crate::Config, wast_path: &str) -> anyhow::Result<()
         wast.allow_instantiation_failures(&[
             "Validation error: invalid result arity: func type returns multiple values",
             "Validation error: blocks, loops, and ifs accept no parameters when multi-value is not enabled",
+            // Validation is fused into the translation, so translation can
+            // report an unsupported construct before the validator reaches
+            // the type error a directive actually asserts on.
+            "Unsupported feature: unsupported table element type: ExternRef",
         ]);
     }
     wast.fail_fast = false;